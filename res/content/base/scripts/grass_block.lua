@@ -1,9 +1,11 @@
-function on_random_update(x, y, z)
-    local dirtid = block.index('base:dirt');
+local function update(x, y, z, dirtid, grassblockid)
+    -- position may be changed since it was sampled
+    if block.get(x, y, z) ~= grassblockid then
+        return
+    end
     if block.is_solid_at(x, y+1, z) then
         block.set(x, y, z, dirtid, 0)
     else
-        local grassblockid = block.index('base:grass_block')
         for lx=-1,1 do
             for ly=-1,1 do
                 for lz=-1,1 do
@@ -18,3 +20,11 @@ function on_random_update(x, y, z)
         end
     end
 end
+
+function on_random_updates(positions)
+    local dirtid = block.index('base:dirt')
+    local grassblockid = block.index('base:grass_block')
+    for i=1,#positions,3 do
+        update(positions[i], positions[i+1], positions[i+2], dirtid, grassblockid)
+    end
+end
@@ -0,0 +1,26 @@
+#ifndef TILING_GLSL_
+#define TILING_GLSL_
+
+// Sample block texture. Faces merged by greedy meshing repeat the atlas
+// region starting at origin (uv of the provoking vertex) with tileSize,
+// tileSize is zero for regular faces. Used by shaders compiled with
+// GREEDY_MESHING only
+vec4 tiled_texture(sampler2D tex, vec2 coord, vec2 origin, vec2 tileSize) {
+    if (tileSize.x == 0.0) {
+        return texture(tex, coord);
+    }
+    vec2 texSize = vec2(textureSize(tex, 0));
+    // region size is a whole number of texels
+    vec2 size = round(tileSize * texSize) / texSize;
+    vec2 halfTexel = 0.5 / texSize;
+    vec2 uv = clamp(
+        origin + fract((coord - origin) / size) * size,
+        origin + halfTexel,
+        origin + size - halfTexel
+    );
+    // derivatives of the continuous coordinates prevent seams at tile
+    // borders with mipmapping
+    return textureGrad(tex, uv, dFdx(coord), dFdy(coord));
+}
+
+#endif // TILING_GLSL_
@@ -6,6 +6,7 @@
 
 #include "rle.hpp"
 #include "gzip.hpp"
+#include "lz4.hpp"
 #include "util/BufferPool.hpp"
 
 using namespace compression;
@@ -27,13 +28,13 @@ static std::shared_ptr<ubyte[]> get_buffer(size_t minSize) {
     return nullptr;
 }
 
-static auto compress_rle(
+static auto compress_buffered(
     const ubyte* src,
     size_t srclen,
     size_t& len,
+    size_t bufferSize,
     size_t(*encodefunc)(const ubyte*, size_t, ubyte*)
 ) {
-    size_t bufferSize = srclen * 2;
     auto buffer = get_buffer(bufferSize);
     auto bytes = buffer.get();
     std::unique_ptr<ubyte[]> uptr;
@@ -62,9 +63,17 @@ std::unique_ptr<ubyte[]> compression::compress(
         case Method::NONE:
             throw std::invalid_argument("compression method is NONE");
         case Method::EXTRLE8:
-            return compress_rle(src, srclen, len, extrle::encode);
+            return compress_buffered(
+                src, srclen, len, srclen * 2, extrle::encode
+            );
         case Method::EXTRLE16:
-            return compress_rle(src, srclen, len, extrle::encode16);
+            return compress_buffered(
+                src, srclen, len, srclen * 2, extrle::encode16
+            );
+        case Method::LZ4:
+            return compress_buffered(
+                src, srclen, len, lz4::compress_bound(srclen), lz4::encode
+            );
         case Method::GZIP: {
             auto buffer = gzip::compress(src, srclen);
             auto data = std::make_unique<ubyte[]>(buffer.size());
@@ -109,6 +118,16 @@ std::unique_ptr<ubyte[]> compression::decompress(
             std::memcpy(decompressed.get(), buffer.data(), buffer.size());
             return decompressed;
         }
+        case Method::LZ4: {
+            auto decompressed = std::make_unique<ubyte[]>(dstlen);
+            size_t decoded = lz4::decode(src, srclen, decompressed.get(), dstlen);
+            if (decoded != dstlen) {
+                throw std::runtime_error(
+                    "expected decompressed size " + std::to_string(dstlen) +
+                    " got " + std::to_string(decoded));
+            }
+            return decompressed;
+        }
         default:
             throw std::runtime_error("not implemented");
     }
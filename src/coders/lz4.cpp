@@ -0,0 +1,175 @@
+#include "lz4.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+inline constexpr uint MIN_MATCH = 4;
+/// @brief Last literals count required by the format
+inline constexpr size_t LAST_LITERALS = 5;
+/// @brief Min distance from the match start to the end of the input
+inline constexpr size_t MATCH_GUARD = 12;
+inline constexpr uint MAX_OFFSET = 0xFFFF;
+inline constexpr uint HASH_BITS = 14;
+
+static inline uint32_t read32(const ubyte* ptr) {
+    uint32_t value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static inline uint hash32(uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static inline ubyte* write_length(ubyte* dst, size_t length) {
+    while (length >= 255) {
+        *dst++ = 255;
+        length -= 255;
+    }
+    *dst++ = static_cast<ubyte>(length);
+    return dst;
+}
+
+static inline ubyte* write_sequence(
+    ubyte* dst,
+    const ubyte* literals,
+    size_t literalsLength,
+    size_t matchLength,
+    uint offset
+) {
+    ubyte* token = dst++;
+    *token = (literalsLength >= 15 ? 15 : literalsLength) << 4;
+    if (literalsLength >= 15) {
+        dst = write_length(dst, literalsLength - 15);
+    }
+    if (literalsLength) {
+        std::memcpy(dst, literals, literalsLength);
+        dst += literalsLength;
+    }
+    if (matchLength == 0) {
+        return dst;
+    }
+    *dst++ = offset & 0xFF;
+    *dst++ = offset >> 8;
+
+    matchLength -= MIN_MATCH;
+    *token |= matchLength >= 15 ? 15 : matchLength;
+    if (matchLength >= 15) {
+        dst = write_length(dst, matchLength - 15);
+    }
+    return dst;
+}
+
+size_t lz4::encode(const ubyte* src, size_t length, ubyte* dst) {
+    const ubyte* const start = dst;
+    const ubyte* anchor = src;
+    if (length > MATCH_GUARD) {
+        // positions are stored relative to src
+        uint32_t table[1 << HASH_BITS] {};
+        const ubyte* const matchLimit = src + length - LAST_LITERALS;
+        const ubyte* const searchLimit = src + length - MATCH_GUARD;
+
+        // position 0 is never used as a reference, so 0 means empty
+        const ubyte* ip = src + 1;
+        while (ip < searchLimit) {
+            uint32_t sequence = read32(ip);
+            uint h = hash32(sequence);
+            const ubyte* ref = src + table[h];
+            table[h] = ip - src;
+            if (ref == src || ip - ref > MAX_OFFSET ||
+                read32(ref) != sequence) {
+                ip++;
+                continue;
+            }
+            // extend match backwards
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            const ubyte* matchEnd = ip + MIN_MATCH;
+            const ubyte* refEnd = ref + MIN_MATCH;
+            while (matchEnd < matchLimit && *matchEnd == *refEnd) {
+                matchEnd++;
+                refEnd++;
+            }
+            dst = write_sequence(
+                dst, anchor, ip - anchor, matchEnd - ip, ip - ref
+            );
+            ip = anchor = matchEnd;
+            if (ip - 2 > src && ip < searchLimit) {
+                table[hash32(read32(ip - 2))] = ip - 2 - src;
+            }
+        }
+    }
+    dst = write_sequence(dst, anchor, src + length - anchor, 0, 0);
+    return dst - start;
+}
+
+size_t lz4::decode(
+    const ubyte* src, size_t length, ubyte* dst, size_t capacity
+) {
+    const ubyte* const srcEnd = src + length;
+    ubyte* const dstStart = dst;
+    ubyte* const dstEnd = dst + capacity;
+
+    auto read_length = [&](size_t value) {
+        if (value != 15) {
+            return value;
+        }
+        ubyte byte;
+        do {
+            if (src >= srcEnd) {
+                throw std::runtime_error("lz4: unexpected end of data");
+            }
+            byte = *src++;
+            value += byte;
+        } while (byte == 255);
+        return value;
+    };
+
+    while (src < srcEnd) {
+        ubyte token = *src++;
+        size_t literalsLength = read_length(token >> 4);
+        if (literalsLength > static_cast<size_t>(srcEnd - src) ||
+            literalsLength > static_cast<size_t>(dstEnd - dst)) {
+            throw std::runtime_error("lz4: literals out of bounds");
+        }
+        std::memcpy(dst, src, literalsLength);
+        src += literalsLength;
+        dst += literalsLength;
+        if (src == srcEnd) {
+            break;
+        }
+        if (srcEnd - src < 2) {
+            throw std::runtime_error("lz4: unexpected end of data");
+        }
+        size_t offset = src[0] | (src[1] << 8);
+        src += 2;
+        if (offset == 0 || offset > static_cast<size_t>(dst - dstStart)) {
+            throw std::runtime_error("lz4: invalid match offset");
+        }
+        size_t matchLength = read_length(token & 0xF) + MIN_MATCH;
+        if (matchLength > static_cast<size_t>(dstEnd - dst)) {
+            throw std::runtime_error("lz4: match out of bounds");
+        }
+        const ubyte* ref = dst - offset;
+        if (offset >= matchLength) {
+            std::memcpy(dst, ref, matchLength);
+            dst += matchLength;
+        } else {
+            // overlapping match repeats the pattern, so the copied part
+            // doubles every step
+            ubyte* const matchEnd = dst + matchLength;
+            while (dst < matchEnd) {
+                size_t count = std::min(
+                    static_cast<size_t>(dst - ref),
+                    static_cast<size_t>(matchEnd - dst)
+                );
+                std::memcpy(dst, ref, count);
+                dst += count;
+            }
+        }
+    }
+    return dst - dstStart;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "typedefs.hpp"
+
+/// @brief LZ4 block format codec (no frame headers and checksums)
+namespace lz4 {
+    /// @brief Get max compressed data size
+    /// @param length source data length
+    constexpr size_t compress_bound(size_t length) {
+        return length + length / 255 + 16;
+    }
+
+    /// @brief Compress bytes array
+    /// @param src source bytes array
+    /// @param length source bytes array length
+    /// @param dst destination buffer (at least compress_bound(length) bytes)
+    /// @return compressed data length
+    size_t encode(const ubyte* src, size_t length, ubyte* dst);
+
+    /// @brief Decompress bytes array
+    /// @param src compressed data
+    /// @param length compressed data length
+    /// @param dst destination buffer
+    /// @param capacity destination buffer size
+    /// @return decompressed data length
+    /// @throws std::runtime_error if data is malformed or does not fit
+    size_t decode(const ubyte* src, size_t length, ubyte* dst, size_t capacity);
+}
@@ -17,7 +17,7 @@ inline constexpr bool ENGINE_DEBUG_BUILD = true;
 inline const std::string ENGINE_VERSION_STRING = "0.30";
 
 /// @brief world regions format version
-inline constexpr uint REGION_FORMAT_VERSION = 3;
+inline constexpr uint REGION_FORMAT_VERSION = 4;
 
 /// @brief max simultaneously open world region files
 inline constexpr uint MAX_OPEN_REGION_FILES = 32;
@@ -44,6 +44,13 @@ inline constexpr float CHUNKS_MAP_MAX_LOAD_FACTOR = 0.1f;
 /// @brief chunk volume (count of voxels per Chunk)
 inline constexpr int CHUNK_VOL = (CHUNK_W * CHUNK_H * CHUNK_D);
 
+/// @brief chunk section height
+inline constexpr int CHUNK_SECTION_H = 16;
+/// @brief number of sections in chunk
+inline constexpr int CHUNK_SECTIONS = CHUNK_H / CHUNK_SECTION_H;
+/// @brief section volume (count of voxels per chunk section)
+inline constexpr int CHUNK_SECTION_VOL = CHUNK_W * CHUNK_SECTION_H * CHUNK_D;
+
 /// @brief block id used to mark non-existing voxel (voxel of missing chunk)
 inline constexpr blockid_t BLOCK_VOID = std::numeric_limits<blockid_t>::max();
 /// @brief item id used to mark non-existing item (error)
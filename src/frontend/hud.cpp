@@ -276,7 +276,12 @@ void Hud::updateWorldGenDebug() {
     uint padding = engine.getSettings().chunks.padding.get();
     auto generator =
         frontend.getController()->getChunksController()->getGenerator();
-    auto debugInfo = generator->createDebugInfo();
+    const auto& position = player.getPosition();
+    auto debugInfo = generator->createDebugInfo(
+        floordiv<CHUNK_W>(glm::floor(position.x)),
+        floordiv<CHUNK_D>(glm::floor(position.z)),
+        engine.getSettings().chunks.loadDistance.get()
+    );
     
     int width = debugImgWorldGen->getWidth();
     int height = debugImgWorldGen->getHeight();
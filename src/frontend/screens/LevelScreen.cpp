@@ -82,6 +82,7 @@ LevelScreen::LevelScreen(
     };
     keepAlive(settings.graphics.backlight.observe(resetChunks));
     keepAlive(settings.graphics.softLighting.observe(resetChunks));
+    keepAlive(settings.graphics.greedyMeshing.observe(resetChunks));
     keepAlive(settings.graphics.denseRender.observe([=](bool flag) {
         resetChunks(flag);
         frontend->getContentGfxCache().refresh();
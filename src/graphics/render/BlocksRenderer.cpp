@@ -1,5 +1,7 @@
 #include "BlocksRenderer.hpp"
 
+#include <algorithm>
+
 #include "graphics/core/Mesh.hpp"
 #include "graphics/commons/Model.hpp"
 #include "maths/UVRegion.hpp"
@@ -12,6 +14,48 @@
 const glm::vec3 BlocksRenderer::SUN_VECTOR(0.528265, 0.833149, -0.163704);
 const float DIRECTIONAL_LIGHT_FACTOR = 0.3f;
 
+/// @brief Face corners order used by face methods: {-X-Y, +X-Y, +X+Y, -X+Y}
+static constexpr int FACE_CORNERS[4][2] {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+static std::array<uint8_t, 4> pack_color(const glm::vec4& light) {
+    return {
+        static_cast<uint8_t>(light.r * 255),
+        static_cast<uint8_t>(light.g * 255),
+        static_cast<uint8_t>(light.b * 255),
+        static_cast<uint8_t>(light.a * 255)};
+}
+
+static uint16_t to_unorm16(float value) {
+    return static_cast<uint16_t>(
+        std::round(glm::clamp(value, 0.0f, 1.0f) * 0xFFFF)
+    );
+}
+
+/// @return face {X, Y, Z} axes of the cube side (texture face)
+static std::array<glm::ivec3, 3> cube_side_axes(
+    int side, const glm::ivec3& X, const glm::ivec3& Y, const glm::ivec3& Z
+) {
+    switch (side) {
+        case FACE_MX: return {Z, Y, -X};
+        case FACE_PX: return {-Z, Y, X};
+        case FACE_MY: return {X, Z, -Y};
+        case FACE_PY: return {X, -Z, Y};
+        case FACE_MZ: return {-X, Y, -Z};
+        default: return {X, Y, Z};
+    }
+}
+
+/// @return world direction index of the axis-aligned normal:
+/// {-X, +X, -Y, +Y, -Z, +Z}
+static int direction_index(const glm::ivec3& normal) {
+    if (normal.x) {
+        return normal.x > 0;
+    } else if (normal.y) {
+        return 2 + (normal.y > 0);
+    }
+    return 4 + (normal.z > 0);
+}
+
 BlocksRenderer::BlocksRenderer(
     size_t capacity,
     const Content& content,
@@ -32,6 +76,11 @@ BlocksRenderer::BlocksRenderer(
         CHUNK_W + voxelBufferPadding*2,
         CHUNK_H,
         CHUNK_D + voxelBufferPadding*2);
+    greedyFaces = std::make_unique<GreedyFace[]>(6 * CHUNK_SECTION_VOL);
+    // mask row bits are voxels along X
+    static_assert(CHUNK_W + 4 <= 32);
+    cullingMask = std::make_unique<uint32_t[]>(voxelsBuffer->getD() * CHUNK_H);
+    lightMask = std::make_unique<uint32_t[]>(voxelsBuffer->getD() * CHUNK_H);
     blockDefsCache = content.getIndices()->blocks.getDefs();
 }
 
@@ -55,10 +104,10 @@ void BlocksRenderer::vertex(
     vertexBuffer[vertexCount].normal[2] = static_cast<uint8_t>(normal.b * 127 + 128);
     vertexBuffer[vertexCount].normal[3] = static_cast<uint8_t>(emission * 255);
 
-    vertexBuffer[vertexCount].color[0] = static_cast<uint8_t>(light.r * 255);
-    vertexBuffer[vertexCount].color[1] = static_cast<uint8_t>(light.g * 255);
-    vertexBuffer[vertexCount].color[2] = static_cast<uint8_t>(light.b * 255);
-    vertexBuffer[vertexCount].color[3] = static_cast<uint8_t>(light.a * 255);
+    vertexBuffer[vertexCount].color = pack_color(light);
+    if (greedyMeshing) {
+        tileSizes[vertexCount] = {};
+    }
 
     vertexCount++;
 }
@@ -383,59 +432,355 @@ void BlocksRenderer::blockCube(
         Z = orient.axes[2];
     }
 
+    bool masked = isMaskCulled(variant);
+    uint8_t open = masked ? openFaces(coord) : 0;
+    if (masked && open == 0) {
+        return;
+    }
+    auto isFaceOpen = [&](const glm::ivec3& dir) {
+        if (masked) {
+            return (open >> direction_index(dir) & 1) != 0;
+        }
+        return isOpen(coord + dir, block, variant);
+    };
     if (ao) {
-        if (isOpen(coord + Z, block, variant)) {
+        if (isFaceOpen(Z)) {
             faceAO(coord, X, Y, Z, texfaces[5], lights);
         }
-        if (isOpen(coord - Z, block, variant)) {
+        if (isFaceOpen(-Z)) {
             faceAO(coord, -X, Y, -Z, texfaces[4], lights);
         }
-        if (isOpen(coord + Y, block, variant)) {
+        if (isFaceOpen(Y)) {
             faceAO(coord, X, -Z, Y, texfaces[3], lights);
         }
-        if (isOpen(coord - Y, block, variant)) {
+        if (isFaceOpen(-Y)) {
             faceAO(coord, X, Z, -Y, texfaces[2], lights);
         }
-        if (isOpen(coord + X, block, variant)) {
+        if (isFaceOpen(X)) {
             faceAO(coord, -Z, Y, X, texfaces[1], lights);
         }
-        if (isOpen(coord - X, block, variant)) {
+        if (isFaceOpen(-X)) {
             faceAO(coord, Z, Y, -X, texfaces[0], lights);
         }
     } else {
-        if (isOpen(coord + Z, block, variant)) {
+        if (isFaceOpen(Z)) {
             face(coord, X, Y, Z, texfaces[5], pickLight(coord + Z), lights);
         }
-        if (isOpen(coord - Z, block, variant)) {
+        if (isFaceOpen(-Z)) {
             face(coord, -X, Y, -Z, texfaces[4], pickLight(coord - Z), lights);
         }
-        if (isOpen(coord + Y, block, variant)) {
+        if (isFaceOpen(Y)) {
             face(coord, X, -Z, Y, texfaces[3], pickLight(coord + Y), lights);
         }
-        if (isOpen(coord - Y, block, variant)) {
+        if (isFaceOpen(-Y)) {
             face(coord, X, Z, -Y, texfaces[2], pickLight(coord - Y), lights);
         }
-        if (isOpen(coord + X, block, variant)) {
+        if (isFaceOpen(X)) {
             face(coord, -Z, Y, X, texfaces[1], pickLight(coord + X), lights);
         }
-        if (isOpen(coord - X, block, variant)) {
+        if (isFaceOpen(-X)) {
             face(coord, Z, Y, -X, texfaces[0], pickLight(coord - X), lights);
         }
     }
 }
 
+void BlocksRenderer::blockCubeGreedy(
+    const glm::ivec3& coord,
+    const Block& block,
+    blockstate states,
+    bool lights,
+    bool ao
+) {
+    int section = coord.y / CHUNK_SECTION_H;
+    if (section != greedySection) {
+        flushGreedyFaces();
+        greedySection = section;
+    }
+    const auto& variant = block.getVariantByBits(states.userbits);
+    glm::ivec3 X(1, 0, 0);
+    glm::ivec3 Y(0, 1, 0);
+    glm::ivec3 Z(0, 0, 1);
+
+    if (block.rotatable) {
+        auto& orient = block.rotations.variants[states.rotation];
+        X = orient.axes[0];
+        Y = orient.axes[1];
+        Z = orient.axes[2];
+    }
+    bool masked = isMaskCulled(variant);
+    uint8_t open = masked ? openFaces(coord) : 0;
+    if (masked && open == 0) {
+        return;
+    }
+    uint32_t key = static_cast<uint32_t>(block.rt.id) << 16 |
+                   blockstate2int(states);
+    for (int side = FACE_PZ; side >= 0; side--) {
+        auto axes = cube_side_axes(side, X, Y, Z);
+        if (masked ? (open >> direction_index(axes[2]) & 1)
+                   : isOpen(coord + axes[2], block, variant)) {
+            cubeFaceGreedy(
+                coord,
+                axes[0],
+                axes[1],
+                axes[2],
+                side,
+                key,
+                lights,
+                ao
+            );
+        }
+    }
+}
+
+void BlocksRenderer::cubeFaceGreedy(
+    const glm::ivec3& coord,
+    const glm::ivec3& X,
+    const glm::ivec3& Y,
+    const glm::ivec3& Z,
+    int side,
+    uint32_t key,
+    bool lights,
+    bool ao
+) {
+    // lights are calculated the same way as faceAO and face do
+    glm::vec3 fX(X);
+    glm::vec3 fY(Y);
+    glm::vec3 fZ(Z);
+    float d = glm::dot(fZ, SUN_VECTOR);
+    d = (1.0f - DIRECTIONAL_LIGHT_FACTOR) + d * DIRECTIONAL_LIGHT_FACTOR;
+
+    GreedyFace face {key, {}, static_cast<uint8_t>(side)};
+    if (ao && lights) {
+        glm::vec4 tint(d);
+        for (int i = 0; i < 4; i++) {
+            auto pos = glm::vec3(coord) +
+                       (fX * static_cast<float>(FACE_CORNERS[i][0]) +
+                        fY * static_cast<float>(FACE_CORNERS[i][1]) + fZ) *
+                           0.5f +
+                       fZ * 0.5f + (fX + fY) * 0.5f;
+            face.colors[i] = pack_color(
+                pickSoftLight(
+                    glm::ivec3(
+                        std::round(pos.x), std::round(pos.y), std::round(pos.z)
+                    ),
+                    X,
+                    Y
+                ) *
+                tint
+            );
+        }
+    } else {
+        glm::vec4 tint(1.0f);
+        if (!ao) {
+            tint = pickLight(coord + Z);
+            if (lights) {
+                tint *= d;
+            }
+        }
+        face.colors.fill(pack_color(tint));
+    }
+    // light interpolated over merged faces stays the same if it does not
+    // change along the merging axis
+    const auto& colors = face.colors;
+    bool uniformX = colors[0] == colors[1] && colors[3] == colors[2];
+    bool uniformY = colors[0] == colors[3] && colors[1] == colors[2];
+    int axis = direction_index(Z) / 2;
+    bool axisUIsX = X[(axis + 1) % 3] != 0;
+    face.mergeU = axisUIsX ? uniformX : uniformY;
+    face.mergeV = axisUIsX ? uniformY : uniformX;
+
+    int index = vox_index(
+        coord.x, coord.y - greedySection * CHUNK_SECTION_H, coord.z
+    );
+    greedyFaces[direction_index(Z) * CHUNK_SECTION_VOL + index] = face;
+}
+
+void BlocksRenderer::flushGreedyFaces() {
+    if (greedySection == -1) {
+        return;
+    }
+    if (overflow) {
+        std::fill_n(greedyFaces.get(), 6 * CHUNK_SECTION_VOL, GreedyFace {});
+        greedySection = -1;
+        return;
+    }
+    const int sizes[3] {CHUNK_W, CHUNK_SECTION_H, CHUNK_D};
+    for (int direction = 0; direction < 6; direction++) {
+        GreedyFace* faces = greedyFaces.get() + direction * CHUNK_SECTION_VOL;
+        // depth axis and two axes of the faces plane
+        int axis = direction / 2;
+        int axisU = (axis + 1) % 3;
+        int axisV = (axis + 2) % 3;
+        glm::ivec3 pos;
+        auto cell = [&](int u, int v) -> GreedyFace& {
+            glm::ivec3 p = pos;
+            p[axisU] += u;
+            p[axisV] += v;
+            return faces[vox_index(p.x, p.y, p.z)];
+        };
+        for (pos[axis] = 0; pos[axis] < sizes[axis]; pos[axis]++) {
+            for (pos[axisV] = 0; pos[axisV] < sizes[axisV]; pos[axisV]++) {
+                for (pos[axisU] = 0; pos[axisU] < sizes[axisU]; pos[axisU]++) {
+                    if (cell(0, 0).key == 0) {
+                        continue;
+                    }
+                    const GreedyFace face = cell(0, 0);
+                    int width = 1;
+                    while (face.mergeU && pos[axisU] + width < sizes[axisU] &&
+                           cell(width, 0) == face) {
+                        width++;
+                    }
+                    int height = 1;
+                    for (; face.mergeV && pos[axisV] + height < sizes[axisV];
+                         height++) {
+                        bool matches = true;
+                        for (int u = 0; u < width && matches; u++) {
+                            matches = cell(u, height) == face;
+                        }
+                        if (!matches) {
+                            break;
+                        }
+                    }
+                    for (int v = 0; v < height; v++) {
+                        for (int u = 0; u < width; u++) {
+                            cell(u, v).key = 0;
+                        }
+                    }
+                    glm::ivec3 max = pos;
+                    max[axisU] += width - 1;
+                    max[axisV] += height - 1;
+                    greedyQuad(face, pos, max);
+                }
+            }
+        }
+    }
+    greedySection = -1;
+    if (overflow) {
+        std::fill_n(greedyFaces.get(), 6 * CHUNK_SECTION_VOL, GreedyFace {});
+    }
+}
+
+void BlocksRenderer::greedyQuad(
+    const GreedyFace& face,
+    const glm::ivec3& localMin,
+    const glm::ivec3& localMax
+) {
+    if (vertexCount + 4 >= capacity) {
+        overflow = true;
+        return;
+    }
+    blockid_t id = face.key >> 16;
+    blockstate state = int2blockstate(face.key & 0xFFFF);
+    const auto& def = *blockDefsCache[id];
+    const auto& region = cache.getRegion(
+        id, def.getVariantIndex(state.userbits), face.side, densePass
+    );
+    glm::ivec3 X(1, 0, 0);
+    glm::ivec3 Y(0, 1, 0);
+    glm::ivec3 Z(0, 0, 1);
+    if (def.rotatable) {
+        auto& orient = def.rotations.variants[state.rotation];
+        X = orient.axes[0];
+        Y = orient.axes[1];
+        Z = orient.axes[2];
+    }
+    auto axes = cube_side_axes(face.side, X, Y, Z);
+    glm::ivec3 offset(0, greedySection * CHUNK_SECTION_H, 0);
+    glm::ivec3 min = localMin + offset;
+    glm::ivec3 max = localMax + offset;
+
+    // plane axes of the face texture
+    int axisX = axes[0].x ? 0 : (axes[0].y ? 1 : 2);
+    int axisY = axes[1].x ? 0 : (axes[1].y ? 1 : 2);
+    int tilesX = max[axisX] - min[axisX] + 1;
+    int tilesY = max[axisY] - min[axisY] + 1;
+    bool tiled = tilesX > 1 || tilesY > 1;
+
+    glm::vec3 fX(axes[0]);
+    glm::vec3 fY(axes[1]);
+    glm::vec3 fZ(axes[2]);
+    float emission = def.shadeless ? 1.0f : 0.0f;
+    std::array<uint16_t, 2> tileSize {};
+    if (tiled) {
+        tileSize = {
+            to_unorm16(region.u2 - region.u1), to_unorm16(region.v2 - region.v1)
+        };
+    }
+    for (int i = 0; i < 4; i++) {
+        int sx = FACE_CORNERS[i][0];
+        int sy = FACE_CORNERS[i][1];
+        glm::ivec3 coord = min;
+        coord[axisX] = sx * axes[0][axisX] > 0 ? max[axisX] : min[axisX];
+        coord[axisY] = sy * axes[1][axisY] > 0 ? max[axisY] : min[axisY];
+        glm::vec3 pos = glm::vec3(coord) + (fX * static_cast<float>(sx) +
+                                            fY * static_cast<float>(sy) +
+                                            fZ) * 0.5f;
+        float u = region.u1;
+        float v = region.v1;
+        if (sx > 0) {
+            u = tilesX > 1 ? u + (region.u2 - region.u1) * tilesX : region.u2;
+        }
+        if (sy > 0) {
+            v = tilesY > 1 ? v + (region.v2 - region.v1) * tilesY : region.v2;
+        }
+        vertex(pos, u, v, glm::vec4(), fZ, emission);
+        vertexBuffer[vertexCount - 1].color = face.colors[i];
+        tileSizes[vertexCount - 1] = tileSize;
+    }
+    if (tiled) {
+        // the first corner is the provoking vertex of both triangles,
+        // its uv is the region origin
+        index(1, 2, 0, 2, 3, 0);
+    } else {
+        index(0, 1, 2, 0, 2, 3);
+    }
+}
+
+void BlocksRenderer::buildMasks(int y0, int y1) {
+    const int w = voxelsBuffer->getW();
+    const int d = voxelsBuffer->getD();
+    const voxel* voxels = voxelsBuffer->getVoxels();
+    for (int y = y0; y < y1; y++) {
+        for (int z = 0; z < d; z++) {
+            int rowIndex = y * d + z;
+            const voxel* row = voxels + rowIndex * w;
+            uint32_t culling = 0;
+            uint32_t light = 0;
+            for (int x = 0; x < w; x++) {
+                const voxel& vox = row[x];
+                if (vox.id == BLOCK_VOID) {
+                    culling |= 1U << x;
+                    continue;
+                }
+                const auto& def = *blockDefsCache[vox.id];
+                const auto& variant = def.getVariantByBits(vox.state.userbits);
+                culling |= static_cast<uint32_t>(
+                    vox.id && variant.rt.solid && variant.drawGroup == 0
+                ) << x;
+                light |= static_cast<uint32_t>(
+                    def.lightPassing || vox.id == 0
+                ) << x;
+            }
+            cullingMask[rowIndex] = culling;
+            lightMask[rowIndex] = light;
+        }
+    }
+    maskBottom = y0;
+    maskTop = y1;
+}
+
 bool BlocksRenderer::isOpenForLight(int x, int y, int z) const {
-    blockid_t id = voxelsBuffer->pickBlockId(chunk->x * CHUNK_W + x,
-                                             y,
-                                             chunk->z * CHUNK_D + z);
-    if (id == BLOCK_VOID) {
+    // voxels out of loaded rows are treated as voxels out of the buffer
+    if (y < maskBottom || y >= maskTop) {
         return false;
     }
-    const Block& block = *blockDefsCache[id];
-    if (block.lightPassing) {
-        return true;
+    int bx = x + voxelBufferPadding;
+    int bz = z + voxelBufferPadding;
+    if (bx < 0 || bx >= voxelsBuffer->getW() || bz < 0 ||
+        bz >= voxelsBuffer->getD()) {
+        return false;
     }
-    return !id;
+    return lightMask[y * voxelsBuffer->getD() + bz] >> bx & 1;
 }
 
 glm::vec4 BlocksRenderer::pickLight(int x, int y, int z) const {
@@ -487,6 +832,10 @@ void BlocksRenderer::render(
         }
         int end = beginEnds[drawGroup][1];
         for (int i = begin-1; i <= end; i++) {
+            if (chunk->isSectionEmpty(i / CHUNK_SECTION_VOL)) {
+                i |= CHUNK_SECTION_VOL - 1; // skip to the next section
+                continue;
+            }
             const voxel& vox = voxels[i];
             blockid_t id = vox.id;
             blockstate state = vox.state;
@@ -515,8 +864,18 @@ void BlocksRenderer::render(
             int z = (i / CHUNK_D) % CHUNK_W;
             switch (def.getModel(state.userbits).type) {
                 case BlockModelType::BLOCK:
-                    blockCube({x, y, z}, texfaces, def, vox.state, !def.shadeless,
-                              def.ambientOcclusion && enableAO);
+                    if (greedyMeshing) {
+                        blockCubeGreedy(
+                            {x, y, z},
+                            def,
+                            vox.state,
+                            !def.shadeless,
+                            def.ambientOcclusion && enableAO
+                        );
+                    } else {
+                        blockCube({x, y, z}, texfaces, def, vox.state, !def.shadeless,
+                                  def.ambientOcclusion && enableAO);
+                    }
                     break;
                 case BlockModelType::XSPRITE: {
                     if (!denseRender)
@@ -545,9 +904,11 @@ void BlocksRenderer::render(
                     break;
             }
             if (overflow) {
+                flushGreedyFaces();
                 return;
             }
         }
+        flushGreedyFaces();
     }
 }
 
@@ -569,6 +930,10 @@ SortingMeshData BlocksRenderer::renderTranslucent(
         }
         int end = beginEnds[drawGroup][1];
         for (int i = begin-1; i <= end; i++) {
+            if (chunk->isSectionEmpty(i / CHUNK_SECTION_VOL)) {
+                i |= CHUNK_SECTION_VOL - 1; // skip to the next section
+                continue;
+            }
             const voxel& vox = voxels[i];
             blockid_t id = vox.id;
             blockstate state = vox.state;
@@ -687,37 +1052,100 @@ SortingMeshData BlocksRenderer::renderTranslucent(
     return sortingMesh;
 }
 
-void BlocksRenderer::build(const Chunk* chunk, const Chunks* chunks) {
+bool BlocksRenderer::loadVoxels(
+    const Chunk* chunk, const Chunks* chunks, int y0, int y1
+) {
     this->chunk = chunk;
+    greedyMeshing = settings.graphics.greedyMeshing.get();
+    if (greedyMeshing && tileSizes == nullptr) {
+        tileSizes = std::make_unique<std::array<uint16_t, 2>[]>(capacity);
+    }
+    if (chunks->getChunk(chunk->x, chunk->z) == nullptr) {
+        cancelled = true;
+        return false;
+    }
+    cancelled = false;
+
+    // only rows of blocks in the range and vertical padding are loaded,
+    // the same way as horizontal padding covers neighbours of blocks and
+    // corners picked by soft lighting
+    int minY = std::max(0, std::max(chunk->bottom, y0) - voxelBufferPadding);
+    int maxY = std::min(CHUNK_H, std::min(chunk->top, y1) + voxelBufferPadding);
+    if (minY >= maxY) {
+        maskBottom = maskTop = 0;
+        return true;
+    }
     voxelsBuffer->setPosition(
         chunk->x * CHUNK_W - voxelBufferPadding, 0,
         chunk->z * CHUNK_D - voxelBufferPadding);
-    chunks->getVoxels(*voxelsBuffer, settings.graphics.backlight.get());
+    chunks->getVoxels(
+        *voxelsBuffer, settings.graphics.backlight.get(), minY, maxY
+    );
+    buildMasks(minY, maxY);
+    return true;
+}
 
-    if (voxelsBuffer->pickBlockId(
-        chunk->x * CHUNK_W, 0, chunk->z * CHUNK_D
-    ) == BLOCK_VOID) {
-        cancelled = true;
-        return;
+void BlocksRenderer::build(const Chunk* chunk, const Chunks* chunks) {
+    if (loadVoxels(chunk, chunks, 0, CHUNK_H)) {
+        buildRange(0, CHUNK_H);
+    }
+}
+
+ChunkSectionsMeshData BlocksRenderer::buildSections(
+    const Chunk* chunk, const Chunks* chunks, uint16_t sections
+) {
+    ChunkSectionsMeshData data;
+    if (sections == 0) {
+        return data;
+    }
+    int lower = 0;
+    while (!(sections >> lower & 1)) {
+        lower++;
+    }
+    int upper = CHUNK_SECTIONS - 1;
+    while (!(sections >> upper & 1)) {
+        upper--;
+    }
+    if (!loadVoxels(
+            chunk,
+            chunks,
+            lower * CHUNK_SECTION_H,
+            (upper + 1) * CHUNK_SECTION_H
+        )) {
+        return data;
+    }
+    data.sections = sections;
+    for (int s = lower; s <= upper; s++) {
+        if (sections >> s & 1) {
+            buildRange(s * CHUNK_SECTION_H, (s + 1) * CHUNK_SECTION_H);
+            data.meshes[s] = createMesh();
+        }
     }
+    return data;
+}
+
+void BlocksRenderer::buildRange(int y0, int y1) {
     const voxel* voxels = chunk->voxels;
 
-    int totalBegin = chunk->bottom * (CHUNK_W * CHUNK_D);
-    int totalEnd = chunk->top * (CHUNK_W * CHUNK_D);
+    int totalBegin = std::max(chunk->bottom, y0) * (CHUNK_W * CHUNK_D);
+    int totalEnd = std::min(chunk->top, y1) * (CHUNK_W * CHUNK_D);
 
     int beginEnds[256][2] {};
-    for (int i = totalBegin; i < totalEnd; i++) {
-        const voxel& vox = voxels[i];
-        blockid_t id = vox.id;
-        const auto& def = *blockDefsCache[id];
-        const auto& variant = def.getVariantByBits(vox.state.userbits);
-
-        if (beginEnds[variant.drawGroup][0] == 0) {
-            beginEnds[variant.drawGroup][0] = i+1;
+    chunk->forEachSection([&](int s) {
+        int begin = std::max(totalBegin, s * CHUNK_SECTION_VOL);
+        int end = std::min(totalEnd, (s + 1) * CHUNK_SECTION_VOL);
+        for (int i = begin; i < end; i++) {
+            const voxel& vox = voxels[i];
+            blockid_t id = vox.id;
+            const auto& def = *blockDefsCache[id];
+            const auto& variant = def.getVariantByBits(vox.state.userbits);
+
+            if (beginEnds[variant.drawGroup][0] == 0) {
+                beginEnds[variant.drawGroup][0] = i+1;
+            }
+            beginEnds[variant.drawGroup][1] = i;
         }
-        beginEnds[variant.drawGroup][1] = i;
-    }
-    cancelled = false;
+    });
 
     overflow = false;
     vertexCount = 0;
@@ -755,38 +1183,50 @@ void BlocksRenderer::build(const Chunk* chunk, const Chunks* chunks) {
 }
 
 ChunkMeshData BlocksRenderer::createMesh() {
+    std::vector<util::Buffer<uint32_t>> indices {
+        util::Buffer(indexBuffer.get(), indexCount),
+        util::Buffer(denseIndexBuffer.get(), denseIndexCount),
+    };
+    if (greedyMeshing) {
+        util::Buffer<TiledChunkVertex> vertices(vertexCount);
+        for (size_t i = 0; i < vertexCount; i++) {
+            vertices[i] = TiledChunkVertex {vertexBuffer[i], tileSizes[i]};
+        }
+        return ChunkMeshData {
+            {},
+            MeshData(
+                std::move(vertices),
+                std::move(indices),
+                util::Buffer(
+                    TiledChunkVertex::ATTRIBUTES,
+                    sizeof(TiledChunkVertex::ATTRIBUTES) / sizeof(VertexAttribute)
+                )
+            ),
+            std::move(sortingMesh)
+        };
+    }
     return ChunkMeshData {
         MeshData(
             util::Buffer(vertexBuffer.get(), vertexCount),
-            std::vector<util::Buffer<uint32_t>> {
-                util::Buffer(indexBuffer.get(), indexCount),
-                util::Buffer(denseIndexBuffer.get(), denseIndexCount),
-            },
+            std::move(indices),
             util::Buffer(
                 ChunkVertex::ATTRIBUTES, sizeof(ChunkVertex::ATTRIBUTES) / sizeof(VertexAttribute)
             )
         ),
+        {},
         std::move(sortingMesh)
     };
 }
 
-ChunkMesh BlocksRenderer::render(const Chunk *chunk, const Chunks *chunks) {
-    build(chunk, chunks);
-
-    return ChunkMesh{std::make_unique<Mesh<ChunkVertex>>(
-        vertexBuffer.get(), vertexCount, 
-        std::vector<IndexBufferData> {
-            IndexBufferData {indexBuffer.get(), indexCount},
-            IndexBufferData {denseIndexBuffer.get(), denseIndexCount},
-        }
-    ), std::move(sortingMesh)};
-}
-
 VoxelsVolume* BlocksRenderer::getVoxelsBuffer() const {
     return voxelsBuffer.get();
 }
 
 size_t BlocksRenderer::getMemoryConsumption() const {
     size_t volume = voxelsBuffer->getW() * voxelsBuffer->getH() * voxelsBuffer->getD();
-    return capacity * (sizeof(ChunkVertex) + sizeof(uint32_t) * 2) + volume * (sizeof(voxel) + sizeof(light_t));
+    size_t tileSizesSize = tileSizes ? capacity * sizeof(tileSizes[0]) : 0;
+    return capacity * (sizeof(ChunkVertex) + sizeof(uint32_t) * 2) + volume * (sizeof(voxel) + sizeof(light_t)) +
+           tileSizesSize +
+           6 * CHUNK_SECTION_VOL * sizeof(GreedyFace) +
+           voxelsBuffer->getD() * CHUNK_H * sizeof(uint32_t) * 2;
 }
@@ -23,8 +23,29 @@ struct UVRegion;
 
 class BlocksRenderer {
     static const glm::vec3 SUN_VECTOR;
+
+    /// @brief Cube block face waiting for the greedy meshing pass
+    struct GreedyFace {
+        /// @brief Block id and state, zero if there is no face
+        uint32_t key;
+        /// @brief Vertices light in face corners order
+        std::array<std::array<uint8_t, 4>, 4> colors;
+        /// @brief Block side index (texture face)
+        uint8_t side;
+        /// @brief Face may be merged along U (V) axis of the section plane
+        /// as light does not change along it
+        bool mergeU;
+        bool mergeV;
+
+        bool operator==(const GreedyFace& other) const {
+            return key == other.key && colors == other.colors;
+        }
+    };
     const Content& content;
     std::unique_ptr<ChunkVertex[]> vertexBuffer;
+    /// @brief Tile sizes of vertices built with greedy meshing
+    /// (see TiledChunkVertex), allocated on the first use
+    std::unique_ptr<std::array<uint16_t, 2>[]> tileSizes;
     std::unique_ptr<uint32_t[]> indexBuffer;
     std::unique_ptr<uint32_t[]> denseIndexBuffer;
     size_t vertexCount;
@@ -37,8 +58,22 @@ class BlocksRenderer {
     bool cancelled = false;
     bool densePass = false;
     bool denseRender = false;
+    bool greedyMeshing = false;
     const Chunk* chunk = nullptr;
     std::unique_ptr<VoxelsVolume> voxelsBuffer;
+    /// @brief Voxels buffer bit rows along X, one per (y, z). Bit is set if
+    /// the voxel hides faces of default culling blocks of the zero draw group
+    std::unique_ptr<uint32_t[]> cullingMask;
+    /// @brief Voxels buffer bit rows along X, bit is set if the voxel
+    /// lets light through
+    std::unique_ptr<uint32_t[]> lightMask;
+    /// @brief Range of voxels buffer rows loaded and covered by masks
+    int maskBottom = 0;
+    int maskTop = 0;
+    /// @brief Faces of the current section by world direction
+    std::unique_ptr<GreedyFace[]> greedyFaces;
+    /// @brief Index of the section whose faces are collected, -1 if none
+    int greedySection = -1;
 
     const Block* const* blockDefsCache;
     const ContentGfxCache& cache;
@@ -100,6 +135,32 @@ class BlocksRenderer {
         bool lights,
         bool ao
     );
+    /// @brief Cube block render method collecting faces for the greedy
+    /// meshing pass
+    void blockCubeGreedy(
+        const glm::ivec3& coord,
+        const Block& block,
+        blockstate states,
+        bool lights,
+        bool ao
+    );
+    void cubeFaceGreedy(
+        const glm::ivec3& coord,
+        const glm::ivec3& X,
+        const glm::ivec3& Y,
+        const glm::ivec3& Z,
+        int side,
+        uint32_t key,
+        bool lights,
+        bool ao
+    );
+    /// @brief Merge collected faces of the current section into quads
+    void flushGreedyFaces();
+    void greedyQuad(
+        const GreedyFace& face,
+        const glm::ivec3& localMin,
+        const glm::ivec3& localMax
+    );
     void blockAABB(
         const glm::ivec3& coord,
         const UVRegion(&faces)[6], 
@@ -125,6 +186,36 @@ class BlocksRenderer {
 
     bool isOpenForLight(int x, int y, int z) const;
 
+    /// @brief Fill culling and light masks for rows of the chunk voxels
+    /// buffer between y0 and y1
+    void buildMasks(int y0, int y1);
+
+    /// @return bits of faces {-X, +X, -Y, +Y, -Z, +Z} of a default culling
+    /// block of the zero draw group, that are not hidden by neighbours
+    inline uint8_t openFaces(const glm::ivec3& pos) const {
+        const int w = voxelsBuffer->getW();
+        const int d = voxelsBuffer->getD();
+        int bx = pos.x + voxelBufferPadding;
+        int bz = pos.z + voxelBufferPadding;
+        const uint32_t* rows = cullingMask.get() + pos.y * d + bz;
+        uint32_t row = rows[0];
+        uint32_t below = pos.y > 0 ? rows[-d] : ~0U;
+        uint32_t above = pos.y + 1 < CHUNK_H ? rows[d] : ~0U;
+        uint32_t hidden = (row >> (bx - 1) & 1) |
+                          (row >> (bx + 1) & 1) << 1 |
+                          (below >> bx & 1) << 2 |
+                          (above >> bx & 1) << 3 |
+                          (rows[-1] >> bx & 1) << 4 |
+                          (rows[1] >> bx & 1) << 5;
+        return ~hidden & 0b111111;
+    }
+
+    /// @return true if faces culling may use openFaces instead of isOpen
+    inline bool isMaskCulled(const Variant& variant) const {
+        return !densePass && variant.drawGroup == 0 &&
+               variant.culling == CullingMode::DEFAULT;
+    }
+
     // Does block allow to see other blocks sides (is it transparent)
     inline bool isOpen(const glm::ivec3& pos, const Block& def, const Variant& variant) const {
         auto vox = voxelsBuffer->pickBlock(
@@ -157,6 +248,14 @@ class BlocksRenderer {
     
     void render(const voxel* voxels, const int beginEnds[256][2]);
     SortingMeshData renderTranslucent(const voxel* voxels, int beginEnds[256][2]);
+
+    /// @brief Copy voxels of the chunk and its neighbours to the voxels
+    /// buffer and build masks for Y range [y0, y1) of the chunk
+    /// @return false if the build is cancelled
+    bool loadVoxels(const Chunk* chunk, const Chunks* chunks, int y0, int y1);
+
+    /// @brief Build mesh of the loaded chunk voxels in Y range [y0, y1)
+    void buildRange(int y0, int y1);
 public:
     BlocksRenderer(
         size_t capacity,
@@ -166,8 +265,16 @@ public:
     );
     virtual ~BlocksRenderer();
 
+    /// @brief Build single mesh of the whole chunk
     void build(const Chunk* chunk, const Chunks* chunks);
-    ChunkMesh render(const Chunk* chunk, const Chunks* chunks);
+
+    /// @brief Build separate meshes of the chunk sections
+    /// @param sections mask of sections to build
+    /// @return meshes data, sections mask is zero if the build is cancelled
+    ChunkSectionsMeshData buildSections(
+        const Chunk* chunk, const Chunks* chunks, uint16_t sections
+    );
+
     ChunkMeshData createMesh();
     VoxelsVolume* getVoxelsBuffer() const;
 
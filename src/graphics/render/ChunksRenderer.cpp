@@ -18,7 +18,40 @@ static debug::Logger logger("chunks-render");
 
 size_t ChunksRenderer::visibleChunks = 0;
 
-class RendererWorker : public util::Worker<std::shared_ptr<Chunk>, RendererResult> {
+/// @brief Draw meshes of chunk sections visible in frustum
+/// @param frustum frustum used for culling or nullptr
+/// @param min chunk bounding box min
+/// @param max chunk bounding box max
+/// @return number of sections drawn
+static int draw_sections(
+    const ChunkSectionsMesh& sections,
+    const Frustum* frustum,
+    const glm::vec3& min,
+    const glm::vec3& max,
+    bool dense
+) {
+    int drawn = 0;
+    for (int s = 0; s < CHUNK_SECTIONS; s++) {
+        const auto& section = sections[s];
+        if (section.mesh == nullptr && section.tiledMesh == nullptr) {
+            continue;
+        }
+        glm::vec3 sectionMin(min.x, s * CHUNK_SECTION_H, min.z);
+        glm::vec3 sectionMax(max.x, (s + 1) * CHUNK_SECTION_H, max.z);
+        if (frustum && !frustum->isBoxVisible(sectionMin, sectionMax)) {
+            continue;
+        }
+        if (section.tiledMesh) {
+            section.tiledMesh->draw(GL_TRIANGLES, dense);
+        } else {
+            section.mesh->draw(GL_TRIANGLES, dense);
+        }
+        drawn++;
+    }
+    return drawn;
+}
+
+class RendererWorker : public util::Worker<RendererJob, RendererResult> {
     const Chunks& chunks;
     BlocksRenderer renderer;
 public:
@@ -39,15 +72,14 @@ public:
           ) {
     }
 
-    RendererResult operator()(const std::shared_ptr<Chunk>& chunk) override {
-        renderer.build(chunk.get(), &chunks);
-        if (renderer.isCancelled()) {
-            return RendererResult {
-                glm::ivec2(chunk->x, chunk->z), true, ChunkMeshData {}};
-        }
-        auto meshData = renderer.createMesh();
+    RendererResult operator()(const RendererJob& job) override {
+        const auto& chunk = job.chunk;
+        auto meshData =
+            renderer.buildSections(chunk.get(), &chunks, job.sections);
         return RendererResult {
-            glm::ivec2(chunk->x, chunk->z), false, std::move(meshData)};
+            glm::ivec2(chunk->x, chunk->z),
+            renderer.isCancelled(),
+            std::move(meshData)};
     }
 };
 
@@ -72,10 +104,7 @@ ChunksRenderer::ChunksRenderer(
           },
           [&](RendererResult& result) {
               if (!result.cancelled) {
-                  auto meshData = std::move(result.meshData);
-                  meshes[result.key] = ChunkMesh {
-                      std::make_unique<Mesh<ChunkVertex>>(meshData.mesh),
-                      std::move(meshData.sortingMesh)};
+                  setMeshes(result.key, result.meshData);
               }
               inwork.erase(result.key);
           },
@@ -94,31 +123,81 @@ ChunksRenderer::ChunksRenderer(
 
 ChunksRenderer::~ChunksRenderer() = default;
 
-const Mesh<ChunkVertex>* ChunksRenderer::render(
-    const std::shared_ptr<Chunk>& chunk, bool important
+void ChunksRenderer::setMeshes(
+    const glm::ivec2& key, ChunkSectionsMeshData& data
 ) {
-    chunk->flags.modified = false;
-    if (important) {
-        auto mesh = renderer->render(chunk.get(), &chunks);
-        meshes[glm::ivec2(chunk->x, chunk->z)] = ChunkMesh {
-            std::move(mesh.mesh), std::move(mesh.sortingMeshData)
-        };
-        return meshes[glm::ivec2(chunk->x, chunk->z)].mesh.get();
+    auto found = meshes.find(key);
+    if (found == meshes.end()) {
+        // meshes of the rest sections were unloaded
+        if (data.sections != CHUNK_SECTIONS_ALL) {
+            return;
+        }
+        found = meshes.emplace(key, ChunkSectionsMesh {}).first;
     }
+    auto& sections = found->second;
+    for (int s = 0; s < CHUNK_SECTIONS; s++) {
+        if (!(data.sections >> s & 1)) {
+            continue;
+        }
+        auto& meshData = data.meshes[s];
+        std::unique_ptr<Mesh<ChunkVertex>> mesh;
+        std::unique_ptr<Mesh<TiledChunkVertex>> tiledMesh;
+        if (meshData.mesh.vertices.size()) {
+            mesh = std::make_unique<Mesh<ChunkVertex>>(meshData.mesh);
+        }
+        if (meshData.tiledMesh.vertices.size()) {
+            tiledMesh =
+                std::make_unique<Mesh<TiledChunkVertex>>(meshData.tiledMesh);
+        }
+        sections[s] = ChunkMesh {
+            std::move(mesh),
+            std::move(tiledMesh),
+            std::move(meshData.sortingMesh)};
+    }
+}
+
+const ChunkSectionsMesh* ChunksRenderer::render(
+    const std::shared_ptr<Chunk>& chunk, bool important, int priority
+) {
     glm::ivec2 key(chunk->x, chunk->z);
+    uint16_t sections = chunk->modifiedSections;
+    if (meshes.find(key) == meshes.end()) {
+        sections = CHUNK_SECTIONS_ALL;
+    }
+    if (important) {
+        chunk->flags.modified = false;
+        chunk->modifiedSections = 0;
+        auto meshData = renderer->buildSections(chunk.get(), &chunks, sections);
+        if (renderer->isCancelled()) {
+            return nullptr;
+        }
+        setMeshes(key, meshData);
+        const auto& found = meshes.find(key);
+        return found == meshes.end() ? nullptr : &found->second;
+    }
+    // modified sections are kept to be built after the current job
     if (inwork.find(key) != inwork.end()) {
         return nullptr;
     }
+    chunk->flags.modified = false;
+    chunk->modifiedSections = 0;
     inwork[key] = true;
-    threadPool.enqueueJob(chunk);
+    threadPool.enqueueJob(RendererJob {chunk, sections}, priority);
     return nullptr;
 }
 
 void ChunksRenderer::unload(const Chunk* chunk) {
-    auto found = meshes.find(glm::ivec2(chunk->x, chunk->z));
+    glm::ivec2 key(chunk->x, chunk->z);
+    auto found = meshes.find(key);
     if (found != meshes.end()) {
         meshes.erase(found);
     }
+    // mesh of the unloaded chunk is not needed anymore
+    if (threadPool.cancelJobs([chunk](const RendererJob& job) {
+            return job.chunk.get() == chunk;
+        })) {
+        inwork.erase(key);
+    }
 }
 
 void ChunksRenderer::clear() {
@@ -127,24 +206,24 @@ void ChunksRenderer::clear() {
     threadPool.clearQueue();
 }
 
-const Mesh<ChunkVertex>* ChunksRenderer::getOrRender(
-    const std::shared_ptr<Chunk>& chunk, bool important
+const ChunkSectionsMesh* ChunksRenderer::getOrRender(
+    const std::shared_ptr<Chunk>& chunk, bool important, int priority
 ) {
     auto found = meshes.find(glm::ivec2(chunk->x, chunk->z));
     if (found == meshes.end()) {
-        return render(chunk, important);
+        return render(chunk, important, priority);
     }
     if (chunk->flags.modified && chunk->flags.lighted) {
-        render(chunk, important);
+        render(chunk, important, priority);
     }
-    return found->second.mesh.get();
+    return &found->second;
 }
 
 void ChunksRenderer::update() {
     threadPool.update();
 }
 
-const Mesh<ChunkVertex>* ChunksRenderer::retrieveChunk(
+const ChunkSectionsMesh* ChunksRenderer::retrieveChunk(
     size_t index, const Camera& camera, bool culling
 ) {
     auto chunk = chunks.getChunks()[index];
@@ -156,7 +235,7 @@ const Mesh<ChunkVertex>* ChunksRenderer::retrieveChunk(
         if (found == meshes.end()) {
             return nullptr;
         } else {
-            return found->second.mesh.get();
+            return &found->second;
         }
     }
     float distance = glm::distance(
@@ -167,7 +246,10 @@ const Mesh<ChunkVertex>* ChunksRenderer::retrieveChunk(
             (chunk->z + 0.5f) * CHUNK_D
         )
     );
-    auto mesh = getOrRender(chunk, distance < CHUNK_W * 1.5f);
+    // nearest chunks are built first
+    auto mesh = getOrRender(
+        chunk, distance < CHUNK_W * 1.5f, -static_cast<int>(distance)
+    );
     if (mesh == nullptr) {
         return nullptr;
     }
@@ -226,9 +308,9 @@ void ChunksRenderer::drawShadowsPass(
         }
         glm::mat4 model = glm::translate(glm::mat4(1.0f), coord);
         shader.uniformMatrix("u_model", model);
-        found->second.mesh->draw(GL_TRIANGLES, 
-            glm::distance2(playerCamera.position * glm::vec3(1, 0, 1), 
-                           (min + max) * 0.5f * glm::vec3(1, 0, 1)) < denseDistance2);
+        bool dense = glm::distance2(playerCamera.position * glm::vec3(1, 0, 1), 
+                         (min + max) * 0.5f * glm::vec3(1, 0, 1)) < denseDistance2;
+        draw_sections(found->second, &frustum, min, max, dense);
     }
 }
 
@@ -279,9 +361,15 @@ void ChunksRenderer::drawChunks(
             );
             glm::mat4 model = glm::translate(glm::mat4(1.0f), coord);
             shader.uniformMatrix("u_model", model);
-            mesh->draw(GL_TRIANGLES, glm::distance2(camera.position * glm::vec3(1, 0, 1), 
-                (coord + glm::vec3(CHUNK_W * 0.5f, 0.0f, CHUNK_D * 0.5f))) < denseDistance2);
-            visibleChunks++;
+            bool dense = glm::distance2(camera.position * glm::vec3(1, 0, 1), 
+                (coord + glm::vec3(CHUNK_W * 0.5f, 0.0f, CHUNK_D * 0.5f))) < denseDistance2;
+            glm::vec3 min(chunk->x * CHUNK_W, 0, chunk->z * CHUNK_D);
+            glm::vec3 max(min.x + CHUNK_W, CHUNK_H, min.z + CHUNK_D);
+            if (draw_sections(
+                    *mesh, culling ? &frustum : nullptr, min, max, dense
+                )) {
+                visibleChunks++;
+            }
         }
     }
 }
@@ -300,6 +388,49 @@ static inline void write_sorting_mesh_entries(
     }
 }
 
+/// @brief Draw translucent entries of the section mesh sorted by distance
+/// @param resort sort entries again even if sorted mesh is available
+static void draw_sorted_mesh(
+    ChunkMesh& mesh, const glm::vec3& cameraPos, bool resort
+) {
+    auto& entries = mesh.sortingMeshData.entries;
+    if (entries.empty()) {
+        return;
+    }
+    if (entries.size() == 1) {
+        auto& entry = entries.at(0);
+        if (mesh.sortedMesh == nullptr) {
+            mesh.sortedMesh = std::make_unique<Mesh<ChunkVertex>>(
+                entry.vertexData.data(), entry.vertexData.size()
+            );
+        }
+        mesh.sortedMesh->draw();
+        return;
+    }
+    for (auto& entry : entries) {
+        entry.distance = static_cast<long long>(
+            glm::distance2(entry.position, cameraPos)
+        );
+    }
+    if (mesh.sortedMesh == nullptr || resort) {
+        std::sort(entries.begin(), entries.end());
+        size_t size = 0;
+        for (const auto& entry : entries) {
+            size += entry.vertexData.size();
+        }
+
+        static util::Buffer<ChunkVertex> buffer;
+        if (buffer.size() < size) {
+            buffer = util::Buffer<ChunkVertex>(size);
+        }
+        write_sorting_mesh_entries(buffer.data(), entries);
+        mesh.sortedMesh = std::make_unique<Mesh<ChunkVertex>>(
+            buffer.data(), size
+        );
+    }
+    mesh.sortedMesh->draw();
+}
+
 void ChunksRenderer::drawSortedMeshes(const Camera& camera, Shader& shader) {
     const int sortInterval = TRANSLUCENT_BLOCKS_SORT_INTERVAL;
     static int frameid = 0;
@@ -321,7 +452,7 @@ void ChunksRenderer::drawSortedMeshes(const Camera& camera, Shader& shader) {
             continue;
         }
         const auto& found = meshes.find(glm::ivec2(chunk->x, chunk->z));
-        if (found == meshes.end() || found->second.sortingMeshData.entries.empty()) {
+        if (found == meshes.end()) {
             continue;
         }
 
@@ -336,40 +467,20 @@ void ChunksRenderer::drawSortedMeshes(const Camera& camera, Shader& shader) {
             if (!frustum.isBoxVisible(min, max)) continue;
         }
 
-        auto& chunkEntries = found->second.sortingMeshData.entries;
-
-        if (chunkEntries.size() == 1) {
-            auto& entry = chunkEntries.at(0);
-            if (found->second.sortedMesh == nullptr) {
-                found->second.sortedMesh = std::make_unique<Mesh<ChunkVertex>>(
-                    entry.vertexData.data(), entry.vertexData.size()
-                );
-            }
-            found->second.sortedMesh->draw();
-            continue;
-        }
-        for (auto& entry : chunkEntries) {
-            entry.distance = static_cast<long long>(
-                glm::distance2(entry.position, cameraPos)
-            );
+        auto& sections = found->second;
+        bool resort = (frameid + chunk->x) % sortInterval == 0;
+        // sections are drawn from the farthest one to the camera section
+        int cameraSection = std::clamp(
+            static_cast<int>(std::floor(cameraPos.y / CHUNK_SECTION_H)),
+            0,
+            CHUNK_SECTIONS - 1
+        );
+        for (int s = 0; s < cameraSection; s++) {
+            draw_sorted_mesh(sections[s], cameraPos, resort);
         }
-        if (found->second.sortedMesh == nullptr ||
-            (frameid + chunk->x) % sortInterval == 0) {
-            std::sort(chunkEntries.begin(), chunkEntries.end());
-            size_t size = 0;
-            for (const auto& entry : chunkEntries) {
-                size += entry.vertexData.size();
-            }
-
-            static util::Buffer<ChunkVertex> buffer;
-            if (buffer.size() < size) {
-                buffer = util::Buffer<ChunkVertex>(size);
-            }
-            write_sorting_mesh_entries(buffer.data(), chunkEntries);
-            found->second.sortedMesh = std::make_unique<Mesh<ChunkVertex>>(
-                buffer.data(), size
-            );
+        for (int s = CHUNK_SECTIONS - 1; s > cameraSection; s--) {
+            draw_sorted_mesh(sections[s], cameraPos, resort);
         }
-        found->second.sortedMesh->draw();
+        draw_sorted_mesh(sections[cameraSection], cameraPos, resort);
     }
 }
@@ -32,10 +32,16 @@ struct ChunksSortEntry {
     }
 };
 
+struct RendererJob {
+    std::shared_ptr<Chunk> chunk;
+    /// @brief Bitmask of sections to build
+    uint16_t sections;
+};
+
 struct RendererResult {
     glm::ivec2 key;
     bool cancelled;
-    ChunkMeshData meshData;
+    ChunkSectionsMeshData meshData;
 };
 
 class ChunksRenderer {
@@ -45,13 +51,16 @@ class ChunksRenderer {
     const EngineSettings& settings;
 
     std::unique_ptr<BlocksRenderer> renderer;
-    std::unordered_map<glm::ivec2, ChunkMesh> meshes;
+    std::unordered_map<glm::ivec2, ChunkSectionsMesh> meshes;
     std::unordered_map<glm::ivec2, bool> inwork;
     std::vector<ChunksSortEntry> indices;
-    util::ThreadPool<std::shared_ptr<Chunk>, RendererResult> threadPool;
-    const Mesh<ChunkVertex>* retrieveChunk(
+    util::ThreadPool<RendererJob, RendererResult> threadPool;
+    const ChunkSectionsMesh* retrieveChunk(
         size_t index, const Camera& camera, bool culling
     );
+
+    /// @brief Replace meshes of sections built
+    void setMeshes(const glm::ivec2& key, ChunkSectionsMeshData& data);
 public:
     ChunksRenderer(
         const Level* level,
@@ -63,14 +72,18 @@ public:
     );
     virtual ~ChunksRenderer();
 
-    const Mesh<ChunkVertex>* render(
-        const std::shared_ptr<Chunk>& chunk, bool important
+    /// @brief Rebuild meshes of modified sections of the chunk
+    /// (or all sections if the chunk has no meshes yet)
+    /// @param important build in the current thread
+    /// @param priority jobs with higher priority are built first
+    const ChunkSectionsMesh* render(
+        const std::shared_ptr<Chunk>& chunk, bool important, int priority = 0
     );
     void unload(const Chunk* chunk);
     void clear();
 
-    const Mesh<ChunkVertex>* getOrRender(
-        const std::shared_ptr<Chunk>& chunk, bool important
+    const ChunkSectionsMesh* getOrRender(
+        const std::shared_ptr<Chunk>& chunk, bool important, int priority = 0
     );
 
     void drawShadowsPass(
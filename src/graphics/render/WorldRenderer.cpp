@@ -314,21 +314,32 @@ void WorldRenderer::renderFrame(
     CompileTimeShaderSettings currentSettings {
         gbufferPipeline,
         shadowsQuality != 0,
-        settings.graphics.ssao.get() && gbufferPipeline
+        settings.graphics.ssao.get() && gbufferPipeline,
+        settings.graphics.greedyMeshing.get()
     };
     if (
         prevCTShaderSettings.advancedRender != currentSettings.advancedRender ||
         prevCTShaderSettings.shadows != currentSettings.shadows ||
-        prevCTShaderSettings.ssao != currentSettings.ssao
+        prevCTShaderSettings.ssao != currentSettings.ssao ||
+        prevCTShaderSettings.greedyMeshing != currentSettings.greedyMeshing
     ) {
         std::vector<std::string> defines;
         if (currentSettings.shadows) defines.emplace_back("ENABLE_SHADOWS");
         if (currentSettings.ssao) defines.emplace_back("ENABLE_SSAO");
         if (currentSettings.advancedRender) defines.emplace_back("ADVANCED_RENDER");
+        // chunk meshes use TiledChunkVertex
+        if (currentSettings.greedyMeshing) defines.emplace_back("GREEDY_MESHING");
 
         for (auto shader : affectedShaders) {
             shader->recompile(defines);
         }
+        if (prevCTShaderSettings.greedyMeshing != currentSettings.greedyMeshing) {
+            std::vector<std::string> shadowsDefines;
+            if (currentSettings.greedyMeshing) {
+                shadowsDefines.emplace_back("GREEDY_MESHING");
+            }
+            assets.require<Shader>("shadows").recompile(shadowsDefines);
+        }
         prevCTShaderSettings = currentSettings;
     }
 
@@ -42,6 +42,7 @@ struct CompileTimeShaderSettings {
     bool advancedRender = false;
     bool shadows = false;
     bool ssao = false;
+    bool greedyMeshing = false;
 };
 
 class WorldRenderer {
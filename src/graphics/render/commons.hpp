@@ -6,6 +6,7 @@
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
+#include "constants.hpp"
 #include "graphics/core/MeshData.hpp"
 #include "util/Buffer.hpp"
 
@@ -24,6 +25,24 @@ struct ChunkVertex {
         {{}, 0}};
 };
 
+/// @brief Chunk mesh vertex format used with greedy meshing only
+/// (main and shadows shaders compiled with GREEDY_MESHING)
+struct TiledChunkVertex {
+    ChunkVertex vertex;
+    /// @brief Size of the texture atlas region repeated over a face merged
+    /// by greedy meshing, zero for regular faces. The region starts at uv of
+    /// the provoking vertex
+    std::array<uint16_t, 2> tileSize;
+
+    static constexpr VertexAttribute ATTRIBUTES[] = {
+        {VertexAttribute::Type::FLOAT, false, 3},
+        {VertexAttribute::Type::FLOAT, false, 2},
+        {VertexAttribute::Type::UNSIGNED_BYTE, true, 4},
+        {VertexAttribute::Type::UNSIGNED_BYTE, true, 4},
+        {VertexAttribute::Type::UNSIGNED_SHORT, true, 2},
+        {{}, 0}};
+};
+
 template<typename VertexStructure>
 class Mesh;
 
@@ -43,11 +62,26 @@ struct SortingMeshData {
 
 struct ChunkMeshData {
     MeshData<ChunkVertex> mesh;
+    /// @brief Mesh built with greedy meshing, used instead of `mesh`
+    MeshData<TiledChunkVertex> tiledMesh;
     SortingMeshData sortingMesh;
 };
 
+/// @brief Meshes data of chunk sections built together
+struct ChunkSectionsMeshData {
+    /// @brief Bitmask of sections built
+    uint16_t sections = 0;
+    std::array<ChunkMeshData, CHUNK_SECTIONS> meshes;
+};
+
 struct ChunkMesh {
     std::unique_ptr<Mesh<ChunkVertex>> mesh;
+    /// @brief Mesh built with greedy meshing, used instead of `mesh`
+    std::unique_ptr<Mesh<TiledChunkVertex>> tiledMesh;
     SortingMeshData sortingMeshData;
     std::unique_ptr<Mesh<ChunkVertex> > sortedMesh = nullptr;
 };
+
+/// @brief Meshes of chunk sections rebuilt independently.
+/// Mesh of a section without geometry is nullptr
+using ChunkSectionsMesh = std::array<ChunkMesh, CHUNK_SECTIONS>;
@@ -16,6 +16,17 @@
 
 #include "devices/Device.hpp"
 
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace fs = std::filesystem;
 
 static std::map<std::string, std::shared_ptr<io::Device>> devices;
@@ -85,6 +96,99 @@ void io::rafile::read(char* buffer, std::streamsize size) {
     file->read(buffer, size);
 }
 
+#ifdef _WIN32
+io::mmfile::mmfile(const io::path& filename) {
+    auto filepath = io::resolve(filename);
+    fileHandle = CreateFileW(
+        filepath.wstring().c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        fileHandle = nullptr;
+        throw std::runtime_error("could not to open file " + filename.string());
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size)) {
+        CloseHandle(fileHandle);
+        throw std::runtime_error("could not get size of " + filename.string());
+    }
+    filelength = static_cast<size_t>(size.QuadPart);
+    if (filelength == 0) {
+        return;
+    }
+    mappingHandle =
+        CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle == nullptr) {
+        CloseHandle(fileHandle);
+        throw std::runtime_error("could not map file " + filename.string());
+    }
+    bytes = static_cast<const ubyte*>(
+        MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0)
+    );
+    if (bytes == nullptr) {
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        throw std::runtime_error("could not map file " + filename.string());
+    }
+}
+
+io::mmfile::~mmfile() {
+    if (bytes) {
+        UnmapViewOfFile(bytes);
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle) {
+        CloseHandle(fileHandle);
+    }
+}
+#else
+io::mmfile::mmfile(const io::path& filename) {
+    auto filepath = io::resolve(filename);
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("could not to open file " + filename.string());
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        throw std::runtime_error("could not get size of " + filename.string());
+    }
+    filelength = static_cast<size_t>(st.st_size);
+    if (filelength == 0) {
+        close(fd);
+        return;
+    }
+    void* ptr = mmap(nullptr, filelength, PROT_READ, MAP_PRIVATE, fd, 0);
+    // mapping stays valid after the descriptor is closed
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        throw std::runtime_error("could not map file " + filename.string());
+    }
+    bytes = static_cast<const ubyte*>(ptr);
+}
+
+io::mmfile::~mmfile() {
+    if (bytes) {
+        munmap(const_cast<ubyte*>(bytes), filelength);
+    }
+}
+#endif
+
+const ubyte* io::mmfile::data() const {
+    return bytes;
+}
+
+size_t io::mmfile::length() const {
+    return filelength;
+}
+
 bool io::write_bytes(
     const io::path& filename, const ubyte* data, size_t size
 ) {
@@ -48,6 +48,26 @@ namespace io {
         size_t length() const;
     };
 
+    /// @brief Read-only memory-mapped file
+    class mmfile {
+        const ubyte* bytes = nullptr;
+        size_t filelength = 0;
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#endif
+    public:
+        /// @throw std::runtime_error if file cannot be opened or mapped
+        mmfile(const path& filename);
+        mmfile(const mmfile&) = delete;
+        ~mmfile();
+
+        /// @return pointer to the mapped file content, valid until
+        /// the mmfile is destroyed
+        const ubyte* data() const;
+        size_t length() const;
+    };
+
     class directory_iterator_impl {
     public:
         using iterator_category = std::input_iterator_tag;
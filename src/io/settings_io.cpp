@@ -65,6 +65,8 @@ SettingsHandler::SettingsHandler(EngineSettings& settings) {
     builder.add("load-distance", &settings.chunks.loadDistance);
     builder.add("load-speed", &settings.chunks.loadSpeed);
     builder.add("padding", &settings.chunks.padding);
+    builder.add("generator-workers", &settings.chunks.generatorWorkers);
+    builder.add("lighting-workers", &settings.chunks.lightingWorkers);
 
     builder.addSection("graphics");
     builder.add("fog-curve", &settings.graphics.fogCurve);
@@ -81,6 +83,7 @@ SettingsHandler::SettingsHandler(EngineSettings& settings) {
     builder.add("shadows-quality", &settings.graphics.shadowsQuality);
     builder.add("dense-render-distance", &settings.graphics.denseRenderDistance);
     builder.add("soft-lighting", &settings.graphics.softLighting);
+    builder.add("greedy-meshing", &settings.graphics.greedyMeshing);
 
     builder.addSection("ui");
     builder.add("language", &settings.ui.language);
@@ -15,6 +15,14 @@ struct ItemFuncsSet {
     bool on_block_break_by : 1;
 };
 
+/// @brief Interned script events handles (see lua::intern_event).
+/// Set when the item script is loaded
+struct ItemEventsSet {
+    int use = 0;
+    int useon = 0;
+    int blockbreakby = 0;
+};
+
 enum class ItemIconType {
     NONE,    // invisible (core:empty) must not be rendered
     SPRITE,  // textured quad: icon is `atlas_name:texture_name`
@@ -72,6 +80,7 @@ struct ItemDef {
         itemid_t id;
         blockid_t placingBlock;
         ItemFuncsSet funcsset {};
+        ItemEventsSet events {};
         bool emissive = false;
 
         std::set<int> tags;
@@ -15,6 +15,103 @@ LightSolver::LightSolver(const ContentIndices& contentIds, Chunks& chunks, int c
       channel(channel) {
 }
 
+/// @brief Neighbour is not looked up yet
+static constexpr int32_t UNRESOLVED = -2;
+/// @brief Neighbour chunk is not available
+static constexpr int32_t NO_CHUNK = -1;
+
+uint32_t LightSolver::cacheChunk(Chunk* chunk) {
+    if (lastCached < chunksCache.size() &&
+        chunksCache[lastCached].chunk == chunk) {
+        return lastCached;
+    }
+    for (uint32_t i = 0; i < chunksCache.size(); i++) {
+        if (chunksCache[i].chunk == chunk) {
+            return lastCached = i;
+        }
+    }
+    chunksCache.push_back(CachedChunk {
+        chunk, {UNRESOLVED, UNRESOLVED, UNRESOLVED, UNRESOLVED}, 0
+    });
+    return lastCached = chunksCache.size() - 1;
+}
+
+int32_t LightSolver::getNeighbour(uint32_t index, int side) {
+    int32_t neighbour = chunksCache[index].neighbours[side];
+    if (neighbour != UNRESOLVED) {
+        return neighbour;
+    }
+    static const int offsets[4][2] {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    const Chunk* chunk = chunksCache[index].chunk;
+    if (Chunk* found = chunks.getChunk(
+            chunk->x + offsets[side][0], chunk->z + offsets[side][1]
+        )) {
+        neighbour = cacheChunk(found);
+        chunksCache[neighbour].neighbours[side ^ 1] = index;
+    } else {
+        neighbour = NO_CHUNK;
+    }
+    chunksCache[index].neighbours[side] = neighbour;
+    return neighbour;
+}
+
+inline bool LightSolver::step(
+    const lightentry& entry, int direction, uint32_t& chunk, int& index
+) {
+    int lx = entry.index % CHUNK_W;
+    int lz = entry.index / CHUNK_W % CHUNK_D;
+    int y = entry.index / (CHUNK_W * CHUNK_D);
+    int32_t neighbour;
+
+    chunk = entry.chunk;
+    index = entry.index;
+    switch (direction) {
+        case 0:
+            if (lz < CHUNK_D - 1) {
+                index += CHUNK_W;
+                return true;
+            }
+            neighbour = getNeighbour(chunk, 3);
+            index -= (CHUNK_D - 1) * CHUNK_W;
+            break;
+        case 1:
+            if (lz > 0) {
+                index -= CHUNK_W;
+                return true;
+            }
+            neighbour = getNeighbour(chunk, 2);
+            index += (CHUNK_D - 1) * CHUNK_W;
+            break;
+        case 2:
+            index += CHUNK_W * CHUNK_D;
+            return y < CHUNK_H - 1;
+        case 3:
+            index -= CHUNK_W * CHUNK_D;
+            return y > 0;
+        case 4:
+            if (lx < CHUNK_W - 1) {
+                index += 1;
+                return true;
+            }
+            neighbour = getNeighbour(chunk, 1);
+            index -= CHUNK_W - 1;
+            break;
+        default:
+            if (lx > 0) {
+                index -= 1;
+                return true;
+            }
+            neighbour = getNeighbour(chunk, 0);
+            index += CHUNK_W - 1;
+            break;
+    }
+    if (neighbour == NO_CHUNK) {
+        return false;
+    }
+    chunk = neighbour;
+    return true;
+}
+
 void LightSolver::add(int x, int y, int z, int emission) {
     if (emission <= 1) {
         return;
@@ -25,14 +122,16 @@ void LightSolver::add(int x, int y, int z, int emission) {
     }
     assert(chunk->lightmap != nullptr);
     auto& lightmap = *chunk->lightmap;
+    int index = vox_index(x - chunk->x * CHUNK_W, y, z - chunk->z * CHUNK_D);
 
-    ubyte light = lightmap.get(x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, channel);
+    ubyte light = lightmap.getChannel(index, channel);
     if (emission < light) return;
 
-    addqueue.push(lightentry {x, y, z, ubyte(emission)});
+    addqueue.push(lightentry {
+        cacheChunk(chunk), static_cast<uint16_t>(index), ubyte(emission)});
 
-    chunk->flags.modified = true;
-    lightmap.set(x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, channel, emission);
+    chunk->setModified(y);
+    lightmap.setChannel(index, channel, emission);
 }
 
 void LightSolver::add(int x, int y, int z) {
@@ -46,61 +145,77 @@ void LightSolver::remove(int x, int y, int z) {
     }
     assert(chunk->lightmap != nullptr);
     auto& lightmap = *chunk->lightmap;
+    int index = vox_index(x - chunk->x * CHUNK_W, y, z - chunk->z * CHUNK_D);
 
-    ubyte light = lightmap.get(x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, channel);
+    ubyte light = lightmap.getChannel(index, channel);
     if (light == 0) {
         return;
     }
-    remqueue.push(lightentry {x, y, z, light});
-    lightmap.set(x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, channel, 0);
+    remqueue.push(
+        lightentry {cacheChunk(chunk), static_cast<uint16_t>(index), light});
+    lightmap.setChannel(index, channel, 0);
 }
 
-void LightSolver::solve(){
-    const int coords[] = {
-            0, 0, 1,
-            0, 0,-1,
-            0, 1, 0,
-            0,-1, 0,
-            1, 0, 0,
-           -1, 0, 0
-    };
+void LightSolver::solve() {
+    propagate();
+    applyModified();
+}
+
+void LightSolver::applyModified() {
+    for (const auto& cached : chunksCache) {
+        if (cached.modifiedSections) {
+            cached.chunk->flags.modified = true;
+            cached.chunk->modifiedSections |= cached.modifiedSections;
+        }
+    }
+    // entries refer to the cache
+    if (addqueue.empty() && remqueue.empty()) {
+        chunksCache.clear();
+        lastCached = 0;
+    } else {
+        for (auto& cached : chunksCache) {
+            cached.modifiedSections = 0;
+        }
+    }
+}
+
+void LightSolver::propagate() {
+    uint32_t chunkIndex;
+    int index;
 
     while (!remqueue.empty()){
         const lightentry entry = remqueue.front();
         remqueue.pop();
 
         for (int i = 0; i < 6; i++) {
-            int imul3 = i*3;
-            int x = entry.x+coords[imul3];
-            int y = entry.y+coords[imul3+1];
-            int z = entry.z+coords[imul3+2];
-            
-            Chunk* chunk = chunks.getChunkByVoxel(x,y,z);
-            if (chunk) {
-                int lx = x - chunk->x * CHUNK_W;
-                int lz = z - chunk->z * CHUNK_D;
-                chunk->flags.modified = true;
-
-                assert(chunk->lightmap != nullptr);
-                auto& lightmap = *chunk->lightmap;
-
-                ubyte light = lightmap.get(lx,y,lz, channel);
-                if (light != 0 && light == entry.light-1){
-                    voxel* vox = chunks.get(x, y, z);
-                    if (vox && vox->id != 0) {
-                        const Block* block = blockDefs[vox->id];
-                        if (uint8_t emission = block->emission[channel]) {
-                            addqueue.push(lightentry {x, y, z, emission});
-                            lightmap.set(lx, y, lz, channel, emission);
-                        }
-                        else lightmap.set(lx, y, lz, channel, 0);
+            if (!step(entry, i, chunkIndex, index)) {
+                continue;
+            }
+            auto& cached = chunksCache[chunkIndex];
+            Chunk* chunk = cached.chunk;
+            cached.modifiedSections |=
+                Chunk::getSectionsAround(index / (CHUNK_W * CHUNK_D));
+
+            assert(chunk->lightmap != nullptr);
+            auto& lightmap = *chunk->lightmap;
+            auto voxelIndex = static_cast<uint16_t>(index);
+
+            ubyte light = lightmap.getChannel(index, channel);
+            if (light != 0 && light == entry.light-1){
+                const voxel& vox = chunk->voxels[index];
+                if (vox.id != 0) {
+                    const Block* block = blockDefs[vox.id];
+                    if (uint8_t emission = block->emission[channel]) {
+                        addqueue.push(lightentry {chunkIndex, voxelIndex, emission});
+                        lightmap.setChannel(index, channel, emission);
                     }
-                    else lightmap.set(lx, y, lz, channel, 0);
-                    remqueue.push(lightentry {x, y, z, light});
-                }
-                else if (light >= entry.light){
-                    addqueue.push(lightentry {x, y, z, light});
+                    else lightmap.setChannel(index, channel, 0);
                 }
+                else lightmap.setChannel(index, channel, 0);
+                remqueue.push(lightentry {chunkIndex, voxelIndex, light});
+            }
+            else if (light >= entry.light){
+                addqueue.push(lightentry {chunkIndex, voxelIndex, light});
             }
         }
     }
@@ -110,30 +225,26 @@ void LightSolver::solve(){
         addqueue.pop();
 
         for (int i = 0; i < 6; i++) {
-            int imul3 = i*3;
-            int x = entry.x+coords[imul3];
-            int y = entry.y+coords[imul3+1];
-            int z = entry.z+coords[imul3+2];
-
-            Chunk* chunk = chunks.getChunkByVoxel(x,y,z);
-            if (chunk == nullptr) {
+            if (!step(entry, i, chunkIndex, index)) {
                 continue;
             }
+            auto& cached = chunksCache[chunkIndex];
+            Chunk* chunk = cached.chunk;
+            cached.modifiedSections |=
+                Chunk::getSectionsAround(index / (CHUNK_W * CHUNK_D));
+
             assert(chunk->lightmap != nullptr);
             auto& lightmap = *chunk->lightmap;
-            int lx = x - chunk->x * CHUNK_W;
-            int lz = z - chunk->z * CHUNK_D;
-            chunk->flags.modified = true;
 
-            ubyte light = lightmap.get(lx, y, lz, channel);
-            voxel& v = chunk->voxels[vox_index(lx, y, lz)];
+            ubyte light = lightmap.getChannel(index, channel);
+            const voxel& v = chunk->voxels[index];
             const Block* block = blockDefs[v.id];
             if (block->lightPassing && light+2 <= entry.light){
-                lightmap.set(
-                    x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, 
-                    channel, 
-                    entry.light-1);
-                addqueue.push(lightentry {x, y, z, ubyte(entry.light-1)});
+                lightmap.setChannel(index, channel, entry.light-1);
+                addqueue.push(lightentry {
+                    chunkIndex,
+                    static_cast<uint16_t>(index),
+                    ubyte(entry.light-1)});
             }
         }
     }
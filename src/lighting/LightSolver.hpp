@@ -1,24 +1,63 @@
 #pragma once
 
-#include <queue>
+#include <vector>
 
+#include "typedefs.hpp"
+#include "util/ring_queue.hpp"
+
+class Chunk;
 class Chunks;
 class ContentIndices;
 class Block;
 
+/// @brief Light propagation queue entry
 struct lightentry {
-    int x;
-    int y;
-    int z;
+    /// @brief Index of the chunk in the solver chunks cache
+    uint32_t chunk;
+    /// @brief Voxel index in the chunk
+    uint16_t index;
     unsigned char light;
 };
+static_assert(sizeof(lightentry) == 8);
 
 class LightSolver {
-    std::queue<lightentry> addqueue;
-    std::queue<lightentry> remqueue;
+    /// @brief Chunk used by queued entries
+    struct CachedChunk {
+        Chunk* chunk;
+        /// @brief Cache indices of -X, +X, -Z, +Z neighbours
+        int32_t neighbours[4];
+        /// @brief Sections of the chunk which lights were changed
+        /// by propagate()
+        uint16_t modifiedSections;
+    };
+
+    util::ring_queue<lightentry> addqueue;
+    util::ring_queue<lightentry> remqueue;
+    /// @brief Chunks used by queued entries. Cleared by applyModified()
+    std::vector<CachedChunk> chunksCache;
+    /// @brief Last found chunk cache index
+    uint32_t lastCached = 0;
     const Block* const* blockDefs;
     Chunks& chunks;
     int channel;
+
+    /// @return index of the chunk in chunks cache
+    uint32_t cacheChunk(Chunk* chunk);
+
+    /// @brief Get cache index of the chunk neighbour
+    /// @param index cache index of the chunk
+    /// @param side neighbour side: 0 is -X, 1 is +X, 2 is -Z, 3 is +Z
+    /// @return neighbour chunk cache index or -1 if chunk is not available
+    int32_t getNeighbour(uint32_t index, int side);
+
+    /// @brief Find the neighbour voxel of the entry voxel
+    /// @param direction 0: +Z, 1: -Z, 2: +Y, 3: -Y, 4: +X, 5: -X
+    /// @param chunk (out) cache index of the neighbour voxel chunk
+    /// @param index (out) index of the neighbour voxel in chunk
+    /// @return false if the neighbour voxel is not available
+    inline bool step(
+        const lightentry& entry, int direction, uint32_t& chunk, int& index
+    );
 public:
     LightSolver(const ContentIndices& contentIds, Chunks& chunks, int channel);
 
@@ -26,4 +65,17 @@ public:
     void add(int x, int y, int z, int emission);
     void remove(int x, int y, int z);
     void solve();
+
+    /// @brief Process queued entries touching only the solver channel
+    /// in lightmaps and not modifying chunks flags. Solvers of R, G and
+    /// B, S channels pairs may propagate in different threads
+    void propagate();
+
+    /// @brief Mark chunks changed by propagate() as modified
+    void applyModified();
+
+    /// @return number of queued entries
+    size_t getQueueSize() const {
+        return addqueue.size() + remqueue.size();
+    }
 };
@@ -7,13 +7,19 @@
 #include "voxels/voxel.hpp"
 #include "voxels/Block.hpp"
 #include "constants.hpp"
+#include "util/JobSystem.hpp"
 #include "util/timeutil.hpp"
 #include "debug/Logger.hpp"
 
+#include <algorithm>
 #include <memory>
 
 static debug::Logger logger("lighting");
 
+/// @brief Min number of queued entries in each channels pair to propagate
+/// the pairs in parallel
+static constexpr size_t PARALLEL_MIN_ENTRIES = 1024;
+
 Lighting::Lighting(const Content& content, Chunks& chunks) 
   : content(content), chunks(chunks) {
     auto& indices = *content.getIndices();
@@ -49,7 +55,12 @@ void Lighting::prebuildSkyLight(Chunk& chunk, const ContentIndices& indices) {
     int highestPoint = 0;
     for (int z = 0; z < CHUNK_D; z++){
         for (int x = 0; x < CHUNK_W; x++){
-            for (int y = CHUNK_H-1; y >= 0; y--){
+            int y = CHUNK_H-1;
+            // air above the chunk top
+            for (; y >= chunk.top; y--) {
+                lightmap.setS(x, y, z, 15);
+            }
+            for (; y >= 0; y--){
                 int index = (y * CHUNK_D + z) * CHUNK_W + x;
                 voxel& vox = chunk.voxels[index];
                 const Block* block = blockDefs[vox.id];
@@ -119,21 +130,24 @@ void Lighting::onChunkLoaded(int cx, int cz, bool expand) {
     assert(chunk->lightmap != nullptr);
     auto& lightmap = *chunk->lightmap;
 
-    for (uint y = 0; y < CHUNK_H; y++){
-        for (uint z = 0; z < CHUNK_D; z++){
-            for (uint x = 0; x < CHUNK_W; x++){
-                const voxel& vox = chunk->voxels[(y * CHUNK_D + z) * CHUNK_W + x];
-                const Block* block = blockDefs[vox.id];
-                int gx = x + cx * CHUNK_W;
-                int gz = z + cz * CHUNK_D;
-                if (block->rt.emissive){
-                    solverR.add(gx,y,gz,block->emission[0]);
-                    solverG.add(gx,y,gz,block->emission[1]);
-                    solverB.add(gx,y,gz,block->emission[2]);
+    chunk->forEachSection([&](int s) {
+        uint end = (s + 1) * CHUNK_SECTION_H;
+        for (uint y = s * CHUNK_SECTION_H; y < end; y++){
+            for (uint z = 0; z < CHUNK_D; z++){
+                for (uint x = 0; x < CHUNK_W; x++){
+                    const voxel& vox = chunk->voxels[(y * CHUNK_D + z) * CHUNK_W + x];
+                    const Block* block = blockDefs[vox.id];
+                    int gx = x + cx * CHUNK_W;
+                    int gz = z + cz * CHUNK_D;
+                    if (block->rt.emissive){
+                        solverR.add(gx,y,gz,block->emission[0]);
+                        solverG.add(gx,y,gz,block->emission[1]);
+                        solverB.add(gx,y,gz,block->emission[2]);
+                    }
                 }
             }
         }
-    }
+    });
 
     if (expand) {
         for (int x = 0; x < CHUNK_W; x += CHUNK_W-1) {
@@ -167,10 +181,124 @@ void Lighting::onChunkLoaded(int cx, int cz, bool expand) {
             }
         }
     }
-    solverR.solve();
-    solverG.solve();
-    solverB.solve();
-    solverS.solve();
+    solveChannels();
+}
+
+void Lighting::solveChannels() {
+    auto& solverR = *this->solverR;
+    auto& solverG = *this->solverG;
+    auto& solverB = *this->solverB;
+    auto& solverS = *this->solverS;
+
+    size_t queuedRG = solverR.getQueueSize() + solverG.getQueueSize();
+    size_t queuedBS = solverB.getQueueSize() + solverS.getQueueSize();
+    if (queuedRG < PARALLEL_MIN_ENTRIES || queuedBS < PARALLEL_MIN_ENTRIES) {
+        solverR.solve();
+        solverG.solve();
+        solverB.solve();
+        solverS.solve();
+        return;
+    }
+    // R, G and B, S channels are stored in different bytes of lightmap,
+    // so the pairs are propagated in parallel
+    util::JobSystem::getInstance().parallel(2, [&](size_t pair) {
+        auto& first = pair == 0 ? solverR : solverB;
+        auto& second = pair == 0 ? solverG : solverS;
+        first.propagate();
+        second.propagate();
+    });
+
+    solverR.applyModified();
+    solverG.applyModified();
+    solverB.applyModified();
+    solverS.applyModified();
+}
+
+void Lighting::onBlocksSet(int x, int y, int z, int w, int h, int d) {
+    auto& solverR = *this->solverR;
+    auto& solverG = *this->solverG;
+    auto& solverB = *this->solverB;
+    auto& solverS = *this->solverS;
+
+    const auto& defs = content.getIndices()->blocks;
+    int y1 = std::max(y, 0);
+    int y2 = std::min(y + h, CHUNK_H);
+    if (y1 >= y2 || w <= 0 || d <= 0) {
+        return;
+    }
+    // remove all lights of the box and sky light under it
+    for (int gz = z; gz < z + d; gz++) {
+        for (int gx = x; gx < x + w; gx++) {
+            for (int gy = y1; gy < y2; gy++) {
+                solverR.remove(gx, gy, gz);
+                solverG.remove(gx, gy, gz);
+                solverB.remove(gx, gy, gz);
+                solverS.remove(gx, gy, gz);
+            }
+            for (int gy = y1 - 1; gy >= 0; gy--) {
+                voxel* vox = chunks.get(gx, gy, gz);
+                if (vox == nullptr || vox->id != 0) {
+                    break;
+                }
+                solverS.remove(gx, gy, gz);
+            }
+        }
+    }
+    solveChannels();
+
+    // emission and sky light of the box
+    for (int gz = z; gz < z + d; gz++) {
+        for (int gx = x; gx < x + w; gx++) {
+            for (int gy = y1; gy < y2; gy++) {
+                const voxel* vox = chunks.get(gx, gy, gz);
+                if (vox == nullptr) {
+                    continue;
+                }
+                const auto& block = defs.require(vox->id);
+                if (block.rt.emissive) {
+                    solverR.add(gx, gy, gz, block.emission[0]);
+                    solverG.add(gx, gy, gz, block.emission[1]);
+                    solverB.add(gx, gy, gz, block.emission[2]);
+                }
+            }
+            if (y2 < CHUNK_H && chunks.getLight(gx, y2, gz, 3) != 0xF) {
+                continue;
+            }
+            for (int gy = y2 - 1; gy >= 0; gy--) {
+                const voxel* vox = chunks.get(gx, gy, gz);
+                if (vox == nullptr ||
+                    (gy < y1 ? vox->id != 0
+                             : !defs.require(vox->id).skyLightPassing)) {
+                    break;
+                }
+                solverS.add(gx, gy, gz, 0xF);
+            }
+        }
+    }
+    // lights of the box surroundings
+    auto addNeighbour = [&](int gx, int gy, int gz) {
+        solverR.add(gx, gy, gz);
+        solverG.add(gx, gy, gz);
+        solverB.add(gx, gy, gz);
+        solverS.add(gx, gy, gz);
+    };
+    for (int gy = y1; gy < y2; gy++) {
+        for (int gx = x; gx < x + w; gx++) {
+            addNeighbour(gx, gy, z - 1);
+            addNeighbour(gx, gy, z + d);
+        }
+        for (int gz = z; gz < z + d; gz++) {
+            addNeighbour(x - 1, gy, gz);
+            addNeighbour(x + w, gy, gz);
+        }
+    }
+    for (int gz = z; gz < z + d; gz++) {
+        for (int gx = x; gx < x + w; gx++) {
+            addNeighbour(gx, y1 - 1, gz);
+            addNeighbour(gx, y2, gz);
+        }
+    }
+    solveChannels();
 }
 
 void Lighting::onBlockSet(int x, int y, int z, blockid_t id){
@@ -197,10 +325,7 @@ void Lighting::onBlockSet(int x, int y, int z, blockid_t id){
         solverR->add(x-1,y,z); solverG->add(x-1,y,z); solverB->add(x-1,y,z); solverS->add(x-1,y,z);
         solverR->add(x,y,z+1); solverG->add(x,y,z+1); solverB->add(x,y,z+1); solverS->add(x,y,z+1);
         solverR->add(x,y,z-1); solverG->add(x,y,z-1); solverB->add(x,y,z-1); solverS->add(x,y,z-1);
-        solverR->solve();
-        solverG->solve();
-        solverB->solve();
-        solverS->solve();
+        solveChannels();
     } else {
         if (!block.skyLightPassing){
             solverS->remove(x,y,z);
@@ -15,6 +15,10 @@ class Lighting {
     std::unique_ptr<LightSolver> solverG;
     std::unique_ptr<LightSolver> solverB;
     std::unique_ptr<LightSolver> solverS;
+
+    /// @brief Solve all channels, R, G and B, S pairs in parallel
+    /// if there is enough work
+    void solveChannels();
 public:
     Lighting(const Content& content, Chunks& chunks);
     ~Lighting();
@@ -24,5 +28,15 @@ public:
     void onChunkLoaded(int cx, int cz, bool expand);
     void onBlockSet(int x, int y, int z, blockid_t id);
 
+    /// @brief Update lights of the box of changed blocks in a single pass.
+    /// Faster than onBlockSet for every block of the box
+    /// @param x box origin X
+    /// @param y box origin Y
+    /// @param z box origin Z
+    /// @param w box width
+    /// @param h box height
+    /// @param d box depth
+    void onBlocksSet(int x, int y, int z, int w, int h, int d);
+
     static void prebuildSkyLight(Chunk& chunk, const ContentIndices& indices);
 };
@@ -2,6 +2,7 @@
 
 #include "constants.hpp"
 #include "typedefs.hpp"
+#include "util/data_io.hpp"
 
 #include <memory>
 #include <cstring>
@@ -71,6 +72,23 @@ public:
         map[index] = (map[index] & (0xFFFF & (~(0xF << (channel*4))))) | (value << (channel << 2));
     }
 
+    /// @brief Get channel value reading only the byte containing it
+    inline unsigned char getChannel(int index, int channel) const {
+        auto bytes = reinterpret_cast<const ubyte*>(map);
+        ubyte byte = bytes[index * 2 + channel_byte(channel)];
+        return (byte >> ((channel & 1) << 2)) & 0xF;
+    }
+
+    /// @brief Set channel value writing only the byte containing it.
+    /// R, G and B, S channels pairs are stored in different bytes
+    /// so the pairs may be updated by two threads at the same time
+    inline void setChannel(int index, int channel, int value) {
+        auto bytes = reinterpret_cast<ubyte*>(map);
+        ubyte& byte = bytes[index * 2 + channel_byte(channel)];
+        int shift = (channel & 1) << 2;
+        byte = (byte & ~(0xF << shift)) | (value << shift);
+    }
+
     inline const light_t* getLights() const {
         return map;
     }
@@ -91,4 +109,9 @@ public:
     static std::unique_ptr<light_t[]> decode(const ubyte* buffer);
 
     static inline light_t SUN_LIGHT_ONLY = combine(0U, 0U, 0U, 15U);
+private:
+    /// @return offset of byte containing the channel in light_t
+    static inline int channel_byte(int channel) {
+        return (channel >> 1) ^ dataio::is_big_endian();
+    }
 };
@@ -0,0 +1,207 @@
+#include "ServerLighting.hpp"
+
+#include <cstring>
+#include <unordered_map>
+
+#include "Lighting.hpp"
+#include "Lightmap.hpp"
+#include "content/Content.hpp"
+#include "maths/voxmaths.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+#include "voxels/GlobalChunks.hpp"
+#include "world/Level.hpp"
+
+/// @brief Max batches queued or being lit per worker
+static constexpr size_t MAX_BATCHES_PER_WORKER = 2;
+
+class LightingWorker : public util::Worker<LightingJob, LightingResult> {
+    const Content& content;
+    /// @brief Chunks reused to light batches
+    std::vector<std::shared_ptr<Chunk>> chunksPool;
+public:
+    LightingWorker(const Content& content) : content(content) {
+    }
+
+    LightingResult operator()(const LightingJob& job) override {
+        const auto& indices = *content.getIndices();
+        int size = LIGHTING_BATCH_SIZE + 2;
+        glm::ivec2 origin = job.batch * LIGHTING_BATCH_SIZE - 1;
+
+        Chunks chunks(size, size, 0, 0, nullptr, indices);
+        chunks.setCenter(
+            (origin.x + size / 2) * CHUNK_W, (origin.y + size / 2) * CHUNK_D
+        );
+        for (size_t i = 0; i < job.snapshot.size(); i++) {
+            const auto& [pos, voxels] = job.snapshot[i];
+            if (i == chunksPool.size()) {
+                chunksPool.push_back(std::make_shared<Chunk>(
+                    0, 0, std::make_shared<Lightmap>()
+                ));
+            }
+            auto& chunk = chunksPool[i];
+            chunk->x = pos.x;
+            chunk->z = pos.y;
+            std::memcpy(chunk->voxels, voxels.get(), sizeof(voxel) * CHUNK_VOL);
+            chunk->lightmap->clear();
+            chunk->updateHeights();
+            chunks.putChunk(chunk);
+        }
+        // lights of the batch chunks get all contributions from neighbours
+        // as the light does not spread further than one chunk
+        Lighting lighting(content, chunks);
+        for (size_t i = 0; i < job.snapshot.size(); i++) {
+            Lighting::prebuildSkyLight(*chunksPool[i], indices);
+        }
+        for (size_t i = 0; i < job.snapshot.size(); i++) {
+            const auto& chunk = *chunksPool[i];
+            lighting.buildSkyLight(chunk.x, chunk.z);
+            lighting.onChunkLoaded(chunk.x, chunk.z, false);
+        }
+
+        LightingResult result {job.batch, job.targets, {}};
+        for (const auto& pos : job.targets) {
+            auto lightmap = std::make_shared<Lightmap>();
+            const auto& source = *chunks.getChunk(pos.x, pos.y)->lightmap;
+            lightmap->set(&source);
+            lightmap->highestPoint = source.highestPoint;
+            result.lights.push_back(std::move(lightmap));
+        }
+        return result;
+    }
+};
+
+ServerLighting::ServerLighting(Level& level, int workers)
+    : level(level),
+      voxelsPool(CHUNK_VOL),
+      threadPool(
+          "lighting-pool",
+          [&level]() {
+              return std::make_shared<LightingWorker>(level.content);
+          },
+          [this](LightingResult& result) { apply(result); },
+          workers
+      ) {
+    maxBatches = threadPool.getWorkersCount() * MAX_BATCHES_PER_WORKER;
+}
+
+ServerLighting::~ServerLighting() = default;
+
+void ServerLighting::request(int cx, int cz) {
+    requested.insert({cx, cz});
+}
+
+void ServerLighting::invalidate(int cx, int cz) {
+    for (int oz = -1; oz <= 1; oz++) {
+        for (int ox = -1; ox <= 1; ox++) {
+            auto chunk = level.chunks->getChunk(cx + ox, cz + oz);
+            // chunks being lit use voxels copied before the change.
+            // Other not lit chunks are requested by chunks controller
+            if (chunk && (chunk->flags.lighted ||
+                          isRequested(cx + ox, cz + oz))) {
+                request(cx + ox, cz + oz);
+            }
+        }
+    }
+}
+
+bool ServerLighting::isRequested(int cx, int cz) const {
+    glm::ivec2 pos(cx, cz);
+    return requested.find(pos) != requested.end() ||
+           processing.find(pos) != processing.end();
+}
+
+void ServerLighting::update() {
+    threadPool.update();
+    if (requested.empty()) {
+        return;
+    }
+    std::unordered_map<glm::ivec2, std::vector<glm::ivec2>> pending;
+    for (const auto& pos : requested) {
+        glm::ivec2 batch(
+            floordiv<LIGHTING_BATCH_SIZE>(pos.x),
+            floordiv<LIGHTING_BATCH_SIZE>(pos.y)
+        );
+        // relit after the batch in progress is finished
+        if (batches.find(batch) == batches.end()) {
+            pending[batch].push_back(pos);
+        }
+    }
+    for (auto& [batch, targets] : pending) {
+        if (batches.size() >= maxBatches) {
+            break;
+        }
+        for (const auto& pos : targets) {
+            requested.erase(pos);
+        }
+        submit(batch, std::move(targets));
+    }
+}
+
+void ServerLighting::submit(
+    const glm::ivec2& batch, std::vector<glm::ivec2> targets
+) {
+    const auto& chunks = *level.chunks;
+    LightingJob job {batch, {}, {}};
+    std::unordered_set<glm::ivec2> copied;
+    for (const auto& pos : targets) {
+        auto chunk = chunks.getChunk(pos.x, pos.y);
+        if (chunk == nullptr || chunk->lightmap == nullptr) {
+            continue;
+        }
+        job.targets.push_back(pos);
+        for (int oz = -1; oz <= 1; oz++) {
+            for (int ox = -1; ox <= 1; ox++) {
+                glm::ivec2 neighbour(pos.x + ox, pos.y + oz);
+                if (copied.find(neighbour) != copied.end()) {
+                    continue;
+                }
+                auto source = chunks.getChunk(neighbour.x, neighbour.y);
+                if (source == nullptr) {
+                    continue;
+                }
+                auto voxels = voxelsPool.get();
+                std::memcpy(
+                    voxels.get(), source->voxels, sizeof(voxel) * CHUNK_VOL
+                );
+                job.snapshot.emplace_back(neighbour, std::move(voxels));
+                copied.insert(neighbour);
+            }
+        }
+    }
+    if (job.targets.empty()) {
+        return;
+    }
+    for (const auto& pos : job.targets) {
+        processing.insert(pos);
+    }
+    batches.insert(batch);
+    threadPool.enqueueJob(std::move(job));
+}
+
+void ServerLighting::apply(LightingResult& result) {
+    batches.erase(result.batch);
+    for (size_t i = 0; i < result.targets.size(); i++) {
+        const auto& pos = result.targets[i];
+        processing.erase(pos);
+
+        auto chunk = level.chunks->getChunk(pos.x, pos.y);
+        if (chunk == nullptr || chunk->lightmap == nullptr) {
+            continue;
+        }
+        const auto& lightmap = *result.lights[i];
+        chunk->lightmap->set(&lightmap);
+        chunk->lightmap->highestPoint = lightmap.highestPoint;
+        chunk->flags.loadedLights = false;
+        chunk->flags.lighted = true;
+    }
+}
+
+void ServerLighting::flush() {
+    using namespace std::chrono_literals;
+    update();
+    while (!requested.empty() || !batches.empty()) {
+        std::this_thread::sleep_for(1ms);
+        update();
+    }
+}
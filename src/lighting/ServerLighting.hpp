@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
+
+#include "typedefs.hpp"
+#include "util/BufferPool.hpp"
+#include "util/ThreadPool.hpp"
+#include "voxels/voxel.hpp"
+
+class Level;
+class Lightmap;
+
+/// @brief Lighting batch width and depth (chunk is unit)
+inline constexpr int LIGHTING_BATCH_SIZE = 4;
+
+struct LightingJob {
+    /// @brief Batch position (batch is unit)
+    glm::ivec2 batch;
+    /// @brief Chunks to be lit
+    std::vector<glm::ivec2> targets;
+    /// @brief Copies of voxels of targets and of their neighbours
+    std::vector<std::pair<glm::ivec2, std::shared_ptr<voxel[]>>> snapshot;
+};
+
+struct LightingResult {
+    glm::ivec2 batch;
+    std::vector<glm::ivec2> targets;
+    /// @brief Lights of targets
+    std::vector<std::shared_ptr<Lightmap>> lights;
+};
+
+/// @brief Lights chunks of worlds having no client player (headless server).
+/// Requested chunks are grouped into batches of LIGHTING_BATCH_SIZE^2 chunks.
+/// Each batch is lit from scratch on a worker thread using a copy of the
+/// batch chunks and their neighbours, so results do not depend on chunks
+/// loading order. Lights are applied to chunks in update()
+class ServerLighting {
+    Level& level;
+    /// @brief Chunks waiting to be lit
+    std::unordered_set<glm::ivec2> requested;
+    /// @brief Chunks being lit by workers
+    std::unordered_set<glm::ivec2> processing;
+    /// @brief Batches being lit by workers
+    std::unordered_set<glm::ivec2> batches;
+    /// @brief Voxels copies buffers
+    util::BufferPool<voxel> voxelsPool;
+    util::ThreadPool<LightingJob, LightingResult> threadPool;
+    /// @brief Max number of batches being lit at the same time
+    size_t maxBatches;
+
+    void submit(const glm::ivec2& batch, std::vector<glm::ivec2> targets);
+    void apply(LightingResult& result);
+public:
+    ServerLighting(Level& level, int workers);
+    ~ServerLighting();
+
+    /// @brief Request (re)lighting of the chunk
+    void request(int cx, int cz);
+
+    /// @brief Request relighting of the changed chunk and its neighbours
+    /// which are lit or being lit
+    void invalidate(int cx, int cz);
+
+    /// @return true if the chunk is waiting to be lit or being lit
+    bool isRequested(int cx, int cz) const;
+
+    /// @brief Apply finished batches and submit requested ones
+    void update();
+
+    /// @brief Light all requested chunks, blocking until done
+    void flush();
+};
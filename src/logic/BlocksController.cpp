@@ -1,11 +1,13 @@
 #include "BlocksController.hpp"
 
+#include <algorithm>
 #include <set>
 
 #include "content/Content.hpp"
 #include "items/Inventories.hpp"
 #include "items/Inventory.hpp"
 #include "lighting/Lighting.hpp"
+#include "lighting/ServerLighting.hpp"
 #include "maths/fastmaths.hpp"
 #include "scripting/scripting.hpp"
 #include "util/timeutil.hpp"
@@ -16,13 +18,17 @@
 #include "voxels/blocks_agent.hpp"
 #include "world/Level.hpp"
 #include "world/World.hpp"
+#include "objects/Entities.hpp"
 #include "objects/Player.hpp"
 #include "objects/Players.hpp"
 
-BlocksController::BlocksController(const Level& level, Lighting* lighting)
+BlocksController::BlocksController(
+    const Level& level, Lighting* lighting, ServerLighting* serverLighting
+)
     : level(level),
       chunks(*level.chunks),
       lighting(lighting),
+      serverLighting(serverLighting),
       randTickClock(20, 3),
       blocksTickClock(20, 1),
       worldTickClock(20, 1) {
@@ -69,7 +75,10 @@ void BlocksController::breakBlock(
     blocks_agent::set(chunks, x, y, z, 0, {});
     if (lighting) {
         lighting->onBlockSet(x, y, z, 0);
+    } else if (serverLighting) {
+        serverLighting->invalidate(floordiv<CHUNK_W>(x), floordiv<CHUNK_D>(z));
     }
+    wakeUpBodies(def, x, y, z);
     scripting::on_block_broken(player, def, glm::ivec3(x, y, z));
     if (def.rt.extended) {
         updateSides(x, y, z , def.size.x, def.size.y, def.size.z);
@@ -94,7 +103,10 @@ void BlocksController::placeBlock(
     blocks_agent::set(chunks, x, y, z, def.rt.id, state);
     if (lighting) {
         lighting->onBlockSet(x, y, z, def.rt.id);
+    } else if (serverLighting) {
+        serverLighting->invalidate(floordiv<CHUNK_W>(x), floordiv<CHUNK_D>(z));
     }
+    wakeUpBodies(def, x, y, z);
     scripting::on_block_placed(player, def, glm::ivec3(x, y, z));
     if (def.rt.extended) {
         updateSides(x, y, z , def.size.x, def.size.y, def.size.z);
@@ -103,6 +115,13 @@ void BlocksController::placeBlock(
     }
 }
 
+void BlocksController::wakeUpBodies(const Block& def, int x, int y, int z) {
+    // extended blocks may be rotated
+    float size = std::max({def.size.x, def.size.y, def.size.z});
+    glm::vec3 pos(x, y, z);
+    level.entities->wakeUpBodies(AABB(pos - size, pos + size + 1.0f));
+}
+
 void BlocksController::updateBlock(int x, int y, int z) {
     voxel* vox = blocks_agent::get(chunks, x, y, z);
     if (vox == nullptr) return;
@@ -148,24 +167,27 @@ void BlocksController::randomTick(
     const Chunk& chunk, int segments, const ContentIndices* indices
 ) {
     const int segheight = CHUNK_H / segments;
+    // same density of random updates as 4 per segment
+    const int perSection = std::max(1, 4 * CHUNK_SECTION_H / segheight);
 
-    for (int s = 0; s < segments; s++) {
-        for (int i = 0; i < 4; i++) {
+    chunk.forEachSection([&](int s) {
+        for (int i = 0; i < perSection; i++) {
             int bx = random.rand() % CHUNK_W;
-            int by = random.rand() % segheight + s * segheight;
+            int by = random.rand() % CHUNK_SECTION_H + s * CHUNK_SECTION_H;
             int bz = random.rand() % CHUNK_D;
             const voxel& vox = chunk.voxels[vox_index(bx, by, bz)];
             auto& block = indices->blocks.require(vox.id);
-            if (block.rt.funcsset.randupdate) {
-                scripting::random_update_block(
-                    block,
-                    glm::ivec3(
-                        chunk.x * CHUNK_W + bx, by, chunk.z * CHUNK_D + bz
-                    )
-                );
+            glm::ivec3 pos(chunk.x * CHUNK_W + bx, by, chunk.z * CHUNK_D + bz);
+            if (block.rt.funcsset.randupdates) {
+                if (randomUpdates.size() <= vox.id) {
+                    randomUpdates.resize(indices->blocks.count());
+                }
+                randomUpdates[vox.id].push_back(pos);
+            } else if (block.rt.funcsset.randupdate) {
+                scripting::random_update_block(block, pos);
             }
         }
-    }
+    });
 }
 
 void BlocksController::randomTick(int tickid, int parts, uint padding) {
@@ -205,6 +227,18 @@ void BlocksController::randomTick(int tickid, int parts, uint padding) {
             }
         }
     }
+    flushRandomUpdates(indices);
+}
+
+void BlocksController::flushRandomUpdates(const ContentIndices* indices) {
+    for (size_t id = 0; id < randomUpdates.size(); id++) {
+        auto& positions = randomUpdates[id];
+        if (positions.empty()) {
+            continue;
+        }
+        scripting::random_update_blocks(indices->blocks.require(id), positions);
+        positions.clear();
+    }
 }
 
 int64_t BlocksController::createBlockInventory(int x, int y, int z) {
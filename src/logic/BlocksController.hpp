@@ -1,6 +1,7 @@
 #pragma once
 
 #include <functional>
+#include <vector>
 #include <glm/glm.hpp>
 
 #include "maths/fastmaths.hpp"
@@ -14,6 +15,7 @@ class Level;
 class Chunk;
 class Chunks;
 class Lighting;
+class ServerLighting;
 class GlobalChunks;
 class ContentIndices;
 
@@ -28,18 +30,31 @@ class BlocksController {
     const Level& level;
     GlobalChunks& chunks;
     Lighting* lighting;
+    ServerLighting* serverLighting;
     util::Clock randTickClock;
     util::Clock blocksTickClock;
     util::Clock worldTickClock;
     FastRandom random {};
     std::vector<on_block_interaction> blockInteractionCallbacks;
+    /// @brief Random-ticked positions collected for blocks defining batched
+    /// random update, indexed by block id
+    std::vector<std::vector<glm::ivec3>> randomUpdates;
+
+    void flushRandomUpdates(const ContentIndices* indices);
 public:
-    BlocksController(const Level& level, Lighting* lighting);
+    BlocksController(
+        const Level& level,
+        Lighting* lighting,
+        ServerLighting* serverLighting = nullptr
+    );
 
     void updateSides(int x, int y, int z);
     void updateSides(int x, int y, int z, int w, int h, int d);
     void updateBlock(int x, int y, int z);
 
+    /// @brief Wake up sleeping bodies around the changed block
+    void wakeUpBodies(const Block& def, int x, int y, int z);
+
     void breakBlock(Player* player, const Block& def, int x, int y, int z);
     void placeBlock(
         Player* player, const Block& def, blockstate state, int x, int y, int z
@@ -1,15 +1,19 @@
 #include "ChunksController.hpp"
 
 #include <limits.h>
+#include <cstring>
 #include <memory>
 
 #include "content/Content.hpp"
 #include "world/files/WorldFiles.hpp"
 #include "graphics/core/Mesh.hpp"
 #include "lighting/Lighting.hpp"
+#include "lighting/ServerLighting.hpp"
 #include "maths/voxmaths.hpp"
 #include "util/timeutil.hpp"
 #include "objects/Player.hpp"
+#include "physics/Hitbox.hpp"
+#include "objects/Players.hpp"
 #include "voxels/Block.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/Chunks.hpp"
@@ -17,34 +21,75 @@
 #include "world/Level.hpp"
 #include "world/LevelEvents.hpp"
 #include "world/World.hpp"
+#include "world/files/WorldRegions.hpp"
 #include "world/generator/WorldGenerator.hpp"
+#include "settings.hpp"
 
 const uint MAX_WORK_PER_FRAME = 128;
 const uint MIN_SURROUNDING = 9;
+const uint MAX_PENDING_PER_WORKER = 4;
+/// @brief Min horizontal speed to read regions ahead of the player
+const float PREFETCH_MIN_SPEED = 1.0f;
 
-ChunksController::ChunksController(Level& level)
+class GeneratorWorker : public util::Worker<GeneratorJob, GeneratorResult> {
+    const WorldGenerator& generator;
+    util::BufferPool<voxel>& voxelsPool;
+public:
+    GeneratorWorker(
+        const WorldGenerator& generator, util::BufferPool<voxel>& voxelsPool
+    )
+        : generator(generator), voxelsPool(voxelsPool) {
+    }
+
+    GeneratorResult operator()(const GeneratorJob& job) override {
+        auto voxels = voxelsPool.get();
+        generator.generate(voxels.get(), *job.prototype, job.x, job.z);
+        return GeneratorResult {job.x, job.z, std::move(voxels)};
+    }
+};
+
+ChunksController::ChunksController(
+    Level& level, const EngineSettings& settings
+)
     : level(level),
       generator(std::make_unique<WorldGenerator>(
           level.content.generators.require(level.getWorld()->getGenerator()),
           level.content,
           level.getWorld()->getSeed()
-      )) {}
+      )),
+      voxelsPool(CHUNK_VOL),
+      threadPool(
+          "chunks-gen-pool",
+          [this]() {
+              return std::make_shared<GeneratorWorker>(
+                  *generator, voxelsPool
+              );
+          },
+          [this](GeneratorResult& result) {
+              applyGenerated(result);
+          },
+          settings.chunks.generatorWorkers.get()
+      ) {
+    maxPending = threadPool.getWorkersCount() * MAX_PENDING_PER_WORKER;
+}
 
 ChunksController::~ChunksController() = default;
 
 void ChunksController::update(
     int64_t maxDuration, int loadDistance, uint padding, Player& player
-) const {
+) {
+    threadPool.update();
+
     const auto& position = player.getPosition();
     int centerX = floordiv<CHUNK_W>(glm::floor(position.x));
     int centerY = floordiv<CHUNK_D>(glm::floor(position.z));
     
     if (player.isLoadingChunks()) {
-        /// FIXME: one generator for multiple players
-        generator->update(centerX, centerY, loadDistance);
+        generator->update(player.getId(), centerX, centerY, loadDistance);
     } else {
         return;
     }
+    prefetchRegions(player, loadDistance);
 
     int64_t mcstotal = 0;
 
@@ -61,6 +106,41 @@ void ChunksController::update(
     }
 }
 
+void ChunksController::prefetchRegions(Player& player, int loadDistance) {
+    auto& regions = level.getWorld()->wfile->getRegions();
+    glm::vec3 position = player.getPosition();
+    regions.prefetch(
+        floordiv<CHUNK_W>(glm::floor(position.x)),
+        floordiv<CHUNK_D>(glm::floor(position.z))
+    );
+    auto hitbox = player.getHitbox();
+    if (hitbox == nullptr) {
+        return;
+    }
+    glm::vec2 velocity(hitbox->velocity.x, hitbox->velocity.z);
+    if (glm::length(velocity) < PREFETCH_MIN_SPEED) {
+        return;
+    }
+    // region the player is moving to
+    glm::vec2 ahead = glm::vec2(position.x, position.z) +
+                      glm::normalize(velocity) *
+                          static_cast<float>(loadDistance * CHUNK_W);
+    regions.prefetch(
+        floordiv<CHUNK_W>(static_cast<int>(glm::floor(ahead.x))),
+        floordiv<CHUNK_D>(static_cast<int>(glm::floor(ahead.y)))
+    );
+}
+
+void ChunksController::releaseUnusedAreas() {
+    for (int64_t id : generator->getAreas()) {
+        auto player = level.players->get(id);
+        if (player == nullptr || player->isSuspended() ||
+            !player->isLoadingChunks()) {
+            generator->removeArea(id);
+        }
+    }
+}
+
 bool ChunksController::isInLoadingZone(
     const Player& player, uint padding, int x, int z
 ) const {
@@ -77,7 +157,7 @@ bool ChunksController::isInLoadingZone(
     return distance < minDistance;
 }
 
-bool ChunksController::loadVisible(const Player& player, uint padding) const {
+bool ChunksController::loadVisible(const Player& player, uint padding) {
     auto& chunks = *player.chunks;
     int sizeX = chunks.getWidth();
     int sizeY = chunks.getHeight();
@@ -120,7 +200,9 @@ bool ChunksController::loadVisible(const Player& player, uint padding) const {
                 continue;
             }
 
-            if (distance < minDistance) {
+            if (distance < minDistance &&
+                pending.find({x + chunks.getOffsetX(),
+                              z + chunks.getOffsetY()}) == pending.end()) {
                 minDistance = distance;
                 nearX = x;
                 nearZ = z;
@@ -130,7 +212,8 @@ bool ChunksController::loadVisible(const Player& player, uint padding) const {
     }
 
     const auto& chunk = chunks.getChunks()[nearZ * sizeX + nearX];
-    if (chunk != nullptr || !assigned || !player.isLoadingChunks()) {
+    if (chunk != nullptr || !assigned || !player.isLoadingChunks() ||
+        pending.size() >= maxPending) {
         return false;
     }
     int offsetX = chunks.getOffsetX();
@@ -150,6 +233,14 @@ bool ChunksController::buildLights(
         }
     }
     if (surrounding == MIN_SURROUNDING) {
+        if (serverLighting && chunk->lightmap && !chunk->flags.loadedLights) {
+            if (serverLighting->isRequested(chunk->x, chunk->z)) {
+                return false;
+            }
+            // flags.lighted is set when lights are applied
+            serverLighting->request(chunk->x, chunk->z);
+            return true;
+        }
         if (lighting && chunk->lightmap) {
             bool lightsCache = chunk->flags.loadedLights;
             if (!lightsCache) {
@@ -163,20 +254,56 @@ bool ChunksController::buildLights(
     return false;
 }
 
-void ChunksController::createChunk(const Player& player, int x, int z) const {
+void ChunksController::createChunk(const Player& player, int x, int z) {
     if (!player.isLoadingChunks()) {
         if (auto chunk = level.chunks->fetch(x, z)) {
             player.chunks->putChunk(chunk);
         }
         return;
     }
-    auto chunk = level.chunks->create(x, z, lighting != nullptr);
+    auto chunk = level.chunks->create(
+        x, z, lighting != nullptr || serverLighting != nullptr
+    );
+    if (!chunk->flags.loaded) {
+        // chunk stays hidden from the level until generated
+        level.chunks->erase(x, z);
+        pending[{x, z}] = chunk;
+        threadPool.enqueueJob(GeneratorJob {x, z, generator->prepare(x, z)});
+        return;
+    }
     player.chunks->putChunk(chunk);
-    auto& chunkFlags = chunk->flags;
-    if (!chunkFlags.loaded) {
-        generator->generate(chunk->voxels, x, z);
-        chunkFlags.unsaved = true;
+    finishChunk(chunk);
+}
+
+void ChunksController::applyGenerated(GeneratorResult& result) {
+    const auto& found = pending.find({result.x, result.z});
+    if (found == pending.end()) {
+        return;
     }
+    auto chunk = std::move(found->second);
+    pending.erase(found);
+
+    std::memcpy(
+        chunk->voxels, result.voxels.get(), sizeof(voxel) * CHUNK_VOL
+    );
+    chunk->flags.unsaved = true;
+
+    bool shown = false;
+    for (const auto& [_, player] : *level.players) {
+        if (player->chunks && player->isLoadingChunks()) {
+            shown = player->chunks->putChunk(chunk) || shown;
+        }
+    }
+    if (!shown) {
+        // out of all loading zones, will be generated again if needed
+        return;
+    }
+    level.chunks->putChunk(chunk);
+    finishChunk(chunk);
+}
+
+void ChunksController::finishChunk(const std::shared_ptr<Chunk>& chunk) const {
+    auto& chunkFlags = chunk->flags;
     chunk->updateHeights();
     level.events->trigger(LevelEventType::CHUNK_PRESENT, chunk.get());
     if (!chunkFlags.loadedLights && chunk->lightmap) {
@@ -1,36 +1,77 @@
 #pragma once
 
 #include <memory>
+#include <unordered_map>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
 
 #include "typedefs.hpp"
+#include "util/BufferPool.hpp"
+#include "util/ThreadPool.hpp"
+#include "voxels/voxel.hpp"
 
 class Level;
 class Chunk;
 class Chunks;
 class Player;
 class Lighting;
+class ServerLighting;
 class WorldGenerator;
+struct ChunkPrototype;
+struct EngineSettings;
+
+struct GeneratorJob {
+    int x, z;
+    std::shared_ptr<const ChunkPrototype> prototype;
+};
+
+struct GeneratorResult {
+    int x, z;
+    std::shared_ptr<voxel[]> voxels;
+};
 
 /// @brief ChunksController manages chunks dynamic loading/unloading
 class ChunksController {
 private:
     Level& level;
     std::unique_ptr<WorldGenerator> generator;
+    /// @brief Voxel buffers used by generator workers
+    util::BufferPool<voxel> voxelsPool;
+    /// @brief Chunks being generated. Not available in GlobalChunks until
+    /// the generator result is applied
+    std::unordered_map<glm::ivec2, std::shared_ptr<Chunk>> pending;
+    util::ThreadPool<GeneratorJob, GeneratorResult> threadPool;
+    /// @brief Max number of chunks being generated at the same time
+    uint maxPending;
 
     /// @brief Process one chunk: load it or calculate lights for it
-    bool loadVisible(const Player& player, uint padding) const;
+    bool loadVisible(const Player& player, uint padding);
+
+    /// @brief Request reading of the player region and of the region
+    /// the player is moving to
+    void prefetchRegions(Player& player, int loadDistance);
     bool buildLights(const Player& player, const std::shared_ptr<Chunk>& chunk) const;
-    void createChunk(const Player& player, int x, int y) const;
+    void createChunk(const Player& player, int x, int y);
+    void finishChunk(const std::shared_ptr<Chunk>& chunk) const;
+    void applyGenerated(GeneratorResult& result);
 public:
     std::unique_ptr<Lighting> lighting;
+    /// @brief Lighting of worlds having no client player
+    std::unique_ptr<ServerLighting> serverLighting;
 
-    ChunksController(Level& level);
+    ChunksController(Level& level, const EngineSettings& settings);
     ~ChunksController();
 
     /// @param maxDuration milliseconds reserved for chunks loading
     void update(
         int64_t maxDuration, int loadDistance, uint padding, Player& player
-    ) const;
+    );
+
+    /// @brief Remove generator loading areas of removed, suspended and
+    /// not loading chunks players
+    void releaseUnusedAreas();
 
     bool isInLoadingZone(const Player& player, uint padding, int x, int z) const;
 
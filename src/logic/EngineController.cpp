@@ -302,6 +302,8 @@ void EngineController::setLocalPlayer(int64_t player) {
 
 void EngineController::reopenWorld(World* world) {
     std::string name = world->wfile->getFolder().name();
+    // region files must be completely written before reading them again
+    world->wfile->getRegions().flush();
     engine.onWorldClosed();
     openWorld(name, true);
 }
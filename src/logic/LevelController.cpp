@@ -14,6 +14,7 @@
 #include "voxels/Pathfinding.hpp"
 #include "scripting/scripting.hpp"
 #include "lighting/Lighting.hpp"
+#include "lighting/ServerLighting.hpp"
 #include "settings.hpp"
 #include "world/LevelEvents.hpp"
 #include "world/Level.hpp"
@@ -26,7 +27,7 @@ LevelController::LevelController(
 )
     : settings(engine->getSettings()),
       level(std::move(levelPtr)),
-      chunks(std::make_unique<ChunksController>(*level)),
+      chunks(std::make_unique<ChunksController>(*level, settings)),
       playerTickClock(20, 3) {
     
     level->events->listen(LevelEventType::CHUNK_PRESENT, [](auto, Chunk* chunk) {
@@ -40,9 +41,13 @@ LevelController::LevelController(
         chunks->lighting = std::make_unique<Lighting>(
             level->content, *clientPlayer->chunks
         );
+    } else {
+        chunks->serverLighting = std::make_unique<ServerLighting>(
+            *level, settings.chunks.lightingWorkers.get()
+        );
     }
     blocks = std::make_unique<BlocksController>(
-        *level, chunks ? chunks->lighting.get() : nullptr
+        *level, chunks->lighting.get(), chunks->serverLighting.get()
     );
     scripting::on_world_load(this);
 
@@ -92,6 +97,10 @@ void LevelController::update(float delta, bool pause) {
             *player
         );
     }
+    chunks->releaseUnusedAreas();
+    if (chunks->serverLighting) {
+        chunks->serverLighting->update();
+    }
     if (!pause) {
         // update all objects that needed
         blocks->update(delta, settings.chunks.padding.get());
@@ -123,6 +132,10 @@ void LevelController::update(float delta, bool pause) {
 
 void LevelController::processBeforeQuit() {
     preQuitCallbacks.notify();
+    if (chunks->serverLighting) {
+        // not lit chunks are not saved
+        chunks->serverLighting->flush();
+    }
     // todo: move somewhere else
     for (auto player : level->players->getAll()) {
         if (player->chunks) {
@@ -147,6 +160,7 @@ void LevelController::saveWorld() {
 
 void LevelController::onWorldQuit() {
     scripting::on_world_quit();
+    level->getWorld()->wfile->getRegions().flush();
 }
 
 Level* LevelController::getLevel() {
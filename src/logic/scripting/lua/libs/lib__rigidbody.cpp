@@ -41,6 +41,8 @@ static int l_get_size(lua::State* L) {
 static int l_set_size(lua::State* L) {
     if (auto entity = get_entity(L, 1)) {
         entity->getRigidbody().hitbox.halfsize = lua::tovec3(L, 2) * 0.5f;
+        entity->getRigidbody().hitbox.wakeUp();
+        scripting::controller->getLevel()->entities->updateIndex(*entity);
     }
     return 0;
 }
@@ -60,6 +62,7 @@ static int l_set_gravity_scale(lua::State* L) {
         } else {
             hitbox.gravityScale = lua::tonumber(L, 2);
         }
+        hitbox.wakeUp();
     }
     return 0;
 }
@@ -132,6 +135,7 @@ static int l_set_body_type(lua::State* L) {
                 "unknown body type " + util::quote(lua::tostring(L, 2))
             );
         }
+        entity->getRigidbody().hitbox.wakeUp();
     }
     return 0;
 }
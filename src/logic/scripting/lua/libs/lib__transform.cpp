@@ -12,6 +12,8 @@ static int l_set_pos(lua::State* L) {
         auto vec = lua::tovec3(L, 2);
         entity->getTransform().setPos(vec);
         entity->getRigidbody().hitbox.position = vec;
+        entity->getRigidbody().hitbox.wakeUp();
+        scripting::controller->getLevel()->entities->updateIndex(*entity);
     }
     return 0;
 }
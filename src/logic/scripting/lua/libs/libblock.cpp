@@ -1,8 +1,11 @@
 #define VC_ENABLE_REFLECTION
+#include <climits>
+
 #include "content/Content.hpp"
 #include "content/ContentLoader.hpp"
 #include "content/ContentControl.hpp"
 #include "lighting/Lighting.hpp"
+#include "lighting/ServerLighting.hpp"
 #include "logic/BlocksController.hpp"
 #include "logic/LevelController.hpp"
 #include "objects/Players.hpp"
@@ -14,6 +17,8 @@
 #include "voxels/blocks_agent.hpp"
 #include "world/Level.hpp"
 #include "maths/voxmaths.hpp"
+#include "maths/aabb.hpp"
+#include "objects/Entities.hpp"
 #include "data/StructLayout.hpp"
 #include "engine/Engine.hpp"
 #include "api_lua.hpp"
@@ -104,6 +109,9 @@ static int l_set(lua::State* L) {
     if (!blocks_agent::set(*level->chunks, x, y, z, id, int2blockstate(state))) {
         return 0;
     }
+    if (blocks) {
+        blocks->wakeUpBodies(indices->blocks.require(id), x, y, z);
+    }
 
     auto chunksController = controller->getChunksController();
     if (chunksController == nullptr) {
@@ -112,6 +120,10 @@ static int l_set(lua::State* L) {
     if (chunksController->lighting) {
         Lighting& lighting = *chunksController->lighting;
         lighting.onBlockSet(x, y, z, id);
+    } else if (chunksController->serverLighting) {
+        chunksController->serverLighting->invalidate(
+            floordiv<CHUNK_W>(x), floordiv<CHUNK_D>(z)
+        );
     }
     if (!noupdate) {
         blocks->updateSides(x, y, z);
@@ -128,6 +140,196 @@ static int l_get(lua::State* L) {
     return lua::pushinteger(L, id);
 }
 
+/// @brief Id written for voxels of unloaded chunks in a region bytearray.
+/// Voxels with this id are skipped by set_region
+static constexpr blockid_t REGION_VOID_ID = 0xFFFF;
+/// @brief Region bytearray voxel size: 16 bit id and 16 bit state (LE)
+static constexpr size_t REGION_VOXEL_SIZE = 4;
+
+struct VoxelsRegion {
+    int x, y, z;
+    int w, h, d;
+
+    size_t volume() const {
+        return static_cast<size_t>(w) * h * d;
+    }
+};
+
+static VoxelsRegion require_region(lua::State* L) {
+    VoxelsRegion region {
+        static_cast<int>(lua::tointeger(L, 1)),
+        static_cast<int>(lua::tointeger(L, 2)),
+        static_cast<int>(lua::tointeger(L, 3)),
+        static_cast<int>(lua::tointeger(L, 4)),
+        static_cast<int>(lua::tointeger(L, 5)),
+        static_cast<int>(lua::tointeger(L, 6)),
+    };
+    if (region.w <= 0 || region.h <= 0 || region.d <= 0) {
+        throw std::runtime_error("region size must be positive");
+    }
+    return region;
+}
+
+/// @brief Call func(chunk, lx, y, lz, index) for each voxel of the region
+/// in loaded chunks. Every chunk is looked up once.
+/// @param index voxel index in the region ((y * d + z) * w + x)
+template <typename Func>
+static void foreach_region_voxel(const VoxelsRegion& region, Func func) {
+    int y1 = std::max(region.y, 0);
+    int y2 = std::min(region.y + region.h, CHUNK_H);
+    int cx1 = floordiv<CHUNK_W>(region.x);
+    int cz1 = floordiv<CHUNK_D>(region.z);
+    int cx2 = floordiv<CHUNK_W>(region.x + region.w - 1);
+    int cz2 = floordiv<CHUNK_D>(region.z + region.d - 1);
+    for (int cz = cz1; cz <= cz2; cz++) {
+        for (int cx = cx1; cx <= cx2; cx++) {
+            auto chunk = blocks_agent::get_chunk(*level->chunks, cx, cz);
+            if (chunk == nullptr) {
+                continue;
+            }
+            int ox = cx * CHUNK_W - region.x;
+            int oz = cz * CHUNK_D - region.z;
+            int lx1 = std::max(-ox, 0);
+            int lz1 = std::max(-oz, 0);
+            int lx2 = std::min(region.w - ox, CHUNK_W);
+            int lz2 = std::min(region.d - oz, CHUNK_D);
+            for (int y = y1; y < y2; y++) {
+                for (int lz = lz1; lz < lz2; lz++) {
+                    size_t index =
+                        (static_cast<size_t>(y - region.y) * region.d + lz +
+                         oz) * region.w + ox;
+                    for (int lx = lx1; lx < lx2; lx++) {
+                        func(*chunk, lx, y, lz, index + lx);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static int l_get_region(lua::State* L) {
+    auto region = require_region(L);
+    std::vector<ubyte> bytes(region.volume() * REGION_VOXEL_SIZE, 0xFF);
+    foreach_region_voxel(
+        region, [&bytes](Chunk& chunk, int lx, int y, int lz, size_t index) {
+            const auto& vox = chunk.voxels[vox_index(lx, y, lz)];
+            auto state = blockstate2int(vox.state);
+            ubyte* dst = bytes.data() + index * REGION_VOXEL_SIZE;
+            dst[0] = vox.id & 0xFF;
+            dst[1] = vox.id >> 8;
+            dst[2] = state & 0xFF;
+            dst[3] = state >> 8;
+        }
+    );
+    return lua::create_bytearray(L, std::move(bytes));
+}
+
+static int l_set_region(lua::State* L) {
+    auto region = require_region(L);
+    auto bytes = lua::bytearray_as_string(L, 7);
+    bool noupdate = lua::toboolean(L, 8);
+    if (bytes.size() != region.volume() * REGION_VOXEL_SIZE) {
+        throw std::runtime_error(
+            "invalid region data size " + std::to_string(bytes.size()) +
+            ", expected " + std::to_string(region.volume() * REGION_VOXEL_SIZE)
+        );
+    }
+    auto src = reinterpret_cast<const ubyte*>(bytes.data());
+    size_t blocksCount = indices->blocks.count();
+
+    std::vector<glm::ivec3> changed;
+    std::vector<Chunk*> touchedChunks;
+    // bounding box of changed blocks
+    glm::ivec3 changedMin(INT_MAX);
+    glm::ivec3 changedMax(INT_MIN);
+    float maxSize = 1.0f;
+    foreach_region_voxel(
+        region, [&](Chunk& chunk, int lx, int y, int lz, size_t index) {
+            const ubyte* data = src + index * REGION_VOXEL_SIZE;
+            blockid_t id = data[0] | (data[1] << 8);
+            blockstate_t state = data[2] | (data[3] << 8);
+            if (id == REGION_VOID_ID || id >= blocksCount) {
+                return;
+            }
+            const auto& vox = chunk.voxels[vox_index(lx, y, lz)];
+            if (vox.id == id && blockstate2int(vox.state) == state) {
+                return;
+            }
+            glm::ivec3 pos(
+                chunk.x * CHUNK_W + lx, y, chunk.z * CHUNK_D + lz
+            );
+            blocks_agent::set(
+                *level->chunks, pos.x, pos.y, pos.z, id, int2blockstate(state)
+            );
+            changed.push_back(pos);
+            changedMin = glm::min(changedMin, pos);
+            changedMax = glm::max(changedMax, pos);
+            // voxels of a chunk are visited in a row
+            if (touchedChunks.empty() || touchedChunks.back() != &chunk) {
+                touchedChunks.push_back(&chunk);
+            }
+            const auto& size = indices->blocks.require(id).size;
+            maxSize = std::max(
+                {maxSize,
+                 static_cast<float>(size.x),
+                 static_cast<float>(size.y),
+                 static_cast<float>(size.z)}
+            );
+        }
+    );
+    if (changed.empty()) {
+        return lua::pushinteger(L, 0);
+    }
+    // bodies resting on or near replaced blocks
+    glm::vec3 a(region.x, region.y, region.z);
+    glm::vec3 b(region.w, region.h, region.d);
+    level->entities->wakeUpBodies(AABB(a - maxSize, a + b + maxSize));
+
+    auto chunksController = controller->getChunksController();
+    if (chunksController == nullptr) {
+        return lua::pushinteger(L, changed.size());
+    }
+    if (chunksController->lighting) {
+        // lights are updated once for the whole changed box
+        glm::ivec3 size = changedMax - changedMin + 1;
+        chunksController->lighting->onBlocksSet(
+            changedMin.x, changedMin.y, changedMin.z, size.x, size.y, size.z
+        );
+    } else if (chunksController->serverLighting) {
+        for (const auto chunk : touchedChunks) {
+            chunksController->serverLighting->invalidate(chunk->x, chunk->z);
+        }
+    }
+    if (!noupdate) {
+        // every neighbour of changed blocks is updated once
+        int w = region.w + 2;
+        int h = region.h + 2;
+        int d = region.d + 2;
+        std::vector<bool> marked(static_cast<size_t>(w) * h * d);
+        for (const auto& pos : changed) {
+            int x = pos.x - region.x + 1;
+            int y = pos.y - region.y + 1;
+            int z = pos.z - region.z + 1;
+            size_t index = (static_cast<size_t>(y) * d + z) * w + x;
+            marked[index - 1] = marked[index + 1] = true;
+            marked[index - w] = marked[index + w] = true;
+            marked[index - w * d] = marked[index + w * d] = true;
+        }
+        for (int y = 0; y < h; y++) {
+            for (int z = 0; z < d; z++) {
+                for (int x = 0; x < w; x++) {
+                    if (marked[(static_cast<size_t>(y) * d + z) * w + x]) {
+                        blocks->updateBlock(
+                            region.x + x - 1, region.y + y - 1, region.z + z - 1
+                        );
+                    }
+                }
+            }
+        }
+    }
+    return lua::pushinteger(L, changed.size());
+}
+
 template<int n>
 static int get_axis(lua::State* L, const Block& def, int rotation) {
     const CoordSystem& rot = def.rotations.variants[rotation];
@@ -751,6 +953,8 @@ const luaL_Reg blocklib[] = {
     {"is_replaceable_at", lua::wrap<l_is_replaceable_at>},
     {"set", lua::wrap<l_set>},
     {"get", lua::wrap<l_get>},
+    {"get_region", lua::wrap<l_get_region>},
+    {"set_region", lua::wrap<l_set_region>},
     {"get_X", lua::wrap<l_get_x>},
     {"get_Y", lua::wrap<l_get_y>},
     {"get_Z", lua::wrap<l_get_z>},
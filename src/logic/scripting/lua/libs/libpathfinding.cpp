@@ -48,7 +48,7 @@ static int l_make_route(lua::State* L) {
     if (auto agent = get_agent(L)) {
         auto start = lua::tovec3(L, 2);
         auto target = lua::tovec3(L, 3);
-        agent->state = {};
+        agent->state.reset();
         agent->start = glm::floor(start);
         agent->target = target;
         auto route = level->pathfinding->perform(*agent);
@@ -64,7 +64,7 @@ static int l_make_route_async(lua::State* L) {
     if (auto agent = get_agent(L)) {
         auto start = lua::tovec3(L, 2);
         auto target = lua::tovec3(L, 3);
-        agent->state = {};
+        agent->state.reset();
         agent->start = glm::floor(start);
         agent->target = target;
         level->pathfinding->perform(*agent, 0);
@@ -100,6 +100,13 @@ static int l_set_jump_height(lua::State* L) {
     return 0;
 }
 
+static int l_set_hierarchical(lua::State* L) {
+    if (auto agent = get_agent(L)) {
+        agent->hierarchical = lua::toboolean(L, 2);
+    }
+    return 0;
+}
+
 static int l_avoid_tag(lua::State* L) {
     if (auto agent = get_agent(L)) {
         int index =
@@ -125,6 +132,7 @@ const luaL_Reg pathfindinglib[] = {
     {"pull_route", lua::wrap<l_pull_route>},
     {"set_max_visited", lua::wrap<l_set_max_visited_blocks>},
     {"set_jump_height", lua::wrap<l_set_jump_height>},
+    {"set_hierarchical", lua::wrap<l_set_hierarchical>},
     {"avoid_tag", lua::wrap<l_avoid_tag>},
     {nullptr, nullptr}
 };
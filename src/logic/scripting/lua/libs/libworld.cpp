@@ -13,6 +13,7 @@
 #include "engine/EnginePaths.hpp"
 #include "io/io.hpp"
 #include "lighting/Lighting.hpp"
+#include "lighting/ServerLighting.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/Chunks.hpp"
 #include "voxels/GlobalChunks.hpp"
@@ -164,7 +165,7 @@ static void integrate_chunk_client(Chunk& chunk) {
                 continue;
             }
             if (auto other = level->chunks->getChunk(x + lx, z + lz)) {
-                other->flags.modified = true;
+                other->setModified();
             }
         }
     }
@@ -189,7 +190,11 @@ static int l_set_chunk_data(lua::State* L) {
         buffer.size(),
         *content->getIndices()
     );
-    if (controller->getChunksController()->lighting == nullptr) {
+    auto chunksController = controller->getChunksController();
+    if (chunksController->serverLighting) {
+        chunksController->serverLighting->invalidate(x, z);
+    }
+    if (chunksController->lighting == nullptr) {
         return lua::pushboolean(L, true);
     }
     integrate_chunk_client(*chunk);
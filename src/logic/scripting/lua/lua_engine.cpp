@@ -2,6 +2,7 @@
 
 #include <iomanip>
 #include <iostream>
+#include <unordered_map>
 
 #include "io/io.hpp"
 #include "engine/EnginePaths.hpp"
@@ -17,6 +18,10 @@
 
 static debug::Logger logger("lua-state");
 static lua::State* main_thread = nullptr;
+/// @brief Event names registry references
+static std::unordered_map<std::string, int> interned_events;
+/// @brief events.emit function registry reference
+static int events_emit_ref = LUA_NOREF;
 
 using namespace lua;
 
@@ -146,6 +151,8 @@ void lua::initialize(const EnginePaths& paths, const CoreParameters& params) {
 
 void lua::finalize() {
     lua::close(main_thread);
+    interned_events.clear();
+    events_emit_ref = LUA_NOREF;
 }
 
 bool lua::emit_event(
@@ -163,6 +170,34 @@ bool lua::emit_event(
     return false;
 }
 
+int lua::intern_event(State* L, const std::string& name) {
+    const auto& found = interned_events.find(name);
+    if (found != interned_events.end()) {
+        return found->second;
+    }
+    pushstring(L, name);
+    int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    interned_events[name] = ref;
+    return ref;
+}
+
+bool lua::emit_event(State* L, int event, std::function<int(State*)> args) {
+    if (events_emit_ref == LUA_NOREF) {
+        getglobal(L, "events");
+        getfield(L, "emit");
+        events_emit_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+        pop(L);
+    }
+    rawgeti(L, events_emit_ref, LUA_REGISTRYINDEX);
+    rawgeti(L, event, LUA_REGISTRYINDEX);
+    if (call_nothrow(L, args(L) + 1)) {
+        bool result = toboolean(L, -1);
+        pop(L);
+        return result;
+    }
+    return false;
+}
+
 State* lua::get_main_state() {
     return main_thread;
 }
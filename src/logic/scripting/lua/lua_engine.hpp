@@ -25,6 +25,18 @@ namespace lua {
         const std::string& name,
         std::function<int(State*)> args = [](auto*) { return 0; }
     );
+
+    /// @brief Get handle of the event name stored in the Lua registry,
+    /// so the event may be emitted without building the name string.
+    /// Handles are valid until finalize()
+    int intern_event(State*, const std::string& name);
+
+    /// @brief Emit event by handle returned by intern_event
+    bool emit_event(
+        State*,
+        int event,
+        std::function<int(State*)> args = [](auto*) { return 0; }
+    );
     State* get_main_state();
     State* create_state(const EnginePaths& paths, StateType stateType);
     [[nodiscard]] scriptenv create_environment(State* L);
@@ -2,6 +2,12 @@
 
 #include "../lua_util.hpp"
 #include "world/generator/VoxelFragment.hpp"
+#include "lighting/Lighting.hpp"
+#include "lighting/ServerLighting.hpp"
+#include "logic/ChunksController.hpp"
+#include "logic/LevelController.hpp"
+#include "maths/aabb.hpp"
+#include "objects/Entities.hpp"
 #include "util/stringutil.hpp"
 #include "world/Level.hpp"
 
@@ -27,11 +33,34 @@ static int l_crop(lua::State* L) {
 
 static int l_place(lua::State* L) {
     if (auto fragment = touserdata<LuaVoxelFragment>(L, 1)) {
-        auto offset = tovec3(L, 2);
+        glm::ivec3 offset = tovec3(L, 2);
         int rotation = tointeger(L, 3);
-        fragment->getFragment(rotation)->place(
-            *scripting::level->chunks, offset 
+        auto& variant = *fragment->getFragment(rotation);
+        auto touched = variant.place(*scripting::level->chunks, offset);
+        if (touched.empty()) {
+            return 0;
+        }
+        // bodies resting on or near replaced blocks
+        glm::vec3 min(offset);
+        glm::vec3 max = min + glm::vec3(variant.getSize());
+        scripting::level->entities->wakeUpBodies(
+            AABB(min - 1.0f, max + 1.0f)
         );
+        auto chunksController = scripting::controller->getChunksController();
+        if (chunksController == nullptr) {
+            return 0;
+        }
+        // lights are updated once for the whole fragment
+        if (auto lighting = chunksController->lighting.get()) {
+            const auto& size = variant.getSize();
+            lighting->onBlocksSet(
+                offset.x, offset.y, offset.z, size.x, size.y, size.z
+            );
+        } else if (auto lighting = chunksController->serverLighting.get()) {
+            for (const auto& pos : touched) {
+                lighting->invalidate(pos.x, pos.y);
+            }
+        }
     }
     return 0;
 }
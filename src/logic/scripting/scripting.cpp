@@ -384,28 +384,51 @@ void scripting::cleanup(const std::vector<std::string>& nonReset) {
 }
 
 void scripting::on_blocks_tick(const Block& block, int tps) {
-    std::string name = block.name + ".blockstick";
-    lua::emit_event(lua::get_main_state(), name, [tps](auto L) {
-        return lua::pushinteger(L, tps);
-    });
+    lua::emit_event(
+        lua::get_main_state(),
+        block.rt.events.blockstick,
+        [tps](auto L) { return lua::pushinteger(L, tps); }
+    );
 }
 
 void scripting::update_block(const Block& block, const glm::ivec3& pos) {
-    std::string name = block.name + ".update";
-    lua::emit_event(lua::get_main_state(), name, [pos](auto L) {
-        return lua::pushivec_stack(L, pos);
-    });
+    lua::emit_event(
+        lua::get_main_state(),
+        block.rt.events.update,
+        [pos](auto L) { return lua::pushivec_stack(L, pos); }
+    );
 }
 
 void scripting::random_update_block(const Block& block, const glm::ivec3& pos) {
-    std::string name = block.name + ".randupdate";
-    lua::emit_event(lua::get_main_state(), name, [pos](auto L) {
-        return lua::pushivec_stack(L, pos);
-    });
+    lua::emit_event(
+        lua::get_main_state(),
+        block.rt.events.randupdate,
+        [pos](auto L) { return lua::pushivec_stack(L, pos); }
+    );
+}
+
+void scripting::random_update_blocks(
+    const Block& block, const std::vector<glm::ivec3>& positions
+) {
+    lua::emit_event(
+        lua::get_main_state(),
+        block.rt.events.randupdates,
+        [&positions](auto L) {
+            lua::createtable(L, positions.size() * 3, 0);
+            int index = 1;
+            for (const auto& pos : positions) {
+                for (int i = 0; i < 3; i++) {
+                    lua::pushinteger(L, pos[i]);
+                    lua::rawseti(L, index++);
+                }
+            }
+            return 1;
+        }
+    );
 }
 
 /// TODO: replace template with index
-template<bool WorldFuncsSet::*worldfunc>
+template<bool WorldFuncsSet::*worldfunc, int BlockEventsSet::*event>
 static bool on_block_common(
     const std::string& suffix,
     bool blockfunc,
@@ -415,9 +438,10 @@ static bool on_block_common(
 ) {
     bool result = false;
     if (blockfunc) {
-        std::string name = block.name + "." + suffix;
-        result =
-            lua::emit_event(lua::get_main_state(), name, [pos, player](auto L) {
+        result = lua::emit_event(
+            lua::get_main_state(),
+            block.rt.events.*event,
+            [pos, player](auto L) {
                 lua::pushivec_stack(L, pos);
                 lua::pushinteger(L, player ? player->getId() : -1);
                 return 4;
@@ -442,7 +466,7 @@ static bool on_block_common(
 void scripting::on_block_placed(
     Player* player, const Block& block, const glm::ivec3& pos
 ) {
-    on_block_common<&WorldFuncsSet::onblockplaced>(
+    on_block_common<&WorldFuncsSet::onblockplaced, &BlockEventsSet::placed>(
         "placed", block.rt.funcsset.onplaced, player, block, pos
     );
 }
@@ -450,7 +474,7 @@ void scripting::on_block_placed(
 void scripting::on_block_replaced(
     Player* player, const Block& block, const glm::ivec3& pos
 ) {
-    on_block_common<&WorldFuncsSet::onblockreplaced>(
+    on_block_common<&WorldFuncsSet::onblockreplaced, &BlockEventsSet::replaced>(
         "replaced", block.rt.funcsset.onreplaced, player, block, pos
     );
 }
@@ -458,7 +482,7 @@ void scripting::on_block_replaced(
 void scripting::on_block_breaking(
     Player* player, const Block& block, const glm::ivec3& pos
 ) {
-    on_block_common<&WorldFuncsSet::onblockbreaking>(
+    on_block_common<&WorldFuncsSet::onblockbreaking, &BlockEventsSet::breaking>(
         "breaking", block.rt.funcsset.onbreaking, player, block, pos
     );
 }
@@ -466,7 +490,7 @@ void scripting::on_block_breaking(
 void scripting::on_block_broken(
     Player* player, const Block& block, const glm::ivec3& pos
 ) {
-    on_block_common<&WorldFuncsSet::onblockbroken>(
+    on_block_common<&WorldFuncsSet::onblockbroken, &BlockEventsSet::broken>(
         "broken", block.rt.funcsset.onbroken, player, block, pos
     );
 }
@@ -474,7 +498,9 @@ void scripting::on_block_broken(
 bool scripting::on_block_interact(
     Player* player, const Block& block, const glm::ivec3& pos
 ) {
-    return on_block_common<&WorldFuncsSet::onblockinteract>(
+    return on_block_common<
+        &WorldFuncsSet::onblockinteract,
+        &BlockEventsSet::interact>(
         "interact", block.rt.funcsset.oninteract, player, block, pos
     );
 }
@@ -556,10 +582,9 @@ void scripting::on_player_tick(Player* player, int tps) {
 }
 
 bool scripting::on_item_use(Player* player, const ItemDef& item) {
-    std::string name = item.name + ".use";
     return lua::emit_event(
         lua::get_main_state(),
-        name,
+        item.rt.events.use,
         [player](lua::State* L) { return lua::pushinteger(L, player->getId()); }
     );
 }
@@ -567,10 +592,9 @@ bool scripting::on_item_use(Player* player, const ItemDef& item) {
 bool scripting::on_item_use_on_block(
     Player* player, const ItemDef& item, glm::ivec3 ipos, glm::ivec3 normal
 ) {
-    std::string name = item.name + ".useon";
     return lua::emit_event(
         lua::get_main_state(),
-        name,
+        item.rt.events.useon,
         [ipos, normal, player](auto L) {
             lua::pushivec_stack(L, ipos);
             lua::pushinteger(L, player->getId());
@@ -583,10 +607,9 @@ bool scripting::on_item_use_on_block(
 bool scripting::on_item_break_block(
     Player* player, const ItemDef& item, int x, int y, int z
 ) {
-    std::string name = item.name + ".blockbreakby";
     return lua::emit_event(
         lua::get_main_state(),
-        name,
+        item.rt.events.blockbreakby,
         [x, y, z, player](auto L) {
             lua::pushivec_stack(L, glm::ivec3(x, y, z));
             lua::pushinteger(L, player->getId());
@@ -660,7 +683,8 @@ void scripting::load_content_script(
     const std::string& prefix,
     const io::path& file,
     const std::string& fileName,
-    BlockFuncsSet& funcsset
+    BlockFuncsSet& funcsset,
+    BlockEventsSet& events
 ) {
     int env = *senv;
     lua::pop(lua::get_main_state(), load_script(env, "block", file, fileName));
@@ -670,6 +694,8 @@ void scripting::load_content_script(
     funcsset.update = register_event(env, "on_update", prefix + ".update");
     funcsset.randupdate =
         register_event(env, "on_random_update", prefix + ".randupdate");
+    funcsset.randupdates =
+        register_event(env, "on_random_updates", prefix + ".randupdates");
     funcsset.onbreaking =
         register_event(env, "on_breaking", prefix + ".breaking");
     funcsset.onbroken = register_event(env, "on_broken", prefix + ".broken");
@@ -686,6 +712,17 @@ void scripting::load_content_script(
         register_event(env, "on_block_present", prefix + ".blockpresent");
     funcsset.onblockremoved =
         register_event(env, "on_block_removed", prefix + ".blockremoved");
+
+    auto L = lua::get_main_state();
+    events.update = lua::intern_event(L, prefix + ".update");
+    events.randupdate = lua::intern_event(L, prefix + ".randupdate");
+    events.randupdates = lua::intern_event(L, prefix + ".randupdates");
+    events.blockstick = lua::intern_event(L, prefix + ".blockstick");
+    events.placed = lua::intern_event(L, prefix + ".placed");
+    events.replaced = lua::intern_event(L, prefix + ".replaced");
+    events.breaking = lua::intern_event(L, prefix + ".breaking");
+    events.broken = lua::intern_event(L, prefix + ".broken");
+    events.interact = lua::intern_event(L, prefix + ".interact");
 }
 
 void scripting::load_content_script(
@@ -693,7 +730,8 @@ void scripting::load_content_script(
     const std::string& prefix,
     const io::path& file,
     const std::string& fileName,
-    ItemFuncsSet& funcsset
+    ItemFuncsSet& funcsset,
+    ItemEventsSet& events
 ) {
     int env = *senv;
     lua::pop(lua::get_main_state(), load_script(env, "item", file, fileName));
@@ -705,6 +743,11 @@ void scripting::load_content_script(
         register_event(env, "on_use_on_block", prefix + ".useon");
     funcsset.on_block_break_by =
         register_event(env, "on_block_break_by", prefix + ".blockbreakby");
+
+    auto L = lua::get_main_state();
+    events.use = lua::intern_event(L, prefix + ".use");
+    events.useon = lua::intern_event(L, prefix + ".useon");
+    events.blockbreakby = lua::intern_event(L, prefix + ".blockbreakby");
 }
 
 void scripting::load_entity_component(
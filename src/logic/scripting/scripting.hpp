@@ -23,7 +23,9 @@ struct ItemDef;
 class Inventory;
 class UiDocument;
 struct BlockFuncsSet;
+struct BlockEventsSet;
 struct ItemFuncsSet;
+struct ItemEventsSet;
 struct WorldFuncsSet;
 struct UserComponent;
 struct uidocscript;
@@ -87,6 +89,11 @@ namespace scripting {
     void on_blocks_tick(const Block& block, int tps);
     void update_block(const Block& block, const glm::ivec3& pos);
     void random_update_block(const Block& block, const glm::ivec3& pos);
+    /// @brief Call batched random update of the block type
+    /// @param positions all random-ticked positions of the block in the tick
+    void random_update_blocks(
+        const Block& block, const std::vector<glm::ivec3>& positions
+    );
     void on_block_placed(
         Player* player, const Block& block, const glm::ivec3& pos
     );
@@ -163,12 +170,14 @@ namespace scripting {
     /// @param file item script file
     /// @param fileName script file path using the engine format
     /// @param funcsset block callbacks set
+    /// @param events block callbacks events handles
     void load_content_script(
         const scriptenv& env,
         const std::string& prefix,
         const io::path& file,
         const std::string& fileName,
-        BlockFuncsSet& funcsset
+        BlockFuncsSet& funcsset,
+        BlockEventsSet& events
     );
 
     /// @brief Load script associated with an Item
@@ -177,12 +186,14 @@ namespace scripting {
     /// @param file item script file
     /// @param fileName script file path using the engine format
     /// @param funcsset item callbacks set
+    /// @param events item callbacks events handles
     void load_content_script(
         const scriptenv& env,
         const std::string& prefix,
         const io::path& file,
         const std::string& fileName,
-        ItemFuncsSet& funcsset
+        ItemFuncsSet& funcsset,
+        ItemEventsSet& events
     );
 
     /// @brief Load component script
@@ -20,14 +20,24 @@
 #include "Entity.hpp"
 #include "rigging.hpp"
 #include "physics/PhysicsSolver.hpp"
+#include "util/JobSystem.hpp"
 #include "world/Level.hpp"
 
 static debug::Logger logger("entities");
 
+/// @brief Max number of threads integrating bodies
+static constexpr size_t MAX_PHYSICS_THREADS = 4;
+/// @brief Min number of bodies to integrate in a separate thread
+static constexpr size_t MIN_BODIES_PER_THREAD = 64;
+
+/// @brief Entities index cell size
+static constexpr float GRID_CELL_SIZE = 8.0f;
+
 Entities::Entities(Level& level)
     : level(level),
       sensorsTickClock(20, 3),
-      updateTickClock(20, 3) {
+      updateTickClock(20, 3),
+      grid(GRID_CELL_SIZE) {
 }
 
 std::optional<Entity> Entities::get(entityid_t id) {
@@ -100,6 +110,7 @@ entityid_t Entities::spawn(
         loadEntity(saved, get(id).value());
     }
     body.hitbox.position = tsf.pos;
+    updateIndex(entity);
     scripting::on_entity_spawn(
         def, id, scripting.components, args, componentsMap
     );
@@ -148,26 +159,34 @@ std::optional<Entities::RaycastResult> Entities::rayCast(
     glm::vec3 start, glm::vec3 dir, float maxDistance, entityid_t ignore
 ) {
     Ray ray(start, dir);
-    auto view = registry.view<EntityId, Transform, Rigidbody>();
+    glm::vec3 end = start + dir * maxDistance;
+    // hitboxes may extend outside of the entity cell
+    glm::vec3 margin = maxHalfsize;
 
     entityid_t foundUID = 0;
     glm::ivec3 foundNormal;
 
-    for (auto [entity, eid, transform, body] : view.each()) {
-        if (eid.uid == ignore || !body.enabled) {
-            continue;
-        }
-        auto& hitbox = body.hitbox;
-        glm::ivec3 normal;
-        double distance;
-        if (ray.intersectAABB(
-                glm::vec3(), hitbox.getAABB(), maxDistance, normal, distance
-            ) > RayRelation::None) {
-            foundUID = eid.uid;
-            foundNormal = normal;
-            maxDistance = static_cast<float>(distance);
+    grid.query(
+        glm::min(start, end) - margin,
+        glm::max(start, end) + margin,
+        [&](entt::entity entity) {
+            const auto& eid = registry.get<EntityId>(entity);
+            const auto& body = registry.get<Rigidbody>(entity);
+            if (eid.uid == ignore || !body.enabled) {
+                return;
+            }
+            auto& hitbox = body.hitbox;
+            glm::ivec3 normal;
+            double distance;
+            if (ray.intersectAABB(
+                    glm::vec3(), hitbox.getAABB(), maxDistance, normal, distance
+                ) > RayRelation::None) {
+                foundUID = eid.uid;
+                foundNormal = normal;
+                maxDistance = static_cast<float>(distance);
+            }
         }
-    }
+    );
     if (foundUID) {
         return Entities::RaycastResult {foundUID, foundNormal, maxDistance};
     } else {
@@ -191,6 +210,17 @@ void Entities::onSave(const Entity& entity) {
     scripting::on_entity_save(entity);
 }
 
+void Entities::updateIndex(entt::entity entity) {
+    const auto& transform = registry.get<Transform>(entity);
+    const auto& body = registry.get<Rigidbody>(entity);
+    grid.set(entity, transform.pos);
+    maxHalfsize = glm::max(maxHalfsize, body.hitbox.halfsize);
+}
+
+void Entities::updateIndex(const Entity& entity) {
+    updateIndex(entity.getHandler());
+}
+
 dv::value Entities::serialize(const std::vector<Entity>& entities) {
     auto list = dv::list();
     for (auto& entity : entities) {
@@ -223,6 +253,7 @@ void Entities::clean() {
             for (auto& sensor : rigidbody.sensors) {
                 physics->removeSensor(&sensor);
             }
+            grid.remove(it->second);
             uids.erase(it->second);
             registry.destroy(it->second);
             it = entities.erase(it);
@@ -282,34 +313,95 @@ void Entities::preparePhysics(float delta) {
     }
 }
 
+void Entities::stepBodies(
+    const std::vector<BodyStep>& steps, size_t begin, size_t end, float delta
+) {
+    auto physics = level.physics.get();
+    for (size_t i = begin; i < end; i++) {
+        const auto& step = steps[i];
+        auto& hitbox = *step.hitbox;
+
+        float vel = glm::length(step.prevVelocity);
+        int substeps = static_cast<int>(delta * vel * 20);
+        substeps = std::min(100, std::max(2, substeps));
+        physics->step(*level.chunks, hitbox, delta, substeps);
+        hitbox.friction = glm::abs(hitbox.gravityScale <= 1e-7f)
+                              ? 8.0f
+                              : (!step.grounded ? 2.0f : 10.0f);
+        step.transform->setPos(hitbox.position);
+    }
+}
+
 void Entities::updatePhysics(float delta) {
     preparePhysics(delta);
 
     auto view = registry.view<EntityId, Transform, Rigidbody>();
-    auto physics = level.physics.get();
+    std::vector<BodyStep> steps;
+    std::vector<entt::entity> sleeping;
     for (auto [entity, eid, transform, rigidbody] : view.each()) {
         if (!rigidbody.enabled || rigidbody.hitbox.type == BodyType::STATIC) {
             continue;
         }
         auto& hitbox = rigidbody.hitbox;
-        auto prevVel = hitbox.velocity;
+        // velocity of a sleeping body is zero until something pushes it
+        if (hitbox.sleeping && hitbox.velocity != glm::vec3(0.0f)) {
+            hitbox.wakeUp();
+        }
+        if (hitbox.sleeping) {
+            sleeping.push_back(entity);
+            continue;
+        }
+        steps.push_back(BodyStep {
+            entity, &transform, &hitbox, hitbox.velocity, hitbox.grounded});
+    }
+    activeBodies = steps.size();
+    sleepingBodies = sleeping.size();
+
+    // bodies are integrated in parallel, as they only read voxels
+    auto& jobSystem = util::JobSystem::getInstance();
+    size_t threadsCount = std::min<size_t>(
+        std::min<size_t>(MAX_PHYSICS_THREADS, jobSystem.getThreadsCount() + 1),
+        steps.size() / MIN_BODIES_PER_THREAD
+    );
+    if (threadsCount > 1) {
+        size_t part = steps.size() / threadsCount;
+        jobSystem.parallel(threadsCount, [&](size_t i) {
+            size_t end = i + 1 == threadsCount ? steps.size() : (i + 1) * part;
+            stepBodies(steps, i * part, end, delta);
+        });
+    } else {
+        stepBodies(steps, 0, steps.size(), delta);
+    }
+
+    // scripts callbacks are called in the same order as bodies were collected
+    auto physics = level.physics.get();
+    for (const auto& step : steps) {
+        if (!registry.valid(step.entity)) {
+            continue;
+        }
+        // components may be moved by callbacks
+        entityid_t uid = registry.get<EntityId>(step.entity).uid;
+        const auto& hitbox = registry.get<Rigidbody>(step.entity).hitbox;
         bool grounded = hitbox.grounded;
+        float impact = glm::length(step.prevVelocity - hitbox.velocity);
 
-        float vel = glm::length(prevVel);
-        int substeps = static_cast<int>(delta * vel * 20);
-        substeps = std::min(100, std::max(2, substeps));
-        physics->step(*level.chunks, hitbox, delta, substeps, eid.uid);
-        hitbox.friction = glm::abs(hitbox.gravityScale <= 1e-7f)
-                              ? 8.0f
-                              : (!grounded ? 2.0f : 10.0f);
-        transform.setPos(hitbox.position);
-        if (hitbox.grounded && !grounded) {
-            scripting::on_entity_grounded(
-                *get(eid.uid), glm::length(prevVel - hitbox.velocity)
-            );
+        updateIndex(step.entity);
+        physics->checkSensors(hitbox, uid);
+        if (grounded && !step.grounded) {
+            scripting::on_entity_grounded(*get(uid), impact);
         }
-        if (!hitbox.grounded && grounded) {
-            scripting::on_entity_fall(*get(eid.uid));
+        if (!grounded && step.grounded) {
+            scripting::on_entity_fall(*get(uid));
+        }
+    }
+    // sleeping bodies stay in sensors
+    for (auto entity : sleeping) {
+        if (!registry.valid(entity)) {
+            continue;
+        }
+        entityid_t uid = registry.get<EntityId>(entity).uid;
+        if (physics->checkSensors(registry.get<Rigidbody>(entity).hitbox, uid)) {
+            registry.get<Rigidbody>(entity).hitbox.wakeUp();
         }
     }
 }
@@ -418,45 +510,60 @@ void Entities::render(
 }
 
 bool Entities::hasBlockingInside(AABB aabb) {
-    auto view = registry.view<EntityId, Rigidbody>();
-    for (auto [entity, eid, body] : view.each()) {
+    bool found = false;
+    // hitboxes may extend outside of the entity cell
+    glm::vec3 margin = maxHalfsize + 0.05f;
+    grid.query(aabb.min() - margin, aabb.max() + margin, [&](auto entity) {
+        const auto& eid = registry.get<EntityId>(entity);
+        const auto& body = registry.get<Rigidbody>(entity);
         if (eid.def.blocking && aabb.intersect(body.hitbox.getAABB(), -0.05f)) {
-            return true;
+            found = true;
         }
-    }
-    return false;
+    });
+    return found;
+}
+
+void Entities::wakeUpBodies(AABB area) {
+    glm::vec3 margin = maxHalfsize;
+    grid.query(area.min() - margin, area.max() + margin, [&](auto entity) {
+        auto& hitbox = registry.get<Rigidbody>(entity).hitbox;
+        if (hitbox.sleeping && area.intersect(hitbox.getAABB())) {
+            hitbox.wakeUp();
+        }
+    });
 }
 
 std::vector<Entity> Entities::getAllInside(AABB aabb) {
     std::vector<Entity> collected;
-    auto view = registry.view<EntityId, Transform>();
-    for (auto [entity, eid, transform] : view.each()) {
+    grid.query(aabb.min(), aabb.max(), [&](auto entity) {
+        const auto& eid = registry.get<EntityId>(entity);
+        const auto& transform = registry.get<Transform>(entity);
         if (!eid.destroyFlag && aabb.contains(transform.pos)) {
             const auto& found = uids.find(entity);
             if (found == uids.end()) {
-                continue;
+                return;
             }
             if (auto wrapper = get(found->second)) {
                 collected.push_back(*wrapper);
             }
         }
-    }
+    });
     return collected;
 }
 
 std::vector<Entity> Entities::getAllInRadius(glm::vec3 center, float radius) {
     std::vector<Entity> collected;
-    auto view = registry.view<Transform>();
-    for (auto [entity, transform] : view.each()) {
+    grid.query(center - radius, center + radius, [&](auto entity) {
+        const auto& transform = registry.get<Transform>(entity);
         if (glm::distance2(transform.pos, center) <= radius * radius) {
             const auto& found = uids.find(entity);
             if (found == uids.end()) {
-                continue;
+                return;
             }
             if (auto wrapper = get(found->second)) {
                 collected.push_back(*wrapper);
             }
         }
-    }
+    });
     return collected;
 }
@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "physics/Hitbox.hpp"
+#include "physics/SpatialHash.hpp"
 #include "Transform.hpp"
 #include "Rigidbody.hpp"
 #include "ScriptComponents.hpp"
@@ -39,6 +40,32 @@ class Entities {
     entityid_t nextID = 1;
     util::Clock sensorsTickClock;
     util::Clock updateTickClock;
+    /// @brief Entities positions index used by area queries
+    SpatialHash<entt::entity> grid;
+    /// @brief Max hitbox half-size of indexed entities
+    glm::vec3 maxHalfsize {};
+    /// @brief Number of bodies stepped in the last physics update
+    size_t activeBodies = 0;
+    /// @brief Number of sleeping bodies in the last physics update
+    size_t sleepingBodies = 0;
+
+    void updateIndex(entt::entity entity);
+
+    /// @brief Body to integrate in physics update
+    struct BodyStep {
+        entt::entity entity;
+        Transform* transform;
+        Hitbox* hitbox;
+        glm::vec3 prevVelocity;
+        bool grounded;
+    };
+
+    void stepBodies(
+        const std::vector<BodyStep>& steps,
+        size_t begin,
+        size_t end,
+        float delta
+    );
 
     void updateSensors(
         Rigidbody& body, const Transform& tsf, std::vector<Sensor*>& sensors
@@ -97,6 +124,14 @@ public:
     void loadEntity(const dv::value& map);
     void loadEntity(const dv::value& map, Entity entity);
     void onSave(const Entity& entity);
+
+    /// @brief Update entity in area queries index. Must be called after
+    /// the entity transform position or hitbox size is changed
+    void updateIndex(const Entity& entity);
+
+    /// @brief Wake up sleeping bodies intersecting the area
+    void wakeUpBodies(AABB area);
+
     bool hasBlockingInside(AABB aabb);
     std::vector<Entity> getAllInside(AABB aabb);
     std::vector<Entity> getAllInRadius(glm::vec3 center, float radius);
@@ -115,4 +150,12 @@ public:
     inline entityid_t peekNextID() const {
         return nextID;
     }
+
+    inline size_t getActiveBodiesCount() const {
+        return activeBodies;
+    }
+
+    inline size_t getSleepingBodiesCount() const {
+        return sleepingBodies;
+    }
 };
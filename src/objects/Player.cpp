@@ -117,8 +117,10 @@ void Player::teleport(glm::vec3 position) {
 
     if (auto entity = level.entities->get(eid)) {
         entity->getRigidbody().hitbox.position = position;
+        entity->getRigidbody().hitbox.wakeUp();
         entity->getTransform().setPos(position);
         entity->setInterpolatedPosition(position);
+        level.entities->updateIndex(*entity);
     }
 }
 
@@ -58,9 +58,18 @@ struct Hitbox {
     bool grounded = false;
     float gravityScale = 1.0f;
     bool crouching = false;
+    /// @brief Resting body is not stepped until woken up
+    bool sleeping = false;
+    /// @brief Time the body has been resting for (seconds)
+    float restTime = 0.0f;
 
     Hitbox(BodyType type, glm::vec3 position, glm::vec3 halfsize);
 
+    void wakeUp() {
+        sleeping = false;
+        restTime = 0.0f;
+    }
+
     AABB getAABB() const {
         return AABB(position-halfsize, position+halfsize);
     }
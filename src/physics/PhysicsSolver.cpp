@@ -13,16 +13,45 @@
 
 const float E = 0.03f;
 const float MAX_FIX = 0.1f;
+/// @brief Sensors broadphase cell size
+const float SENSORS_GRID_CELL = 8.0f;
+/// @brief Max speed of a resting body
+const float SLEEP_VELOCITY = 0.05f;
+/// @brief Time a body must be resting for to fall asleep (seconds)
+const float SLEEP_DELAY = 1.0f;
 
-PhysicsSolver::PhysicsSolver(glm::vec3 gravity) : gravity(gravity) {
+PhysicsSolver::PhysicsSolver(glm::vec3 gravity)
+    : gravity(gravity), sensorsGrid(SENSORS_GRID_CELL) {
+}
+
+void PhysicsSolver::rebuildSensorsGrid() {
+    sensorsGrid.clear();
+    for (size_t i = 0; i < sensors.size(); i++) {
+        if (sensors[i] == nullptr) {
+            continue;
+        }
+        const auto& sensor = *sensors[i];
+        switch (sensor.type) {
+            case SensorType::AABB:
+                sensorsGrid.insert(
+                    i, sensor.calculated.aabb.min(), sensor.calculated.aabb.max()
+                );
+                break;
+            case SensorType::RADIUS: {
+                glm::vec3 center(sensor.calculated.radial);
+                glm::vec3 radius(glm::sqrt(sensor.calculated.radial.w));
+                sensorsGrid.insert(i, center - radius, center + radius);
+                break;
+            }
+        }
+    }
 }
 
 void PhysicsSolver::step(
     const GlobalChunks& chunks, 
     Hitbox& hitbox, 
     float delta, 
-    uint substeps, 
-    entityid_t entity
+    uint substeps
 ) {
     float dt = delta / static_cast<float>(substeps);
     float linearDamping = hitbox.linearDamping * hitbox.friction;
@@ -90,10 +119,42 @@ void PhysicsSolver::step(
         vel.y /= 1.0f + delta * linearDamping * hitbox.verticalDamping;
     }
 
+    if (hitbox.grounded &&
+        glm::length2(vel) < SLEEP_VELOCITY * SLEEP_VELOCITY) {
+        hitbox.restTime += delta;
+        if (hitbox.restTime >= SLEEP_DELAY) {
+            // any velocity change wakes the body up
+            vel = glm::vec3(0.0f);
+            hitbox.sleeping = true;
+        }
+    } else {
+        hitbox.restTime = 0.0f;
+    }
+}
+
+bool PhysicsSolver::checkSensors(const Hitbox& hitbox, entityid_t entity) {
+    if (sensors.empty()) {
+        return false;
+    }
+    bool entered = false;
+    // hitbox may be moved in memory by callbacks
+    const glm::vec3 position = hitbox.position;
     AABB aabb;
-    aabb.a = hitbox.position - hitbox.halfsize;
-    aabb.b = hitbox.position + hitbox.halfsize;
-    for (size_t i = 0; i < sensors.size(); i++) {
+    aabb.a = position - hitbox.halfsize;
+    aabb.b = position + hitbox.halfsize;
+    // sorted to call sensors callbacks in the same order as without grid
+    std::vector<size_t> candidates;
+    sensorsGrid.query(aabb.a, aabb.b, [&candidates](size_t index) {
+        candidates.push_back(index);
+    });
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(
+        std::unique(candidates.begin(), candidates.end()), candidates.end()
+    );
+    for (size_t i : candidates) {
+        if (sensors[i] == nullptr) {
+            continue;
+        }
         auto& sensor = *sensors[i];
         if (sensor.entity == entity) {
             continue;
@@ -106,17 +167,19 @@ void PhysicsSolver::step(
                 break;
             case SensorType::RADIUS:
                 triggered = glm::distance2(
-                    hitbox.position, glm::vec3(sensor.calculated.radial))
+                    position, glm::vec3(sensor.calculated.radial))
                      < sensor.calculated.radial.w;
                 break;
         }
         if (triggered) {
             if (sensor.prevEntered.find(entity) == sensor.prevEntered.end()) {
                 sensor.enterCallback(sensor.entity, sensor.index, entity);
+                entered = true;
             }
             sensor.nextEntered.insert(entity);
         }
     }
+    return entered;
 }
 
 static float calc_step_height(
@@ -292,5 +355,6 @@ bool PhysicsSolver::isBlockInside(int x, int y, int z, Block* def, blockstate st
 }
 
 void PhysicsSolver::removeSensor(Sensor* sensor) {
-    sensors.erase(std::remove(sensors.begin(), sensors.end(), sensor), sensors.end());
+    // keeps indices stored in the grid valid
+    std::replace(sensors.begin(), sensors.end(), sensor, (Sensor*)nullptr);
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Hitbox.hpp"
+#include "SpatialHash.hpp"
 
 #include "typedefs.hpp"
 #include "voxels/voxel.hpp"
@@ -15,15 +16,26 @@ struct Sensor;
 class PhysicsSolver {
     glm::vec3 gravity;
     std::vector<Sensor*> sensors;
+    /// @brief Sensors indices broadphase
+    SpatialHash<size_t> sensorsGrid;
+
+    void rebuildSensorsGrid();
 public:
     PhysicsSolver(glm::vec3 gravity);
+    /// @brief Integrate hitbox movement. Does not modify anything but the
+    /// hitbox, so different hitboxes may be stepped in different threads.
+    /// Puts the hitbox to sleep after resting for a while
     void step(
         const GlobalChunks& chunks,
         Hitbox& hitbox,
         float delta,
-        uint substeps,
-        entityid_t entity
+        uint substeps
     );
+
+    /// @brief Trigger sensors entered by the entity hitbox
+    /// @return true if any sensor is entered for the first time
+    bool checkSensors(const Hitbox& hitbox, entityid_t entity);
+
     void colisionCalc(
         const GlobalChunks& chunks,
         Hitbox& hitbox,
@@ -37,6 +49,7 @@ public:
 
     void setSensors(std::vector<Sensor*> sensors) {
         this->sensors = std::move(sensors);
+        rebuildSensorsGrid();
     }
 
     void removeSensor(Sensor* sensor);
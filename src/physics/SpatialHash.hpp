@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
+
+/// @brief Uniform grid broadphase. Stores points (moved with set/remove)
+/// and boxes (inserted to all cells they overlap, cleared with clear)
+/// @tparam T hashable value type, such as an id or an index
+template <typename T>
+class SpatialHash {
+    /// @brief Max number of cells a box is inserted to,
+    /// larger boxes are checked by every query
+    static constexpr size_t MAX_BOX_CELLS = 64;
+    /// @brief Limits cells coordinates of far or invalid positions
+    static constexpr float MAX_CELL_COORD = 1e8f;
+
+    float cellSize;
+    std::unordered_map<glm::ivec3, std::vector<T>> cells;
+    /// @brief Cells of points
+    std::unordered_map<T, glm::ivec3> points;
+    /// @brief Boxes overlapping too many cells
+    std::vector<T> oversized;
+
+    void removeFromCell(const glm::ivec3& cell, const T& value) {
+        auto found = cells.find(cell);
+        if (found == cells.end()) {
+            return;
+        }
+        auto& values = found->second;
+        auto it = std::find(values.begin(), values.end(), value);
+        if (it != values.end()) {
+            *it = std::move(values.back());
+            values.pop_back();
+        }
+        if (values.empty()) {
+            cells.erase(found);
+        }
+    }
+
+    static double countCells(const glm::ivec3& min, const glm::ivec3& max) {
+        glm::dvec3 size = glm::dvec3(max - min) + 1.0;
+        return size.x * size.y * size.z;
+    }
+public:
+    SpatialHash(float cellSize) : cellSize(cellSize) {
+    }
+
+    glm::ivec3 getCell(const glm::vec3& pos) const {
+        glm::vec3 cell = glm::floor(pos / cellSize);
+        cell = glm::mix(cell, glm::vec3(0.0f), glm::isnan(cell));
+        return glm::ivec3(glm::clamp(cell, -MAX_CELL_COORD, MAX_CELL_COORD));
+    }
+
+    /// @brief Insert or move point
+    void set(const T& value, const glm::vec3& pos) {
+        auto cell = getCell(pos);
+        auto found = points.find(value);
+        if (found != points.end()) {
+            if (found->second == cell) {
+                return;
+            }
+            removeFromCell(found->second, value);
+            found->second = cell;
+        } else {
+            points[value] = cell;
+        }
+        cells[cell].push_back(value);
+    }
+
+    /// @brief Remove point
+    void remove(const T& value) {
+        auto found = points.find(value);
+        if (found == points.end()) {
+            return;
+        }
+        removeFromCell(found->second, value);
+        points.erase(found);
+    }
+
+    /// @brief Insert box to all overlapped cells
+    void insert(const T& value, const glm::vec3& min, const glm::vec3& max) {
+        auto from = getCell(min);
+        auto to = getCell(max);
+        if (countCells(from, to) > MAX_BOX_CELLS) {
+            oversized.push_back(value);
+            return;
+        }
+        for (int y = from.y; y <= to.y; y++) {
+            for (int z = from.z; z <= to.z; z++) {
+                for (int x = from.x; x <= to.x; x++) {
+                    cells[{x, y, z}].push_back(value);
+                }
+            }
+        }
+    }
+
+    void clear() {
+        cells.clear();
+        points.clear();
+        oversized.clear();
+    }
+
+    /// @brief Call func for all values stored in cells overlapped by the
+    /// area. Values outside of the area may be visited. Boxes may be
+    /// visited more than once
+    template <typename Func>
+    void query(const glm::vec3& min, const glm::vec3& max, Func func) const {
+        for (const auto& value : oversized) {
+            func(value);
+        }
+        auto from = getCell(min);
+        auto to = getCell(max);
+        if (countCells(from, to) > cells.size()) {
+            for (const auto& [cell, values] : cells) {
+                if (glm::all(glm::greaterThanEqual(cell, from)) &&
+                    glm::all(glm::lessThanEqual(cell, to))) {
+                    for (const auto& value : values) {
+                        func(value);
+                    }
+                }
+            }
+            return;
+        }
+        for (int y = from.y; y <= to.y; y++) {
+            for (int z = from.z; z <= to.z; z++) {
+                for (int x = from.x; x <= to.x; x++) {
+                    auto found = cells.find({x, y, z});
+                    if (found == cells.end()) {
+                        continue;
+                    }
+                    for (const auto& value : found->second) {
+                        func(value);
+                    }
+                }
+            }
+        }
+    }
+
+    /// @return number of non-empty cells
+    size_t getCellsCount() const {
+        return cells.size();
+    }
+};
@@ -44,6 +44,10 @@ struct ChunksSettings {
     IntegerSetting loadDistance {22, 3, 80};
     /// @brief Buffer zone where chunks are not unloading (chunk is unit)
     IntegerSetting padding {2, 1, 8};
+    /// @brief Limit of chunk generator workers count
+    IntegerSetting generatorWorkers {4, -4, 32};
+    /// @brief Limit of chunks lighting workers count (headless mode only)
+    IntegerSetting lightingWorkers {2, -4, 32};
 };
 
 struct CameraSettings {
@@ -89,6 +93,8 @@ struct GraphicsSettings {
     IntegerSetting denseRenderDistance {56, 0, 10'000};
     /// @brief Soft lighting for blocks
     FlagSetting softLighting {true};
+    /// @brief Merge coplanar faces of cube blocks into larger quads
+    FlagSetting greedyMeshing {false};
 };
 
 struct PathfindingSettings {
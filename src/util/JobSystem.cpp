@@ -0,0 +1,198 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <exception>
+
+#include "debug/Logger.hpp"
+
+using namespace util;
+
+static debug::Logger logger("job-system");
+
+static thread_local JobSystem* current_system = nullptr;
+static thread_local int current_index = -1;
+
+JobSystem::JobSystem(uint threadsCount) {
+    threadsCount = std::max(1U, threadsCount);
+    for (uint i = 0; i < threadsCount; i++) {
+        queues.push_back(std::make_unique<TaskQueue>());
+    }
+    for (uint i = 0; i < threadsCount; i++) {
+        threads.emplace_back(&JobSystem::threadLoop, this, i);
+    }
+    logger.info() << "created " << threadsCount << " threads";
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        working = false;
+    }
+    condition.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void JobSystem::push(TaskQueue* queue, runnable task) {
+    if (queue) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->tasks.push_back(std::move(task));
+        pending++;
+    }
+    {
+        // also prevents a lost wake-up of a thread going to sleep
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queue == nullptr) {
+            posted.push_back(std::move(task));
+            pending++;
+        }
+    }
+    condition.notify_one();
+}
+
+void JobSystem::pushUrgent(runnable task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        urgent.push_back(std::move(task));
+        urgentCount++;
+        pending++;
+    }
+    condition.notify_one();
+}
+
+bool JobSystem::runNext(int index) {
+    runnable task;
+    if (urgentCount > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!urgent.empty()) {
+            task = std::move(urgent.front());
+            urgent.pop_front();
+            urgentCount--;
+        }
+    }
+    auto& own = *queues[index];
+    if (!task) {
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+        }
+    }
+    if (!task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!posted.empty()) {
+            task = std::move(posted.front());
+            posted.pop_front();
+        }
+    }
+    for (size_t i = 1; !task && i < queues.size(); i++) {
+        auto& other = *queues[(index + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.tasks.empty()) {
+            task = std::move(other.tasks.front());
+            other.tasks.pop_front();
+        }
+    }
+    if (!task) {
+        return false;
+    }
+    pending--;
+    try {
+        task();
+    } catch (const std::exception& err) {
+        logger.error() << "uncaught exception: " << err.what();
+    }
+    return true;
+}
+
+void JobSystem::threadLoop(int index) {
+    current_system = this;
+    current_index = index;
+    while (true) {
+        if (runNext(index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return pending > 0 || !working; });
+        if (!working && pending == 0) {
+            break;
+        }
+    }
+}
+
+void JobSystem::post(runnable task) {
+    push(nullptr, std::move(task));
+}
+
+void JobSystem::spawn(runnable task) {
+    if (current_system == this) {
+        push(queues[current_index].get(), std::move(task));
+    } else {
+        push(nullptr, std::move(task));
+    }
+}
+
+void JobSystem::parallel(
+    size_t count, const std::function<void(size_t)>& func
+) {
+    if (count == 0) {
+        return;
+    }
+    struct Loop {
+        std::atomic<size_t> next = 0;
+        size_t finished = 0;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable condition;
+    };
+    auto loop = std::make_shared<Loop>();
+    // helpers started after all indices are taken return without touching
+    // func, so it is safe to return before they are run
+    auto body = [loop, count, &func]() {
+        size_t done = 0;
+        std::exception_ptr error;
+        for (size_t i = loop->next++; i < count; i = loop->next++) {
+            try {
+                func(i);
+            } catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            done++;
+        }
+        if (done == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(loop->mutex);
+        if (error && !loop->error) {
+            loop->error = error;
+        }
+        loop->finished += done;
+        if (loop->finished == count) {
+            loop->condition.notify_all();
+        }
+    };
+    size_t helpers = std::min(count - 1, threads.size());
+    for (size_t i = 0; i < helpers; i++) {
+        pushUrgent(body);
+    }
+    body();
+
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->condition.wait(lock, [&] { return loop->finished == count; });
+    if (loop->error) {
+        std::rethrow_exception(loop->error);
+    }
+}
+
+uint JobSystem::getThreadsCount() const {
+    return threads.size();
+}
+
+JobSystem& JobSystem::getInstance() {
+    uint cores = std::thread::hardware_concurrency();
+    static JobSystem instance(cores > 1 ? cores - 1 : 1);
+    return instance;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "delegates.hpp"
+#include "typedefs.hpp"
+
+namespace util {
+    /// @brief Engine-wide set of worker threads shared by all thread pools
+    /// and parallel loops, so they do not oversubscribe the cores.
+    ///
+    /// Each thread has its own deque of tasks: tasks spawned by the thread
+    /// are taken from the back, idle threads steal from the front of other
+    /// deques. Tasks posted from outside are kept in a shared FIFO queue.
+    /// Helpers of parallel loops have their own queue taken before all
+    /// others, so loops do not wait behind long thread pool jobs.
+    class JobSystem {
+        struct TaskQueue {
+            std::mutex mutex;
+            std::deque<runnable> tasks;
+        };
+        std::vector<std::unique_ptr<TaskQueue>> queues;
+        std::deque<runnable> posted;
+        /// @brief Parallel loops helpers (guarded by mutex)
+        std::deque<runnable> urgent;
+        /// @brief Number of tasks in the urgent queue
+        std::atomic<size_t> urgentCount = 0;
+        std::mutex mutex;
+        std::condition_variable condition;
+        /// @brief Number of tasks pushed but not taken yet
+        std::atomic<size_t> pending = 0;
+        bool working = true;
+        std::vector<std::thread> threads;
+
+        void push(TaskQueue* queue, runnable task);
+        void pushUrgent(runnable task);
+        bool runNext(int index);
+        void threadLoop(int index);
+    public:
+        /// @param threadsCount number of worker threads (at least 1)
+        explicit JobSystem(uint threadsCount);
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        /// @brief Add task to the end of the shared queue. Tasks posted
+        /// are started in order they were posted
+        void post(runnable task);
+
+        /// @brief Add task to the current worker thread deque (or to the
+        /// shared queue if called outside of the job system)
+        void spawn(runnable task);
+
+        /// @brief Call func(i) for every i in [0, count) using idle worker
+        /// threads. The calling thread takes part in the loop and returns
+        /// when all calls are finished. First exception thrown is rethrown
+        void parallel(size_t count, const std::function<void(size_t)>& func);
+
+        uint getThreadsCount() const;
+
+        /// @brief Get the engine job system having one thread less than
+        /// hardware concurrency (the main thread is left free)
+        static JobSystem& getInstance();
+    };
+}
@@ -1,29 +1,24 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <functional>
-#include <iostream>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include "debug/Logger.hpp"
 #include "delegates.hpp"
 #include "interfaces/Task.hpp"
+#include "JobSystem.hpp"
 
 namespace util {
 
-    template <class J, class T>
-    struct ThreadPoolResult {
-        J job;
-        std::condition_variable& variable;
-        int workerIndex;
-        bool& locked;
-        T entry;
-    };
-
     template <class T, class R>
     class Worker {
     public:
@@ -32,75 +27,101 @@ namespace util {
         virtual R operator()(const T&) = 0;
     };
 
+    /// @brief Queue of prioritized jobs performed by the engine JobSystem.
+    /// Every worker instance takes at most one job at a time, so number
+    /// of workers limits number of jobs running in parallel. Results are
+    /// consumed in update() called from the main thread
     template <class T, class R>
     class ThreadPool : public Task {
-        debug::Logger logger;
-        std::queue<T> jobs;
-        std::queue<ThreadPoolResult<T, R>> results;
-        std::mutex resultsMutex;
-        std::vector<std::thread> threads;
-        std::condition_variable jobsMutexCondition;
-        std::mutex jobsMutex;
-        std::vector<std::unique_lock<std::mutex>> workersBlocked;
+        struct PendingJob {
+            T job;
+            int priority;
+            uint64_t order;
+
+            /// @brief Heap order: higher priority first, then FIFO
+            bool operator<(const PendingJob& o) const {
+                if (priority != o.priority) {
+                    return priority < o.priority;
+                }
+                return order > o.order;
+            }
+        };
+
+        struct JobResult {
+            T job;
+            R entry;
+        };
+
+        /// @brief State shared with tasks running in the JobSystem
+        struct State {
+            debug::Logger logger;
+            std::mutex mutex;
+            std::condition_variable idle;
+            std::vector<PendingJob> jobs;
+            uint64_t jobsOrder = 0;
+            std::queue<JobResult> results;
+            std::vector<std::shared_ptr<Worker<T, R>>> freeWorkers;
+            /// @brief Number of workers dispatched to the JobSystem
+            uint busyWorkers = 0;
+            std::atomic<uint> jobsDone = 0;
+            std::atomic<bool> working = true;
+            std::atomic<bool> failed = false;
+            bool stopOnFail = true;
+            consumer<T&> onJobFailed = nullptr;
+
+            State(std::string name) : logger(std::move(name)) {
+            }
+        };
+        std::shared_ptr<State> state;
         consumer<R&> resultConsumer;
-        consumer<T&> onJobFailed = nullptr;
         runnable onComplete = nullptr;
-        std::atomic<int> busyWorkers = 0;
-        std::atomic<uint> jobsDone = 0;
-        std::atomic<bool> working = true;
-        bool failed = false;
-        bool standaloneResults = true;
-        bool stopOnFail = true;
+        uint workersCount;
 
-        void threadLoop(int index, std::shared_ptr<Worker<T, R>> worker) {
-            std::condition_variable variable;
-            std::mutex mutex;
-            bool locked = false;
-            while (working) {
-                T job;
-                {
-                    std::unique_lock<std::mutex> lock(jobsMutex);
-                    jobsMutexCondition.wait(lock, [this] {
-                        return !jobs.empty() || !working;
-                    });
-                    if (!working || failed) {
-                        break;
-                    }
-                    job = std::move(jobs.front());
-                    jobs.pop();
+        static void dispatch(
+            std::shared_ptr<State> state, std::shared_ptr<Worker<T, R>> worker
+        ) {
+            // the task gives its worker reference away, so a worker is only
+            // owned by the free list or by the task running it
+            JobSystem::getInstance().post([state, worker]() mutable {
+                perform(state, std::move(worker));
+            });
+        }
+
+        /// @brief Perform the best job pending at the moment, then get back
+        /// to the end of the JobSystem queue to share threads with others
+        static void perform(
+            const std::shared_ptr<State>& state,
+            std::shared_ptr<Worker<T, R>> worker
+        ) {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            if (state->jobs.empty() || !state->working || state->failed) {
+                state->freeWorkers.push_back(std::move(worker));
+                state->busyWorkers--;
+                state->idle.notify_all();
+                return;
+            }
+            std::pop_heap(state->jobs.begin(), state->jobs.end());
+            T job = std::move(state->jobs.back().job);
+            state->jobs.pop_back();
+            lock.unlock();
 
-                    busyWorkers++;
+            try {
+                R result = (*worker)(job);
+                std::lock_guard<std::mutex> resultLock(state->mutex);
+                state->results.push(
+                    JobResult {std::move(job), std::move(result)}
+                );
+            } catch (std::exception& err) {
+                if (state->onJobFailed) {
+                    state->onJobFailed(job);
                 }
-                try {
-                    R result = (*worker)(job);
-                    {
-                        std::lock_guard<std::mutex> lock(resultsMutex);
-                        results.push(ThreadPoolResult<T, R> {
-                            job, variable, index, locked, result});
-                        if (!standaloneResults) {
-                            locked = true;
-                        }
-                        busyWorkers--;
-                    }
-                    if (!standaloneResults) {
-                        std::unique_lock<std::mutex> lock(mutex);
-                        variable.wait(lock, [&] {
-                            return !working || !locked;
-                        });
-                    }
-                } catch (std::exception& err) {
-                    busyWorkers--;
-                    if (onJobFailed) {
-                        onJobFailed(job);
-                    }
-                    if (stopOnFail) {
-                        std::lock_guard<std::mutex> lock(jobsMutex);
-                        failed = true;
-                    }
-                    logger.error() << "uncaught exception: " << err.what();
+                if (state->stopOnFail) {
+                    state->failed = true;
                 }
-                jobsDone++;
+                state->logger.error() << "uncaught exception: " << err.what();
             }
+            state->jobsDone++;
+            dispatch(state, std::move(worker));
         }
     public:
         static constexpr int UNLIMITED = 0;
@@ -111,21 +132,22 @@ namespace util {
         /// @param name thread pool name (used in logger)
         /// @param workersSupplier workers factory function
         /// @param resultConsumer workers results consumer function
-        /// @param maxWorkers max number of workers. Special values: 0 is 
-        /// unlimited, -2 is half of auto count, -4 is quarter.
+        /// @param maxWorkers max number of workers. Special values: 0 is
+        /// unlimited, -2 is half of JobSystem threads, -4 is quarter.
         ThreadPool(
             std::string name,
             supplier<std::shared_ptr<Worker<T, R>>> workersSupplier,
             consumer<R&> resultConsumer,
             int maxWorkers=UNLIMITED
         )
-            : logger(std::move(name)), resultConsumer(resultConsumer) {
-            uint numThreads = std::thread::hardware_concurrency();
+            : state(std::make_shared<State>(std::move(name))),
+              resultConsumer(resultConsumer) {
+            uint numThreads = JobSystem::getInstance().getThreadsCount();
             switch (maxWorkers) {
                 case UNLIMITED:
                     break;
                 case HALF:
-                    numThreads = std::max(1U, numThreads);
+                    numThreads = std::max(1U, numThreads / 2);
                     break;
                 case QUARTER:
                     numThreads = std::max(1U, numThreads / 4);
@@ -136,11 +158,9 @@ namespace util {
                     );
                     break;
             }
+            workersCount = numThreads;
             for (uint i = 0; i < numThreads; i++) {
-                threads.emplace_back(
-                    &ThreadPool<T, R>::threadLoop, this, i, workersSupplier()
-                );
-                workersBlocked.emplace_back();
+                state->freeWorkers.push_back(workersSupplier());
             }
         }
         ~ThreadPool() {
@@ -148,113 +168,119 @@ namespace util {
         }
 
         bool isActive() const override {
-            return working;
+            return state->working;
         }
 
+        /// @brief Drop pending jobs and wait for running ones to finish
         void terminate() override {
-            if (!working) {
+            if (!state->working) {
                 return;
             }
-            {
-                std::lock_guard<std::mutex> lock(jobsMutex);
-                working = false;
-            }
-            {
-                std::lock_guard<std::mutex> lock(resultsMutex);
-                while (!results.empty()) {
-                    ThreadPoolResult<T, R> entry = results.front();
-                    results.pop();
-                    if (!standaloneResults) {
-                        entry.locked = false;
-                        entry.variable.notify_all();
-                    }
-                }
-            }
-
-            jobsMutexCondition.notify_all();
-            for (auto& thread : threads) {
-                thread.join();
-            }
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->working = false;
+            state->jobs.clear();
+            state->idle.wait(lock, [this] { return state->busyWorkers == 0; });
+            state->results = {};
+            // all workers are back in the free list (tasks do not keep
+            // references to them), so they are released in the current thread
+            auto workers = std::move(state->freeWorkers);
         }
 
         void update() override {
-            if (!working) {
+            if (!state->working) {
                 return;
             }
-            if (failed) {
+            if (state->failed) {
                 throw std::runtime_error("some job failed");
             }
-
-            bool complete = false;
-            {
-                std::lock_guard<std::mutex> lock(resultsMutex);
-                while (!results.empty()) {
-                    ThreadPoolResult<T, R> entry = results.front();
-                    results.pop();
-
-                    try {
-                        resultConsumer(entry.entry);
-                    } catch (std::exception& err) {
-                        logger.error() << err.what();
-                        if (onJobFailed) {
-                            onJobFailed(entry.job);
-                        }
-                        if (stopOnFail) {
-                            std::lock_guard<std::mutex> jobsLock(jobsMutex);
-                            failed = true;
-                            complete = false;
-                        }
-                        break;
-                    }
-
-                    if (!standaloneResults) {
-                        entry.locked = false;
-                        entry.variable.notify_all();
-                    }
+            while (true) {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                if (state->results.empty()) {
+                    break;
                 }
+                JobResult result = std::move(state->results.front());
+                state->results.pop();
+                lock.unlock();
 
-                if (onComplete && busyWorkers == 0) {
-                    std::lock_guard<std::mutex> jobsLock(jobsMutex);
-                    if (jobs.empty()) {
-                        onComplete();
-                        complete = true;
+                try {
+                    resultConsumer(result.entry);
+                } catch (std::exception& err) {
+                    state->logger.error() << err.what();
+                    if (state->onJobFailed) {
+                        state->onJobFailed(result.job);
                     }
+                    if (state->stopOnFail) {
+                        state->failed = true;
+                    }
+                    break;
                 }
             }
-            if (failed) {
+            if (state->failed) {
                 throw std::runtime_error("some job failed");
             }
-            if (complete) {
+            if (onComplete) {
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (state->busyWorkers || !state->jobs.empty() ||
+                        !state->results.empty()) {
+                        return;
+                    }
+                }
+                onComplete();
                 terminate();
             }
         }
 
-        void enqueueJob(T job) {
-            {
-                std::lock_guard<std::mutex> lock(jobsMutex);
-                jobs.push(std::move(job));
+        /// @brief Add job to the queue
+        /// @param priority jobs with higher priority are taken first
+        void enqueueJob(T job, int priority = 0) {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->jobs.push_back(
+                PendingJob {std::move(job), priority, state->jobsOrder++}
+            );
+            std::push_heap(state->jobs.begin(), state->jobs.end());
+            if (state->freeWorkers.empty() || !state->working) {
+                return;
             }
-            jobsMutexCondition.notify_one();
+            auto worker = std::move(state->freeWorkers.back());
+            state->freeWorkers.pop_back();
+            state->busyWorkers++;
+            lock.unlock();
+            dispatch(state, std::move(worker));
         }
 
-        void clearQueue() {
-            std::lock_guard<std::mutex> lock(jobsMutex);
-            jobs = {};
+        /// @brief Remove pending jobs matching the predicate.
+        /// Jobs already running are not affected
+        /// @return number of jobs removed
+        size_t cancelJobs(const std::function<bool(const T&)>& predicate) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            auto& jobs = state->jobs;
+            auto end = std::remove_if(
+                jobs.begin(),
+                jobs.end(),
+                [&](const PendingJob& pending) {
+                    return predicate(pending.job);
+                }
+            );
+            size_t count = jobs.end() - end;
+            jobs.erase(end, jobs.end());
+            std::make_heap(jobs.begin(), jobs.end());
+            return count;
         }
 
-        /// @brief If false: worker will be blocked until it's result performed
-        void setStandaloneResults(bool flag) {
-            standaloneResults = flag;
+        void clearQueue() {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->jobs.clear();
         }
 
         void setStopOnFail(bool flag) {
-            stopOnFail = flag;
+            state->stopOnFail = flag;
         }
 
         /// @brief onJobFailed called on exception thrown in worker thread.
         /// Use engine.postRunnable when calling terminate()
         void setOnJobFailed(consumer<T&> callback) {
-            this->onJobFailed = callback;
+            state->onJobFailed = callback;
         }
 
         /// @brief onComplete called in ThreadPool.update() when all jobs done
@@ -264,23 +290,24 @@ namespace util {
         }
 
         uint getWorkTotal() const override {
-            return jobs.size() + jobsDone + busyWorkers;
+            std::lock_guard<std::mutex> lock(state->mutex);
+            return state->jobs.size() + state->jobsDone + state->busyWorkers;
         }
 
         uint getWorkDone() const override {
-            return jobsDone;
+            return state->jobsDone;
         }
 
         virtual void waitForEnd() override {
             using namespace std::chrono_literals;
-            while (working) {
+            while (state->working) {
                 std::this_thread::sleep_for(2ms);
                 update();
             }
         }
 
         uint getWorkersCount() const {
-            return threads.size();
+            return workersCount;
         }
     };
 
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace util {
+    /// @brief Open-addressing hash map with linear probing stored in
+    /// a single array. Elements can not be erased one by one, but clear()
+    /// is O(1) and keeps allocated memory, so the map is suitable for
+    /// reuse across many short searches
+    template <typename K, typename V, typename Hash = std::hash<K>>
+    class flat_hash_map {
+        struct slot {
+            K key;
+            V value;
+        };
+        std::vector<slot> slots;
+        /// @brief Slot is occupied if its stamp is equal to the current one
+        std::vector<uint32_t> stamps;
+        uint32_t stamp = 1;
+        size_t size_ = 0;
+        Hash hash {};
+
+        size_t find_slot(const K& key) const {
+            size_t mask = slots.size() - 1;
+            size_t index = hash(key) & mask;
+            while (stamps[index] == stamp && !(slots[index].key == key)) {
+                index = (index + 1) & mask;
+            }
+            return index;
+        }
+
+        void grow() {
+            std::vector<slot> oldSlots(std::max<size_t>(16, slots.size() * 2));
+            std::vector<uint32_t> oldStamps(oldSlots.size());
+            std::swap(oldSlots, slots);
+            std::swap(oldStamps, stamps);
+            uint32_t oldStamp = stamp;
+            stamp = 1;
+            for (size_t i = 0; i < oldSlots.size(); i++) {
+                if (oldStamps[i] == oldStamp) {
+                    size_t index = find_slot(oldSlots[i].key);
+                    slots[index] = std::move(oldSlots[i]);
+                    stamps[index] = stamp;
+                }
+            }
+        }
+    public:
+        flat_hash_map() = default;
+
+        /// @return pointer to the value or nullptr if key not found
+        V* find(const K& key) {
+            if (size_ == 0) {
+                return nullptr;
+            }
+            size_t index = find_slot(key);
+            return stamps[index] == stamp ? &slots[index].value : nullptr;
+        }
+
+        const V* find(const K& key) const {
+            return const_cast<flat_hash_map*>(this)->find(key);
+        }
+
+        bool contains(const K& key) const {
+            return find(key) != nullptr;
+        }
+
+        /// @brief Insert value if the key is not present
+        /// @return pointer to the value stored and true if inserted
+        std::pair<V*, bool> try_emplace(const K& key, V value) {
+            // keep load factor under 0.5
+            if ((size_ + 1) * 2 > slots.size()) {
+                grow();
+            }
+            size_t index = find_slot(key);
+            if (stamps[index] == stamp) {
+                return {&slots[index].value, false};
+            }
+            slots[index] = {key, std::move(value)};
+            stamps[index] = stamp;
+            size_++;
+            return {&slots[index].value, true};
+        }
+
+        V& operator[](const K& key) {
+            return *try_emplace(key, V {}).first;
+        }
+
+        /// @brief Remove all elements keeping allocated memory
+        void clear() {
+            size_ = 0;
+            if (++stamp == 0) {
+                std::fill(stamps.begin(), stamps.end(), 0);
+                stamp = 1;
+            }
+        }
+
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+        /// @return number of slots allocated
+        size_t capacity() const {
+            return slots.size();
+        }
+    };
+}
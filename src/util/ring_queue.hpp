@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+namespace util {
+    /// @brief FIFO queue stored in a single growable ring buffer.
+    /// Unlike std::queue it does not allocate memory after reaching
+    /// the max size, so it is suitable for long BFS-like processing
+    template <typename T>
+    class ring_queue {
+        std::vector<T> buffer;
+        size_t head = 0;
+        size_t size_ = 0;
+
+        void grow() {
+            std::vector<T> newBuffer(std::max<size_t>(16, buffer.size() * 2));
+            for (size_t i = 0; i < size_; i++) {
+                newBuffer[i] = std::move(buffer[(head + i) & (buffer.size() - 1)]);
+            }
+            buffer = std::move(newBuffer);
+            head = 0;
+        }
+    public:
+        ring_queue() = default;
+
+        void push(const T& value) {
+            if (size_ == buffer.size()) {
+                grow();
+            }
+            buffer[(head + size_) & (buffer.size() - 1)] = value;
+            size_++;
+        }
+
+        const T& front() const {
+            return buffer[head];
+        }
+
+        void pop() {
+            head = (head + 1) & (buffer.size() - 1);
+            size_--;
+        }
+
+        void clear() {
+            head = 0;
+            size_ = 0;
+        }
+
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+        /// @return number of elements the queue can store without growing
+        size_t capacity() const {
+            return buffer.size();
+        }
+    };
+}
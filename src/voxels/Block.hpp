@@ -48,12 +48,27 @@ struct BlockFuncsSet {
     bool onreplaced : 1;
     bool oninteract : 1;
     bool randupdate : 1;
+    bool randupdates : 1;
     bool onblocktick : 1;
     bool onblockstick : 1;
     bool onblockpresent : 1;
     bool onblockremoved : 1;
 };
 
+/// @brief Interned script events handles (see lua::intern_event).
+/// Set when the block script is loaded
+struct BlockEventsSet {
+    int update = 0;
+    int randupdate = 0;
+    int randupdates = 0;
+    int blockstick = 0;
+    int placed = 0;
+    int replaced = 0;
+    int breaking = 0;
+    int broken = 0;
+    int interact = 0;
+};
+
 struct CoordSystem {
     std::array<glm::ivec3, 3> axes;
     /// @brief Grid 3d position fix offset (for negative vectors)
@@ -287,6 +302,9 @@ public:
         /// @brief set of block callbacks flags
         BlockFuncsSet funcsset {};
 
+        /// @brief block callbacks events handles
+        BlockEventsSet events {};
+
         /// @brief picking item integer id
         itemid_t pickingItem = 0;
 
@@ -1,5 +1,7 @@
 #include "Chunk.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <utility>
 
 #include "content/ContentReport.hpp"
@@ -8,21 +10,55 @@
 #include "util/data_io.hpp"
 #include "voxel.hpp"
 
+static std::atomic<uint64_t> revisions_counter {1};
+
 Chunk::Chunk(int xpos, int zpos, std::shared_ptr<Lightmap> lightmap)
     : x(xpos), z(zpos), lightmap(std::move(lightmap)) {
     bottom = 0;
     top = CHUNK_H;
+    sectionsMask = CHUNK_SECTIONS_ALL;
+    modifiedSections = CHUNK_SECTIONS_ALL;
+    revision = nextRevision();
+}
+
+uint64_t Chunk::nextRevision() {
+    return revisions_counter.fetch_add(1, std::memory_order_relaxed);
 }
 
 void Chunk::updateHeights() {
     flags.dirtyHeights = false;
-    for (uint i = 0; i < CHUNK_VOL; i++) {
+    // mesh building workers may read the mask meanwhile,
+    // so it must not be seen partially built
+    uint16_t mask = 0;
+    for (int s = 0; s < CHUNK_SECTIONS; s++) {
+        const voxel* begin = voxels + s * CHUNK_SECTION_VOL;
+        const voxel* end = begin + CHUNK_SECTION_VOL;
+        if (std::any_of(begin, end, [](const voxel& vox) {
+                return vox.id != BLOCK_AIR;
+            })) {
+            mask |= 1 << s;
+        }
+    }
+    sectionsMask.store(mask, std::memory_order_relaxed);
+    if (mask == 0) {
+        bottom = top = 0;
+        return;
+    }
+    int firstSection = 0;
+    while (!(mask >> firstSection & 1)) {
+        firstSection++;
+    }
+    int lastSection = CHUNK_SECTIONS - 1;
+    while (!(mask >> lastSection & 1)) {
+        lastSection--;
+    }
+    for (int i = firstSection * CHUNK_SECTION_VOL; i < CHUNK_VOL; i++) {
         if (voxels[i].id != 0) {
             bottom = i / (CHUNK_D * CHUNK_W);
             break;
         }
     }
-    for (int i = CHUNK_VOL - 1; i >= 0; i--) {
+    for (int i = (lastSection + 1) * CHUNK_SECTION_VOL - 1; i >= 0; i--) {
         if (voxels[i].id != 0) {
             top = i / (CHUNK_D * CHUNK_W) + 1;
             break;
@@ -2,6 +2,8 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 
@@ -14,6 +16,11 @@
 /// @brief Total bytes number of chunk voxel data
 inline constexpr int CHUNK_DATA_LEN = CHUNK_VOL * 4;
 
+static_assert(CHUNK_SECTIONS <= 16, "sections mask is 16 bits wide");
+
+/// @brief Sections mask with all chunk sections set
+inline constexpr uint16_t CHUNK_SECTIONS_ALL = (1 << CHUNK_SECTIONS) - 1;
+
 class ContentReport;
 class Inventory;
 
@@ -26,6 +33,16 @@ class Chunk {
 public:
     int x, z;
     int bottom, top;
+    /// @brief Bitmask of sections which may contain non-air voxels.
+    /// Bits are set on blocks placement and cleared by updateHeights.
+    /// Atomic as it is read by mesh building workers
+    std::atomic<uint16_t> sectionsMask;
+    /// @brief Bitmask of sections which meshes are outdated.
+    /// Bits are set together with flags.modified and cleared by renderer
+    uint16_t modifiedSections;
+    /// @brief Unique value changed on every voxels modification
+    /// (see setModifiedAndUnsaved) used to validate derived caches
+    uint64_t revision;
     voxel voxels[CHUNK_VOL] {};
     std::shared_ptr<Lightmap> lightmap;
     struct {
@@ -47,9 +64,24 @@ public:
 
     Chunk(int x, int z, std::shared_ptr<Lightmap> lightmap=nullptr);
 
-    /// @brief Refresh `bottom` and `top` values
+    /// @brief Refresh `bottom`, `top` and `sectionsMask` values
     void updateHeights();
 
+    inline bool isSectionEmpty(int index) const {
+        return !(sectionsMask.load(std::memory_order_relaxed) >> index & 1);
+    }
+
+    /// @brief Call func(index) for each non-empty section bottom to top
+    template <typename Func>
+    inline void forEachSection(const Func& func) const {
+        uint16_t mask = sectionsMask.load(std::memory_order_relaxed);
+        for (int i = 0; i < CHUNK_SECTIONS; i++) {
+            if (mask >> i & 1) {
+                func(i);
+            }
+        }
+    }
+
     /// @brief Creates new block inventory given size
     /// @return inventory id or 0 if block does not exists
     void addBlockInventory(
@@ -61,11 +93,42 @@ public:
     /// @return inventory bound to the given block or nullptr
     std::shared_ptr<Inventory> getBlockInventory(uint x, uint y, uint z) const;
 
-    inline void setModifiedAndUnsaved() {
+    /// @brief Mark meshes of all sections outdated
+    inline void setModified() {
+        flags.modified = true;
+        modifiedSections = CHUNK_SECTIONS_ALL;
+    }
+
+    /// @brief Mark meshes of sections depending on voxels at Y outdated
+    inline void setModified(int y) {
         flags.modified = true;
+        modifiedSections |= getSectionsAround(y);
+    }
+
+    inline void setModifiedAndUnsaved() {
+        setModified();
         flags.unsaved = true;
+        revision = nextRevision();
     }
 
+    /// @brief Mark voxels at Y modified and chunk unsaved
+    inline void setModifiedAndUnsaved(int y) {
+        setModified(y);
+        flags.unsaved = true;
+        revision = nextRevision();
+    }
+
+    /// @return bitmask of sections which meshes depend on voxels at Y
+    /// (voxels are used by faces culling and lighting of neighbours)
+    static inline uint16_t getSectionsAround(int y) {
+        int lower = std::max(y - 1, 0) / CHUNK_SECTION_H;
+        int upper = std::min(y + 1, CHUNK_H - 1) / CHUNK_SECTION_H;
+        return (1 << lower) | (1 << upper);
+    }
+
+    /// @return new value unique among all chunks
+    static uint64_t nextRevision();
+
     /// @brief Encode chunk to bytes array of size CHUNK_DATA_LEN
     /// @see /doc/specs/region_voxels_chunk_spec.md
     std::unique_ptr<ubyte[]> encode() const;
@@ -335,6 +335,12 @@ bool Chunks::putChunk(const std::shared_ptr<Chunk>& chunk) {
 // 25.06.2024: not now
 // 11.11.2024: not now
 void Chunks::getVoxels(VoxelsVolume& volume, bool backlight) const {
+    getVoxels(volume, backlight, 0, volume.getH());
+}
+
+void Chunks::getVoxels(
+    VoxelsVolume& volume, bool backlight, int minY, int maxY
+) const {
     voxel* voxels = volume.getVoxels();
     light_t* lights = volume.getLights();
     int x = volume.getX();
@@ -342,8 +348,9 @@ void Chunks::getVoxels(VoxelsVolume& volume, bool backlight) const {
     int z = volume.getZ();
 
     int w = volume.getW();
-    int h = volume.getH();
     int d = volume.getD();
+    minY = std::max(minY, 0);
+    maxY = std::min(maxY, volume.getH());
 
     int scx = floordiv<CHUNK_W>(x);
     int scz = floordiv<CHUNK_D>(z);
@@ -360,7 +367,7 @@ void Chunks::getVoxels(VoxelsVolume& volume, bool backlight) const {
             const auto chunk = getChunk(cx, cz);
             if (chunk == nullptr) {
                 // no chunk loaded -> filling with BLOCK_VOID
-                for (int ly = y; ly < y + h; ly++) {
+                for (int ly = y + minY; ly < y + maxY; ly++) {
                     for (int lz = std::max(z, cz * CHUNK_D);
                              lz < std::min(z + d, (cz + 1) * CHUNK_D);
                              lz++) {
@@ -377,7 +384,7 @@ void Chunks::getVoxels(VoxelsVolume& volume, bool backlight) const {
                 const voxel* cvoxels = chunk->voxels;
                 const light_t* clights =
                     chunk->lightmap ? chunk->lightmap->getLights() : nullptr;
-                for (int ly = y; ly < y + h; ly++) {
+                for (int ly = y + minY; ly < y + maxY; ly++) {
                     for (int lz = std::max(z, cz * CHUNK_D);
                              lz < std::min(z + d, (cz + 1) * CHUNK_D);
                              lz++) {
@@ -128,6 +128,12 @@ public:
 
     void getVoxels(VoxelsVolume& volume, bool backlight = false) const;
 
+    /// @brief Copy voxels and lights of the volume rows in range
+    /// [minY, maxY) relative to the volume, other rows are kept unchanged
+    void getVoxels(
+        VoxelsVolume& volume, bool backlight, int minY, int maxY
+    ) const;
+
     void setCenter(int32_t x, int32_t z);
     void resize(uint32_t newW, uint32_t newD);
 
@@ -23,7 +23,12 @@
 static debug::Logger logger("chunks-storage");
 
 GlobalChunks::GlobalChunks(Level& level)
-    : level(level), indices(*level.content.getIndices()) {
+    : level(&level), indices(*level.content.getIndices()) {
+    chunksMap.max_load_factor(CHUNKS_MAP_MAX_LOAD_FACTOR);
+}
+
+GlobalChunks::GlobalChunks(const ContentIndices& indices)
+    : level(nullptr), indices(indices) {
     chunksMap.max_load_factor(CHUNKS_MAP_MAX_LOAD_FACTOR);
 }
 
@@ -102,12 +107,15 @@ std::shared_ptr<Chunk> GlobalChunks::create(int x, int z, bool lighting) {
     auto chunk =
         chunks_pool.create(x, z, lighting ? lightmaps_pool.create() : nullptr);
     chunksMap[keyfrom(x, z)] = chunk;
+    if (level == nullptr) {
+        return chunk;
+    }
 
-    World& world = *level.getWorld();
+    World& world = *level->getWorld();
     auto& regions = world.wfile.get()->getRegions();
 
     if (auto data = regions.getVoxels(chunk->x, chunk->z)) {
-        const auto& indices = *level.content.getIndices();
+        const auto& indices = *level->content.getIndices();
 
         chunk->decode(data.get());
         check_voxels(indices, *chunk);
@@ -118,13 +126,13 @@ std::shared_ptr<Chunk> GlobalChunks::create(int x, int z, bool lighting) {
 
         auto entitiesData = regions.fetchEntities(chunk->x, chunk->z);
         if (entitiesData.getType() == dv::value_type::object) {
-            level.entities->loadEntities(std::move(entitiesData));
+            level->entities->loadEntities(std::move(entitiesData));
             chunk->flags.entities = true;
         }
 
         chunk->flags.loaded = true;
         for (auto& entry : chunk->inventories) {
-            level.inventories->store(entry.second);
+            level->inventories->store(entry.second);
         }
     }
     if (chunk->lightmap) {
@@ -183,20 +191,21 @@ void GlobalChunks::decref(Chunk* chunk) {
 }
 
 void GlobalChunks::save(Chunk* chunk) {
-    if (chunk == nullptr) {
+    if (chunk == nullptr || level == nullptr) {
         return;
     }
     AABB aabb = chunk->getAABB();
-    auto entities = level.entities->getAllInside(aabb);
+    auto entities = level->entities->getAllInside(aabb);
     auto root = dv::object();
-    root["data"] = level.entities->serialize(entities);
+    root["data"] = level->entities->serialize(entities);
     if (!entities.empty()) {
         chunk->flags.entities = true;
     }
-    level.getWorld()->wfile->getRegions().put(
+    level->getWorld()->wfile->getRegions().put(
         chunk,
-        chunk->flags.entities ? json::to_binary(root, true)
-                                : std::vector<ubyte>()
+        // compressed by the regions layer
+        chunk->flags.entities ? json::to_binary(root)
+                              : std::vector<ubyte>()
     );
 }
 
@@ -26,7 +26,7 @@ class GlobalChunks {
         return ekey.key;
     }
 
-    Level& level;
+    Level* level;
     const ContentIndices& indices;
     std::unordered_map<uint64_t, std::shared_ptr<Chunk>> chunksMap;
     std::unordered_map<glm::ivec2, std::shared_ptr<Chunk>> pinnedChunks;
@@ -35,6 +35,9 @@ class GlobalChunks {
     consumer<Chunk&> onUnload;
 public:
     GlobalChunks(Level& level);
+    /// @brief Create storage not bound to a level.
+    /// Chunks are not loaded from or saved to the world files
+    GlobalChunks(const ContentIndices& indices);
     ~GlobalChunks() = default;
 
     void setOnUnload(consumer<Chunk&> onUnload);
@@ -1,6 +1,12 @@
 #include "Pathfinding.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+
 #include "content/Content.hpp"
+#include "maths/voxmaths.hpp"
+#include "util/JobSystem.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/GlobalChunks.hpp"
 #include "voxels/blocks_agent.hpp"
@@ -8,30 +14,76 @@
 
 inline constexpr float SQRT2 = 1.4142135623730951f;  // sqrt(2)
 
+/// @brief Cached chunks abstractions count per agent profile
+/// after which abstractions of unloaded chunks are dropped
+inline constexpr size_t MAX_CACHED_CHUNK_NAVS = 1024;
+
+/// @brief Max number of threads performing agents in performAllAsync
+inline constexpr size_t MAX_PATHFINDING_THREADS = 4;
+/// @brief Min number of agents to perform in a separate thread
+inline constexpr size_t MIN_AGENTS_PER_THREAD = 8;
+
 using namespace voxels;
 
+static const glm::ivec2 NEIGHBOURS[] {
+    {0, 1},
+    {1, 0},
+    {0, -1},
+    {-1, 0},
+    {-1, -1},
+    {1, -1},
+    {1, 1},
+    {-1, 1},
+};
+inline constexpr int NEIGHBOURS_COUNT = sizeof(NEIGHBOURS) / sizeof(glm::ivec2);
+
+/// @brief Chunk sides (-X, +X, -Z, +Z) as indices of NEIGHBOURS
+inline constexpr int SIDE_DIRECTIONS[] {3, 1, 2, 0};
+/// @brief Opposite chunk sides directions
+inline constexpr int SIDE_BACK_DIRECTIONS[] {1, 3, 0, 2};
+
 static float heuristic(const glm::ivec3& a, const glm::ivec3& b) {
     return glm::distance(glm::vec3(a), glm::vec3(b));
 }
 
+/// @brief Admissible heuristic for step costs (diagonal step costs 2)
+static float manhattan_xz(const glm::ivec3& a, const glm::ivec3& b) {
+    return glm::abs(a.x - b.x) + glm::abs(a.z - b.z);
+}
+
+static bool is_target_reached(
+    const glm::ivec3& pos, const glm::ivec3& target, int height
+) {
+    return pos.x == target.x && glm::abs((pos.y - target.y) / height) == 0 &&
+           pos.z == target.z;
+}
+
+static glm::ivec2 chunk_of(const glm::ivec3& pos) {
+    return {floordiv<CHUNK_W>(pos.x), floordiv<CHUNK_D>(pos.z)};
+}
+
 Pathfinding::Pathfinding(const Level& level)
-    : level(level),
-      chunks(*level.chunks),
-      blockDefs(level.content.getIndices()->blocks) {
+    : Pathfinding(*level.chunks, level.content.getIndices()->blocks) {
+}
+
+Pathfinding::Pathfinding(
+    const GlobalChunks& chunks, const ContentUnitIndices<Block>& blockDefs
+)
+    : chunks(chunks), blockDefs(blockDefs) {
 }
 
 static bool check_passability(
     const Agent& agent,
     const GlobalChunks& chunks,
-    const Node& node,
+    const glm::ivec3& pos,
     const glm::ivec2& offset,
     bool diagonal
 ) {
     if (!diagonal) {
         return true;
     }
-    auto a = node.pos + glm::ivec3(offset.x, 0, 0);
-    auto b = node.pos + glm::ivec3(0, 0, offset.y);
+    auto a = pos + glm::ivec3(offset.x, 0, 0);
+    auto b = pos + glm::ivec3(0, 0, offset.y);
 
     for (int i = 0; i < agent.height; i++) {
         if (blocks_agent::is_obstacle_at(chunks, a.x, a.y + i, a.z))
@@ -45,20 +97,32 @@ static bool check_passability(
 static void restore_route(
     Route& route,
     const glm::ivec3& lastPos,
-    const std::unordered_map<glm::ivec3, Node>& parents
+    const util::flat_hash_map<glm::ivec3, glm::ivec3, PositionHash>& parents
 ) {
     auto pos = lastPos;
     while (true) {
-        const auto& found = parents.find(pos);
-        if (found == parents.end()) {
+        auto parent = parents.find(pos);
+        if (parent == nullptr) {
             route.nodes.push_back({pos});
             break;
         }
         route.nodes.push_back({pos});
-        pos = found->second.pos;
+        pos = *parent;
     }
 }
 
+static void push_node(std::vector<Node>& queue, const Node& node) {
+    queue.push_back(node);
+    std::push_heap(queue.begin(), queue.end(), NodeLess {});
+}
+
+static Node pop_node(std::vector<Node>& queue) {
+    std::pop_heap(queue.begin(), queue.end(), NodeLess {});
+    Node node = queue.back();
+    queue.pop_back();
+    return node;
+}
+
 int Pathfinding::createAgent() {
     int id = nextAgent++;
     agents[id] = Agent();
@@ -75,12 +139,33 @@ bool Pathfinding::removeAgent(int id) {
 }
 
 void Pathfinding::performAllAsync(int stepsPerAgent) {
+    std::vector<Agent*> pending;
     for (auto& [_, agent] : agents) {
-        if (agent.state.finished) {
-            continue;
+        if (!agent.state.finished) {
+            pending.push_back(&agent);
         }
-        perform(agent, stepsPerAgent);
     }
+    if (pending.empty()) {
+        return;
+    }
+    pruneNavCache();
+
+    auto& jobSystem = util::JobSystem::getInstance();
+    size_t threadsCount = std::min<size_t>(
+        std::min<size_t>(
+            MAX_PATHFINDING_THREADS, jobSystem.getThreadsCount() + 1
+        ),
+        pending.size() / MIN_AGENTS_PER_THREAD
+    );
+    // chunks are not modified until all agents are performed
+    std::atomic<size_t> next {0};
+    auto performPending = [this, &pending, &next, stepsPerAgent](size_t) {
+        size_t index;
+        while ((index = next.fetch_add(1)) < pending.size()) {
+            performAgent(*pending[index], stepsPerAgent);
+        }
+    };
+    jobSystem.parallel(std::max<size_t>(1, threadsCount), performPending);
 }
 
 static Route finish_route(Agent& agent, State&& state) {
@@ -101,17 +186,53 @@ enum Passability {
     PASSABLE = 1,
 };
 
+bool Pathfinding::step(
+    const Agent& agent,
+    const glm::ivec3& src,
+    int direction,
+    glm::ivec3& dst,
+    float& cost
+) {
+    const auto& offset = NEIGHBOURS[direction];
+    auto pos = src;
+
+    cost = 0.0f;
+    int surface =
+        getSurfaceAt(agent, pos + glm::ivec3(offset.x, 0, offset.y), 1, cost);
+    if (surface == NON_PASSABLE) {
+        return false;
+    }
+    pos.y = surface;
+    if (blocks_agent::is_obstacle_at(
+            chunks, pos.x, pos.y + agent.jumpHeight, pos.z
+        )) {
+        return false;
+    }
+    if (!check_passability(agent, chunks, src, offset, direction >= 4)) {
+        return false;
+    }
+    dst = pos + glm::ivec3(offset.x, 0, offset.y);
+    cost += glm::abs(offset.x) + glm::abs(offset.y);
+    return true;
+}
+
 Route Pathfinding::perform(Agent& agent, int maxVisited) {
-    using namespace blocks_agent;
+    pruneNavCache();
+    return performAgent(agent, maxVisited);
+}
 
+Route Pathfinding::performAgent(Agent& agent, int maxVisited) {
+    if (agent.hierarchical && maxVisited != 0) {
+        return performHierarchical(agent);
+    }
     State state = std::move(agent.state);
     if (state.queue.empty()) {
-        state.queue.push(
+        push_node(
+            state.queue,
             {agent.start, {}, 0, heuristic(agent.start, agent.target)}
         );
     }
 
-    const auto& chunks = *level.chunks;
     int height = std::max(agent.height, 1);
 
     if (state.nearest == glm::ivec3(0)) {
@@ -134,67 +255,33 @@ Route Pathfinding::perform(Agent& agent, int maxVisited) {
             return {};
         }
 
-        auto node = state.queue.top();
-        state.queue.pop();
+        auto node = pop_node(state.queue);
 
-        if (node.pos.x == agent.target.x &&
-            glm::abs((node.pos.y - agent.target.y) / height) == 0 &&
-            node.pos.z == agent.target.z) {
+        if (is_target_reached(node.pos, agent.target, height)) {
             return finish_route(agent, std::move(state));
         }
 
-        state.blocked.emplace(node.pos);
-        glm::ivec2 neighbors[8] {
-            {0, 1},
-            {1, 0},
-            {0, -1},
-            {-1, 0},
-            {-1, -1},
-            {1, -1},
-            {1, 1},
-            {-1, 1},
-        };
+        state.blocked.try_emplace(node.pos, true);
 
-        for (int i = 0; i < sizeof(neighbors) / sizeof(glm::ivec2); i++) {
-            auto offset = neighbors[i];
-            auto pos = node.pos;
-
-            float cost = glm::abs(node.pos.y - pos.y) * 10;
-            int surface = getSurfaceAt(
-                agent, pos + glm::ivec3(offset.x, 0, offset.y), 1, cost
-            );
-
-            if (surface == NON_PASSABLE) {
+        for (int i = 0; i < NEIGHBOURS_COUNT; i++) {
+            glm::ivec3 point;
+            float cost;
+            if (!step(agent, node.pos, i, point, cost)) {
                 continue;
             }
-            pos.y = surface;
-            auto point = pos + glm::ivec3(offset.x, 0, offset.y);
-            if (state.blocked.find(point) != state.blocked.end()) {
+            if (state.blocked.contains(point)) {
                 continue;
             }
-
-            if (is_obstacle_at(
-                    chunks, pos.x, pos.y + agent.jumpHeight, pos.z
-                )) {
-                continue;
-            }
-            if (!check_passability(agent, chunks, node, offset, i >= 4)) {
-                continue;
-            }
-
-            float sum = glm::abs(offset.x) + glm::abs(offset.y);
-            float gScore = node.gScore + sum + cost;
-            const auto& found = state.parents.find(point);
-            if (found == state.parents.end()) {
+            float gScore = node.gScore + cost;
+            if (!state.parents.contains(point)) {
                 float hScore = heuristic(point, agent.target);
                 if (hScore < state.minHScore) {
                     state.minHScore = hScore;
                     state.nearest = point;
                 }
                 float fScore = gScore * 0.75f + hScore;
-                Node nNode {point, node.pos, gScore, fScore};
-                state.parents[point] = node;
-                state.queue.push(nNode);
+                state.parents.try_emplace(point, node.pos);
+                push_node(state.queue, {point, node.pos, gScore, fScore});
             }
         }
     }
@@ -203,6 +290,527 @@ Route Pathfinding::perform(Agent& agent, int maxVisited) {
     return finish_route(agent, std::move(agent.state));
 }
 
+const Node* Pathfinding::searchInChunk(
+    const Agent& agent,
+    const glm::ivec3& start,
+    const glm::ivec2& chunkPos,
+    const glm::ivec3* target,
+    int height,
+    NodesMap& nodes,
+    int& visited
+) {
+    glm::ivec2 min = chunkPos * glm::ivec2(CHUNK_W, CHUNK_D);
+    glm::ivec2 max = min + glm::ivec2(CHUNK_W, CHUNK_D);
+
+    std::priority_queue<Node, std::vector<Node>, NodeLess> queue;
+    std::unordered_set<glm::ivec3> closed;
+    nodes.clear();
+    nodes[start] = {start, start, 0.0f, 0.0f};
+    queue.push(nodes[start]);
+
+    while (!queue.empty()) {
+        auto node = queue.top();
+        queue.pop();
+        if (!closed.insert(node.pos).second) {
+            continue;
+        }
+        visited++;
+        if (target && is_target_reached(node.pos, *target, height)) {
+            return &nodes[node.pos];
+        }
+        for (int i = 0; i < NEIGHBOURS_COUNT; i++) {
+            glm::ivec3 point;
+            float cost;
+            if (!step(agent, node.pos, i, point, cost)) {
+                continue;
+            }
+            if (point.x < min.x || point.z < min.y || point.x >= max.x ||
+                point.z >= max.y) {
+                continue;
+            }
+            if (closed.find(point) != closed.end()) {
+                continue;
+            }
+            float gScore = node.gScore + cost;
+            const auto& found = nodes.find(point);
+            if (found != nodes.end() && found->second.gScore <= gScore) {
+                continue;
+            }
+            float fScore = gScore;
+            if (target) {
+                fScore += manhattan_xz(point, *target);
+            }
+            Node nNode {point, node.pos, gScore, fScore};
+            nodes[point] = nNode;
+            queue.push(nNode);
+        }
+    }
+    return nullptr;
+}
+
+/// @brief Append route from the search start to the position
+/// excluding the start
+static void restore_local_route(
+    std::vector<glm::ivec3>& dst,
+    const std::unordered_map<glm::ivec3, Node>& nodes,
+    glm::ivec3 pos
+) {
+    size_t begin = dst.size();
+    while (true) {
+        const auto& node = nodes.at(pos);
+        if (node.parent == node.pos) {
+            break;
+        }
+        dst.push_back(pos);
+        pos = node.parent;
+    }
+    std::reverse(dst.begin() + begin, dst.end());
+}
+
+ChunkNav* Pathfinding::getChunkNav(
+    const Agent& agent, const glm::ivec2& chunkPos
+) {
+    auto chunk = chunks.getChunk(chunkPos.x, chunkPos.y);
+    if (chunk == nullptr) {
+        return nullptr;
+    }
+    std::lock_guard lock(navMutex);
+    auto& navs =
+        navCache[NavProfile {agent.height, agent.jumpHeight, agent.avoidTags}];
+    auto& nav = navs[chunkPos];
+
+    bool valid = nav.chunk == chunk && nav.revisions[0] == chunk->revision;
+    for (int side = 0; side < 4 && valid; side++) {
+        const auto& offset = NEIGHBOURS[SIDE_DIRECTIONS[side]];
+        auto neighbour =
+            chunks.getChunk(chunkPos.x + offset.x, chunkPos.y + offset.y);
+        valid = nav.revisions[side + 1] == (neighbour ? neighbour->revision : 0);
+    }
+    if (!valid) {
+        buildChunkNav(agent, chunkPos, nav);
+    }
+    return &nav;
+}
+
+namespace {
+    /// @brief Passage through chunks border. Positions are stored in
+    /// the same order (negative side first) for both chunks, so both
+    /// select the same portals
+    struct Passage {
+        int column;
+        int y[2];
+        float cost[2];
+    };
+}
+
+void Pathfinding::buildChunkNav(
+    const Agent& agent, const glm::ivec2& chunkPos, ChunkNav& nav
+) {
+    auto chunk = chunks.getChunk(chunkPos.x, chunkPos.y);
+    nav.chunk = chunk;
+    nav.revisions[0] = chunk->revision;
+    nav.portals.clear();
+    nav.costs.clear();
+
+    glm::ivec2 min = chunkPos * glm::ivec2(CHUNK_W, CHUNK_D);
+    std::vector<int> surfaces[2];
+    std::vector<Passage> passages;
+
+    for (int side = 0; side < 4; side++) {
+        const auto& offset = NEIGHBOURS[SIDE_DIRECTIONS[side]];
+        auto neighbour =
+            chunks.getChunk(chunkPos.x + offset.x, chunkPos.y + offset.y);
+        nav.revisions[side + 1] = neighbour ? neighbour->revision : 0;
+        if (neighbour == nullptr) {
+            continue;
+        }
+        // index of the inner column in Passage::y
+        int inner = (offset.x + offset.y) > 0 ? 0 : 1;
+        int columns = offset.x ? CHUNK_D : CHUNK_W;
+        int directions[2] {SIDE_DIRECTIONS[side], SIDE_BACK_DIRECTIONS[side]};
+        const Chunk* columnChunks[2] {chunk, neighbour};
+
+        passages.clear();
+        for (int column = 0; column < columns; column++) {
+            glm::ivec2 xz[2];
+            if (offset.x) {
+                xz[0] = {offset.x < 0 ? 0 : CHUNK_W - 1, column};
+            } else {
+                xz[0] = {column, offset.y < 0 ? 0 : CHUNK_D - 1};
+            }
+            xz[0] += min;
+            xz[1] = xz[0] + offset;
+
+            size_t first = passages.size();
+            for (int c = 0; c < 2; c++) {
+                // c == 0 - from inner column to outer one
+                surfaces[c].clear();
+                // there is only air below the bottom and above the top
+                int bottom = std::max(columnChunks[c]->bottom, 0);
+                int top = std::min(columnChunks[c]->top, CHUNK_H - 1);
+                int ncost = 0;
+                bool obstacle =
+                    checkPoint(agent, xz[c].x, bottom, xz[c].y, ncost) ==
+                    OBSTACLE;
+                for (int y = bottom + 1; y <= top; y++) {
+                    bool isObstacle =
+                        checkPoint(agent, xz[c].x, y, xz[c].y, ncost) ==
+                        OBSTACLE;
+                    if (obstacle && !isObstacle) {
+                        surfaces[c].push_back(y);
+                    }
+                    obstacle = isObstacle;
+                }
+                for (int y : surfaces[c]) {
+                    glm::ivec3 src(xz[c].x, y, xz[c].y);
+                    glm::ivec3 dst;
+                    float cost;
+                    if (!step(agent, src, directions[c], dst, cost)) {
+                        continue;
+                    }
+                    int from = c == 0 ? inner : 1 - inner;
+                    int ys[2];
+                    ys[from] = y;
+                    ys[1 - from] = dst.y;
+                    auto found = std::find_if(
+                        passages.begin() + first,
+                        passages.end(),
+                        [&ys](const auto& p) {
+                            return p.y[0] == ys[0] && p.y[1] == ys[1];
+                        }
+                    );
+                    if (found == passages.end()) {
+                        passages.push_back({column, {ys[0], ys[1]}, {-1, -1}});
+                        found = passages.end() - 1;
+                    }
+                    // cost[0] - from negative side to positive one
+                    found->cost[from] = cost;
+                }
+            }
+            std::sort(
+                passages.begin() + first,
+                passages.end(),
+                [](const auto& a, const auto& b) {
+                    return a.y[0] < b.y[0] ||
+                           (a.y[0] == b.y[0] && a.y[1] < b.y[1]);
+                }
+            );
+        }
+
+        // group passages continuing each other in adjacent columns
+        std::vector<size_t> groups(passages.size());
+        std::iota(groups.begin(), groups.end(), 0);
+        auto root = [&groups](size_t i) {
+            while (groups[i] != i) {
+                i = groups[i] = groups[groups[i]];
+            }
+            return i;
+        };
+        for (size_t i = 0; i < passages.size(); i++) {
+            for (size_t j = i; j-- > 0;) {
+                const auto& a = passages[i];
+                const auto& b = passages[j];
+                if (b.column < a.column - 1) {
+                    break;
+                }
+                if (b.column == a.column - 1 &&
+                    glm::abs(a.y[0] - b.y[0]) <= 1 &&
+                    glm::abs(a.y[1] - b.y[1]) <= 1) {
+                    // root is the first passage of the group
+                    size_t ra = root(i);
+                    size_t rb = root(j);
+                    groups[std::max(ra, rb)] = std::min(ra, rb);
+                }
+            }
+        }
+        for (size_t i = 0; i < passages.size(); i++) {
+            if (root(i) != i) {
+                continue;
+            }
+            std::vector<const Passage*> members;
+            std::vector<const Passage*> twoWay;
+            for (size_t j = i; j < passages.size(); j++) {
+                if (root(j) == i) {
+                    members.push_back(&passages[j]);
+                    if (passages[j].cost[0] >= 0 && passages[j].cost[1] >= 0) {
+                        twoWay.push_back(&passages[j]);
+                    }
+                }
+            }
+            const auto& candidates = twoWay.empty() ? members : twoWay;
+            const auto& passage = *candidates[candidates.size() / 2];
+
+            glm::ivec2 xz = offset.x
+                ? glm::ivec2(offset.x < 0 ? 0 : CHUNK_W - 1, passage.column)
+                : glm::ivec2(passage.column, offset.y < 0 ? 0 : CHUNK_D - 1);
+            xz += min;
+            int outer = 1 - inner;
+            // cost index is the side the step starts from
+            nav.portals.push_back(Portal {
+                {xz.x, passage.y[inner], xz.y},
+                {xz.x + offset.x, passage.y[outer], xz.y + offset.y},
+                passage.cost[inner]
+            });
+        }
+    }
+    nav.costs.resize(nav.portals.size());
+}
+
+const std::vector<float>& Pathfinding::getPortalCosts(
+    const Agent& agent,
+    const glm::ivec2& chunkPos,
+    ChunkNav& nav,
+    size_t index
+) {
+    auto& costs = nav.costs[index];
+    {
+        std::lock_guard lock(navMutex);
+        if (!costs.empty()) {
+            return costs;
+        }
+    }
+    NodesMap nodes;
+    int visited = 0;
+    searchInChunk(
+        agent, nav.portals[index].pos, chunkPos, nullptr, 1, nodes, visited
+    );
+    std::vector<float> computed(nav.portals.size(), -1.0f);
+    for (size_t i = 0; i < nav.portals.size(); i++) {
+        const auto& found = nodes.find(nav.portals[i].pos);
+        if (found != nodes.end()) {
+            computed[i] = found->second.gScore;
+        }
+    }
+    std::lock_guard lock(navMutex);
+    // may be computed by another thread meanwhile
+    if (costs.empty()) {
+        costs = std::move(computed);
+    }
+    return costs;
+}
+
+void Pathfinding::pruneNavCache() {
+    for (auto& [_, navs] : navCache) {
+        if (navs.size() <= MAX_CACHED_CHUNK_NAVS) {
+            continue;
+        }
+        for (auto it = navs.begin(); it != navs.end();) {
+            const auto& pos = it->first;
+            if (chunks.getChunk(pos.x, pos.y) != it->second.chunk) {
+                it = navs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+/// @brief Find portal of the chunk at the position, preferring one
+/// leading back to the source position
+static int find_portal(
+    const ChunkNav& nav, const glm::ivec3& pos, const glm::ivec3& source
+) {
+    int index = -1;
+    for (size_t i = 0; i < nav.portals.size(); i++) {
+        const auto& portal = nav.portals[i];
+        if (portal.pos != pos) {
+            continue;
+        }
+        if (portal.exit == source) {
+            return i;
+        }
+        if (index == -1) {
+            index = i;
+        }
+    }
+    return index;
+}
+
+Route Pathfinding::performHierarchical(Agent& agent) {
+    int height = std::max(agent.height, 1);
+    const auto& start = agent.start;
+    const auto& target = agent.target;
+    auto startChunk = chunk_of(start);
+    auto targetChunk = chunk_of(target);
+
+    // abstract graph nodes are (chunk x, chunk z, portal index)
+    const glm::ivec3 startKey(startChunk, -1);
+    const glm::ivec3 goalKey(targetChunk, -2);
+
+    Route route {};
+    std::vector<glm::ivec3> positions;
+    NodesMap nodes;
+    NodesMap graph;
+    std::unordered_set<glm::ivec3> closed;
+    std::priority_queue<Node, std::vector<Node>, NodeLess> queue;
+    int visited = 0;
+
+    // abstractions of chunks used by the search
+    std::unordered_map<glm::ivec2, ChunkNav*> navs;
+    auto nav_of = [this, &agent, &navs](const glm::ivec2& chunkPos) {
+        const auto& found = navs.find(chunkPos);
+        if (found != navs.end()) {
+            return found->second;
+        }
+        return navs[chunkPos] = getChunkNav(agent, chunkPos);
+    };
+    auto portal_of = [&navs](const glm::ivec3& key) -> const Portal& {
+        return navs.at({key.x, key.y})->portals.at(key.z);
+    };
+    auto push = [&](const glm::ivec3& key, const glm::ivec3& parent,
+                    float gScore, const glm::ivec3& pos) {
+        if (closed.find(key) != closed.end()) {
+            return;
+        }
+        const auto& found = graph.find(key);
+        if (found != graph.end() && found->second.gScore <= gScore) {
+            return;
+        }
+        Node node {key, parent, gScore, gScore + manhattan_xz(pos, target)};
+        graph[key] = node;
+        queue.push(node);
+    };
+
+    graph[startKey] = {startKey, startKey, 0.0f, 0.0f};
+    ChunkNav* startNav = nav_of(startChunk);
+    if (startNav == nullptr) {
+        route.nodes.push_back({start});
+        route.found = true;
+        agent.state.finished = true;
+        agent.route = route;
+        return route;
+    }
+    if (startChunk == targetChunk) {
+        if (auto node = searchInChunk(
+                agent, start, startChunk, &target, height, nodes, visited
+            )) {
+            push(goalKey, startKey, node->gScore, target);
+        }
+    }
+    searchInChunk(agent, start, startChunk, nullptr, 1, nodes, visited);
+    for (size_t i = 0; i < startNav->portals.size(); i++) {
+        const auto& pos = startNav->portals[i].pos;
+        const auto& found = nodes.find(pos);
+        if (found != nodes.end()) {
+            push(
+                glm::ivec3(startChunk, i), startKey, found->second.gScore, pos
+            );
+        }
+    }
+
+    glm::ivec3 last = startKey;
+    float minHScore = manhattan_xz(start, target);
+    while (!queue.empty()) {
+        if (closed.size() >= agent.maxVisitedBlocks) {
+            break;
+        }
+        auto node = queue.top();
+        queue.pop();
+        if (!closed.insert(node.pos).second) {
+            continue;
+        }
+        if (node.pos == goalKey) {
+            last = goalKey;
+            route.found = true;
+            break;
+        }
+        glm::ivec2 chunkPos(node.pos.x, node.pos.y);
+        auto& nav = *navs.at(chunkPos);
+        size_t index = node.pos.z;
+        const auto portal = nav.portals.at(index);
+
+        float hScore = manhattan_xz(portal.pos, target);
+        if (hScore < minHScore) {
+            minHScore = hScore;
+            last = node.pos;
+        }
+        const auto& costs = getPortalCosts(agent, chunkPos, nav, index);
+        for (size_t i = 0; i < costs.size(); i++) {
+            if (i != index && costs[i] >= 0.0f) {
+                push(
+                    glm::ivec3(chunkPos, i),
+                    node.pos,
+                    node.gScore + costs[i],
+                    nav.portals[i].pos
+                );
+            }
+        }
+        if (portal.exitCost >= 0.0f) {
+            auto exitChunk = chunk_of(portal.exit);
+            if (auto exitNav = nav_of(exitChunk)) {
+                int exitIndex = find_portal(*exitNav, portal.exit, portal.pos);
+                if (exitIndex != -1) {
+                    push(
+                        glm::ivec3(exitChunk, exitIndex),
+                        node.pos,
+                        node.gScore + portal.exitCost,
+                        portal.exit
+                    );
+                }
+            }
+        }
+        if (chunkPos == targetChunk) {
+            if (auto found = searchInChunk(
+                    agent, portal.pos, chunkPos, &target, height, nodes, visited
+                )) {
+                push(goalKey, node.pos, node.gScore + found->gScore, target);
+            }
+        }
+    }
+
+    // abstract route from start to the last node
+    std::vector<glm::ivec3> keys;
+    for (auto key = last; key != startKey; key = graph.at(key).parent) {
+        keys.push_back(key);
+    }
+    std::reverse(keys.begin(), keys.end());
+
+    // refinement
+    glm::ivec3 prevKey = startKey;
+    glm::ivec3 prevPos = start;
+    for (const auto& key : keys) {
+        glm::ivec2 chunkPos(prevKey.x, prevKey.y);
+        if (key == goalKey) {
+            auto found = searchInChunk(
+                agent, prevPos, chunkPos, &target, height, nodes, visited
+            );
+            if (found == nullptr) {
+                route.found = false;
+                break;
+            }
+            restore_local_route(positions, nodes, found->pos);
+            break;
+        }
+        const auto& pos = portal_of(key).pos;
+        if (prevKey != startKey && glm::ivec2(key.x, key.y) != chunkPos) {
+            // crossing chunks border
+            positions.push_back(pos);
+        } else {
+            if (searchInChunk(
+                    agent, prevPos, chunkPos, &pos, 1, nodes, visited
+                ) == nullptr) {
+                route.found = false;
+                break;
+            }
+            restore_local_route(positions, nodes, pos);
+        }
+        prevKey = key;
+        prevPos = pos;
+    }
+    if (!route.found && !agent.mayBeIncomplete) {
+        positions.clear();
+    }
+    for (auto it = positions.rbegin(); it != positions.rend(); ++it) {
+        route.nodes.push_back({*it});
+    }
+    route.nodes.push_back({start});
+    route.totalVisited = visited + closed.size();
+    route.found = route.found || agent.mayBeIncomplete;
+    agent.state.finished = true;
+    agent.route = route;
+    return route;
+}
+
 Agent* Pathfinding::getAgent(int id) {
     const auto& found = agents.find(id);
     if (found != agents.end()) {
@@ -4,14 +4,19 @@
 #include <glm/gtx/hash.hpp>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "util/flat_hash_map.hpp"
+
 class Block;
+class Chunk;
 class Level;
 class GlobalChunks;
 
@@ -42,18 +47,48 @@ namespace voxels {
         }
     };
 
+    /// @brief Positions hash with well mixed low bits required by
+    /// open-addressing tables
+    struct PositionHash {
+        size_t operator()(const glm::ivec3& pos) const {
+            uint64_t h = static_cast<uint32_t>(pos.x) * 0x9E3779B97F4A7C15ULL;
+            h ^= static_cast<uint32_t>(pos.y) * 0xC2B2AE3D27D4EB4FULL;
+            h ^= static_cast<uint32_t>(pos.z) * 0x165667B19E3779F9ULL;
+            h ^= h >> 32;
+            h *= 0xD6E8FEB86659FD93ULL;
+            return h ^ (h >> 32);
+        }
+    };
+
+    /// @brief Search state. Memory is reused by the next searches of the
+    /// agent if reset instead of being replaced
     struct State {
-        std::priority_queue<Node, std::vector<Node>, NodeLess> queue;
-        std::unordered_set<glm::ivec3> blocked;
-        std::unordered_map<glm::ivec3, Node> parents;
-        glm::ivec3 nearest;
-        float minHScore;
+        /// @brief Binary heap of nodes to visit ordered with NodeLess
+        std::vector<Node> queue;
+        util::flat_hash_map<glm::ivec3, bool, PositionHash> blocked;
+        /// @brief Parents positions of reached nodes
+        util::flat_hash_map<glm::ivec3, glm::ivec3, PositionHash> parents;
+        glm::ivec3 nearest {};
+        float minHScore = 0.0f;
         bool finished = true;
+
+        /// @brief Clear state keeping allocated memory
+        void reset() {
+            queue.clear();
+            blocked.clear();
+            parents.clear();
+            nearest = {};
+            minHScore = 0.0f;
+            finished = true;
+        }
     };
 
     struct Agent {
         bool enabled = false;
         bool mayBeIncomplete = true;
+        /// @brief Plan across cached chunk portals first, then refine
+        /// the route inside of chunks
+        bool hierarchical = false;
         int height = 2;
         int jumpHeight = 1;
         int maxVisitedBlocks = 1e3;
@@ -64,14 +99,59 @@ namespace voxels {
         std::set<std::pair<int, int>> avoidTags;
     };
 
+    /// @brief Agent properties the walkable surface depends on
+    struct NavProfile {
+        int height;
+        int jumpHeight;
+        std::set<std::pair<int, int>> avoidTags;
+
+        bool operator<(const NavProfile& other) const {
+            if (height != other.height) {
+                return height < other.height;
+            }
+            if (jumpHeight != other.jumpHeight) {
+                return jumpHeight < other.jumpHeight;
+            }
+            return avoidTags < other.avoidTags;
+        }
+    };
+
+    /// @brief Chunk entrance on the border shared with a neighbour chunk
+    struct Portal {
+        /// @brief Position inside of the chunk
+        glm::ivec3 pos;
+        /// @brief Position inside of the neighbour chunk
+        glm::ivec3 exit;
+        /// @brief Cost of step from pos to exit, negative if impossible
+        float exitCost;
+    };
+
+    /// @brief Cached walkable surface abstraction of a chunk
+    struct ChunkNav {
+        const Chunk* chunk = nullptr;
+        /// @brief Revisions of the chunk and its neighbours (-X, +X, -Z, +Z)
+        /// the portals are built from
+        uint64_t revisions[5] {};
+        std::vector<Portal> portals;
+        /// @brief Costs of routes between portals inside of the chunk.
+        /// Row is computed on first use, negative cost if unreachable
+        std::vector<std::vector<float>> costs;
+    };
+
     class Pathfinding {
     public:
         Pathfinding(const Level& level);
+        Pathfinding(
+            const GlobalChunks& chunks, const ContentUnitIndices<Block>& blockDefs
+        );
 
         int createAgent();
 
         bool removeAgent(int id);
 
+        /// @brief Perform step of all unfinished agents searches.
+        /// Searches run in parallel, so chunks must not be modified
+        /// until it returns
         void performAllAsync(int stepsPerAgent);
 
         Route perform(Agent& agent, int maxVisited = -1);
@@ -80,11 +160,70 @@ namespace voxels {
 
         const std::unordered_map<int, Agent>& getAgents() const;
     private:
-        const Level& level;
+        using NodesMap = std::unordered_map<glm::ivec3, Node>;
+
         const GlobalChunks& chunks;
         const ContentUnitIndices<Block>& blockDefs;
         std::unordered_map<int, Agent> agents;
         int nextAgent = 1;
+        std::map<NavProfile, std::unordered_map<glm::ivec2, ChunkNav>> navCache;
+        /// @brief Guards navCache used by agents performed in parallel
+        std::mutex navMutex;
+
+        Route performAgent(Agent& agent, int maxVisited);
+
+        /// @brief Drop abstractions of unloaded chunks if cache is too big.
+        /// Must not be called while agents are performed
+        void pruneNavCache();
+
+        /// @brief Try to move from the position to a neighbour column
+        /// @param direction index of neighbour offset (4+ are diagonal)
+        /// @param dst destination position
+        /// @param cost the step cost
+        /// @return false if the step is impossible
+        bool step(
+            const Agent& agent,
+            const glm::ivec3& src,
+            int direction,
+            glm::ivec3& dst,
+            float& cost
+        );
+
+        /// @brief Search routes from the start position without leaving
+        /// the chunk
+        /// @param target position to stop at, nullptr to visit whole area
+        /// reachable from the start
+        /// @param height vertical target reach distance
+        /// @param nodes visited positions with their parents and costs
+        /// @param visited visited positions counter
+        /// @return target node or nullptr if not reached
+        const Node* searchInChunk(
+            const Agent& agent,
+            const glm::ivec3& start,
+            const glm::ivec2& chunkPos,
+            const glm::ivec3* target,
+            int height,
+            NodesMap& nodes,
+            int& visited
+        );
+
+        /// @return up-to-date cached chunk abstraction or nullptr if chunk
+        /// is not loaded
+        ChunkNav* getChunkNav(const Agent& agent, const glm::ivec2& chunkPos);
+
+        void buildChunkNav(
+            const Agent& agent, const glm::ivec2& chunkPos, ChunkNav& nav
+        );
+
+        /// @return costs of routes from the portal to other chunk portals
+        const std::vector<float>& getPortalCosts(
+            const Agent& agent,
+            const glm::ivec2& chunkPos,
+            ChunkNav& nav,
+            size_t index
+        );
+
+        Route performHierarchical(Agent& agent);
 
         int getSurfaceAt(
             const Agent& agent, const glm::ivec3& pos, int maxDelta, float& cost
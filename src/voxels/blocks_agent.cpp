@@ -2,6 +2,7 @@
 
 #include "maths/rays.hpp"
 
+#include <algorithm>
 #include <limits>
 
 using namespace blocks_agent;
@@ -35,25 +36,29 @@ static void on_chunk_register_event(
 
     uint8_t flagsCache[1024] {};
 
-    for (int i = totalBegin; i < totalEnd; i++) {
-        blockid_t id = voxels[i].id;
-        uint8_t bits = id < sizeof(flagsCache) ? flagsCache[id] : 0;
-        if ((bits & 0x80) == 0) {
-            const auto& def = indices.blocks.require(id);
-            bits = get_events_bits(def);
-            flagsCache[id] = bits | 0x80;
-        }
-        bits &= 0x7F;
-        if (bits == 0) {
-            continue;
+    chunk.forEachSection([&](int s) {
+        int begin = std::max(totalBegin, s * CHUNK_SECTION_VOL);
+        int end = std::min(totalEnd, (s + 1) * CHUNK_SECTION_VOL);
+        for (int i = begin; i < end; i++) {
+            blockid_t id = voxels[i].id;
+            uint8_t bits = id < sizeof(flagsCache) ? flagsCache[id] : 0;
+            if ((bits & 0x80) == 0) {
+                const auto& def = indices.blocks.require(id);
+                bits = get_events_bits(def);
+                flagsCache[id] = bits | 0x80;
+            }
+            bits &= 0x7F;
+            if (bits == 0) {
+                continue;
+            }
+            int x = i % CHUNK_W + chunk.x * CHUNK_W;
+            int z = (i / CHUNK_W) % CHUNK_D + chunk.z * CHUNK_D;
+            int y = (i / CHUNK_W / CHUNK_D);
+            block_register_events.push_back(BlockRegisterEvent {
+                static_cast<uint8_t>(bits | (present ? 1 : 0)), id, {x, y, z}
+            });
         }
-        int x = i % CHUNK_W + chunk.x * CHUNK_W;
-        int z = (i / CHUNK_W) % CHUNK_D + chunk.z * CHUNK_D;
-        int y = (i / CHUNK_W / CHUNK_D);
-        block_register_events.push_back(BlockRegisterEvent {
-            static_cast<uint8_t>(bits | (present ? 1 : 0)), id, {x, y, z}
-        });
-    }
+    });
 }
 
 void blocks_agent::on_chunk_present(
@@ -70,24 +75,27 @@ void blocks_agent::on_chunk_remove(
 
 template <class Storage>
 static void mark_neighboirs_modified(
-    Storage& chunks, int32_t cx, int32_t cz, int32_t lx, int32_t lz
+    Storage& chunks, int32_t cx, int32_t cz, int32_t lx, int32_t y, int32_t lz
 ) {
     Chunk* chunk;
     if (lx == 0 && (chunk = get_chunk(chunks, cx - 1, cz))) {
-        chunk->flags.modified = true;
+        chunk->setModified(y);
     }
     if (lz == 0 && (chunk = get_chunk(chunks, cx, cz - 1))) {
-        chunk->flags.modified = true;
+        chunk->setModified(y);
     }
     if (lx == CHUNK_W - 1 && (chunk = get_chunk(chunks, cx + 1, cz))) {
-        chunk->flags.modified = true;
+        chunk->setModified(y);
     }
     if (lz == CHUNK_D - 1 && (chunk = get_chunk(chunks, cx, cz + 1))) {
-        chunk->flags.modified = true;
+        chunk->setModified(y);
     }
 }
 
 static void refresh_chunk_heights(Chunk& chunk, bool isAir, int y) {
+    if (!isAir) {
+        chunk.sectionsMask |= 1 << (y / CHUNK_SECTION_H);
+    }
     if (y < chunk.bottom)
         chunk.bottom = y;
     else if (y + 1 > chunk.top)
@@ -145,13 +153,13 @@ static void initialize_block(
     const auto& def = indices.blocks.require(id);
     vox.id = id;
     vox.state = state;
-    chunk.setModifiedAndUnsaved();
+    chunk.setModifiedAndUnsaved(y);
     if (!state.segment && def.rt.extended) {
         restore_segments(chunks, def, state, x, y, z);
     }
 
     refresh_chunk_heights(chunk, id == BLOCK_AIR, y);
-    mark_neighboirs_modified(chunks, cx, cz, lx, lz);
+    mark_neighboirs_modified(chunks, cx, cz, lx, y, lz);
 
     uint8_t bits = get_events_bits(def);
     if (bits == 0) {
@@ -218,6 +226,77 @@ bool blocks_agent::set(
     return set_block(chunks, x, y, z, id, state);
 }
 
+template <class Storage>
+static std::vector<glm::ivec2> set_voxels_impl(
+    Storage& chunks,
+    const glm::ivec3& origin,
+    const glm::ivec3& size,
+    const voxel* voxels
+) {
+    std::vector<glm::ivec2> touched;
+    int y1 = std::max(origin.y, 0);
+    int y2 = std::min(origin.y + size.y, CHUNK_H);
+    if (y1 >= y2 || size.x <= 0 || size.z <= 0) {
+        return touched;
+    }
+    int cx1 = floordiv<CHUNK_W>(origin.x);
+    int cz1 = floordiv<CHUNK_D>(origin.z);
+    int cx2 = floordiv<CHUNK_W>(origin.x + size.x - 1);
+    int cz2 = floordiv<CHUNK_D>(origin.z + size.z - 1);
+    for (int cz = cz1; cz <= cz2; cz++) {
+        for (int cx = cx1; cx <= cx2; cx++) {
+            Chunk* chunk = get_chunk(chunks, cx, cz);
+            if (chunk == nullptr) {
+                continue;
+            }
+            int ox = cx * CHUNK_W - origin.x;
+            int oz = cz * CHUNK_D - origin.z;
+            int lx1 = std::max(-ox, 0);
+            int lz1 = std::max(-oz, 0);
+            int lx2 = std::min(size.x - ox, CHUNK_W);
+            int lz2 = std::min(size.z - oz, CHUNK_D);
+            bool changed = false;
+            for (int y = y1; y < y2; y++) {
+                for (int lz = lz1; lz < lz2; lz++) {
+                    for (int lx = lx1; lx < lx2; lx++) {
+                        const voxel& src = voxels[vox_index(
+                            lx + ox, y - origin.y, lz + oz, size.x, size.z
+                        )];
+                        voxel& vox = chunk->voxels[vox_index(lx, y, lz)];
+                        if (src.id == BLOCK_AIR ||
+                            (vox.id == src.id &&
+                             blockstate2int(vox.state) ==
+                                 blockstate2int(src.state))) {
+                            continue;
+                        }
+                        int x = cx * CHUNK_W + lx;
+                        int z = cz * CHUNK_D + lz;
+                        finalize_block(chunks, *chunk, vox, x, y, z, lx, lz);
+                        initialize_block(
+                            chunks, *chunk, vox, src.id, src.state,
+                            x, y, z, lx, lz, cx, cz
+                        );
+                        changed = true;
+                    }
+                }
+            }
+            if (changed) {
+                touched.emplace_back(cx, cz);
+            }
+        }
+    }
+    return touched;
+}
+
+std::vector<glm::ivec2> blocks_agent::set_voxels(
+    GlobalChunks& chunks,
+    const glm::ivec3& origin,
+    const glm::ivec3& size,
+    const voxel* voxels
+) {
+    return set_voxels_impl(chunks, origin, size, voxels);
+}
+
 template <class Storage>
 static inline voxel* raycast_blocks(
     const Storage& chunks,
@@ -159,6 +159,20 @@ bool set(
     blockstate state
 );
 
+/// @brief Set voxels of the box looking every chunk up once.
+/// Air voxels of the box and voxels equal to the current ones are skipped.
+/// @param chunks chunks storage
+/// @param origin box origin position
+/// @param size box size
+/// @param voxels box voxels indexed with vox_index(x, y, z, size.x, size.z)
+/// @return positions of chunks having voxels changed
+std::vector<glm::ivec2> set_voxels(
+    GlobalChunks& chunks,
+    const glm::ivec3& origin,
+    const glm::ivec3& size,
+    const voxel* voxels
+);
+
 /// @brief Erase extended block segments
 /// @tparam Storage chunks storage class
 /// @param chunks chunks storage
@@ -350,7 +364,7 @@ inline void set_rotation_extended(
                     int cz = floordiv<CHUNK_D>(pos.z);
                     auto chunk = get_chunk(chunks, cx, cz);
                     assert(chunk != nullptr);
-                    chunk->setModifiedAndUnsaved();
+                    chunk->setModifiedAndUnsaved(pos.y);
                     segmentBlocks.emplace_back(pos);
                 }
             }
@@ -406,7 +420,7 @@ inline void set_rotation(
         int cz = floordiv<CHUNK_D>(z);
         auto chunk = get_chunk(chunks, cx, cz);
         assert(chunk != nullptr);
-        chunk->setModifiedAndUnsaved();
+        chunk->setModifiedAndUnsaved(y);
     }
 }
 
@@ -2,6 +2,7 @@
 
 #include "coders/rle.hpp"
 #include "coders/gzip.hpp"
+#include "coders/lz4.hpp"
 
 #include "world/files/WorldFiles.hpp"
 #include "content/Content.hpp"
@@ -9,6 +10,10 @@
 inline constexpr int HAS_VOXELS = 0x1;
 inline constexpr int HAS_METADATA = 0x2;
 
+/// @brief Voxels data compression (stored in the second byte)
+inline constexpr int CODEC_GZIP = 0x0;
+inline constexpr int CODEC_LZ4 = 0x1;
+
 std::vector<ubyte> compressed_chunks::encode(
     const ubyte* data,
     const BlocksMetadata& metadata,
@@ -17,16 +22,18 @@ std::vector<ubyte> compressed_chunks::encode(
     size_t rleCompressedSize =
         extrle::encode16(data, CHUNK_DATA_LEN, rleBuffer.data());
 
-    const auto gzipCompressedData = gzip::compress(
-        rleBuffer.data(), rleCompressedSize
+    util::Buffer<ubyte> lz4Buffer(lz4::compress_bound(rleCompressedSize));
+    size_t lz4CompressedSize = lz4::encode(
+        rleBuffer.data(), rleCompressedSize, lz4Buffer.data()
     );
     auto metadataBytes = metadata.serialize();
 
-    ByteBuilder builder(2 + 8 + gzipCompressedData.size() + metadataBytes.size());
+    ByteBuilder builder(2 + 12 + lz4CompressedSize + metadataBytes.size());
     builder.put(HAS_VOXELS | HAS_METADATA); // flags
-    builder.put(0); // reserved
-    builder.putInt32(gzipCompressedData.size());
-    builder.put(gzipCompressedData.data(), gzipCompressedData.size());
+    builder.put(CODEC_LZ4);
+    builder.putInt32(lz4CompressedSize);
+    builder.putInt32(rleCompressedSize);
+    builder.put(lz4Buffer.data(), lz4CompressedSize);
     builder.putInt32(metadataBytes.size());
     builder.put(metadataBytes.data(), metadataBytes.size());
     return builder.build();
@@ -40,13 +47,30 @@ std::vector<ubyte> compressed_chunks::encode(const Chunk& chunk) {
     return encode(data.get(), chunk.blocksMetadata, rleBuffer);
 }
 
-static void read_voxel_data(ByteReader& reader, util::Buffer<ubyte>& dst) {
-    size_t gzipCompressedSize = reader.getInt32();
-        
-    auto rleData = gzip::decompress(reader.pointer(), gzipCompressedSize);
-    reader.skip(gzipCompressedSize);
+static void read_voxel_data(
+    ByteReader& reader, ubyte codec, util::Buffer<ubyte>& dst
+) {
+    size_t compressedSize = reader.getInt32();
+    if (codec == CODEC_GZIP) {
+        auto rleData = gzip::decompress(reader.pointer(), compressedSize);
+        reader.skip(compressedSize);
+
+        extrle::decode16(rleData.data(), rleData.size(), dst.data());
+        return;
+    }
+    if (codec != CODEC_LZ4) {
+        throw std::runtime_error(
+            "unknown chunk data compression " + std::to_string(codec)
+        );
+    }
+    size_t rleSize = reader.getInt32();
+    util::Buffer<ubyte> rleData(rleSize);
+    size_t decoded = lz4::decode(
+        reader.pointer(), compressedSize, rleData.data(), rleSize
+    );
+    reader.skip(compressedSize);
 
-    extrle::decode16(rleData.data(), rleData.size(), dst.data());
+    extrle::decode16(rleData.data(), decoded, dst.data());
 }
 
 void compressed_chunks::decode(
@@ -55,12 +79,12 @@ void compressed_chunks::decode(
     ByteReader reader(src, size);
 
     ubyte flags = reader.get();
-    reader.skip(1); // reserved byte
+    ubyte codec = reader.get();
 
     if (flags & HAS_VOXELS) {
         /// world.get_chunk_data is only available in the main Lua state
         static util::Buffer<ubyte> voxelData (CHUNK_DATA_LEN);
-        read_voxel_data(reader, voxelData);
+        read_voxel_data(reader, codec, voxelData);
         // TODO: move somewhere in Chunk
         auto src = reinterpret_cast<const uint16_t*>(voxelData.data());
         for (size_t i = 0; i < CHUNK_VOL; i++) {
@@ -90,10 +114,10 @@ void compressed_chunks::save(
     ByteReader reader(bytes.data(), bytes.size());
 
     ubyte flags = reader.get();
-    reader.skip(1); // reserved byte
+    ubyte codec = reader.get();
     if (flags & HAS_VOXELS) {
         util::Buffer<ubyte> voxelData (CHUNK_DATA_LEN);
-        read_voxel_data(reader, voxelData);
+        read_voxel_data(reader, codec, voxelData);
         regions.put(
             x, z, REGION_LAYER_VOXELS, voxelData.release(), CHUNK_DATA_LEN
         );
@@ -0,0 +1,98 @@
+#include "RegionsIO.hpp"
+
+#include "WorldRegions.hpp"
+#include "debug/Logger.hpp"
+
+static debug::Logger logger("regions-io");
+
+RegionsIO::RegionsIO(size_t maxQueuedBytes)
+    : maxQueuedBytes(maxQueuedBytes),
+      thread(&RegionsIO::threadLoop, this) {
+}
+
+RegionsIO::~RegionsIO() {
+    flush();
+    {
+        std::lock_guard lock(mutex);
+        working = false;
+    }
+    jobsCv.notify_all();
+    thread.join();
+}
+
+void RegionsIO::threadLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock lock(mutex);
+            jobsCv.wait(lock, [this] {
+                return !reads.empty() || !writes.empty() || !working;
+            });
+            if (reads.empty() && writes.empty()) {
+                break;
+            }
+            auto& queue = reads.empty() ? writes : reads;
+            job = std::move(queue.front());
+            queue.pop_front();
+            busy = true;
+        }
+        try {
+            if (job.snapshot) {
+                job.layer->writeRegion(job.x, job.z, job.snapshot.get());
+            } else {
+                job.layer->readRegion(job.x, job.z);
+            }
+        } catch (const std::exception& err) {
+            logger.error() << "could not " << (job.snapshot ? "write" : "read")
+                           << " region " << job.x << "_" << job.z << " of "
+                           << job.layer->folder.string() << ": "
+                           << err.what();
+            // regions are not removed from the layer, so the region will
+            // be written again on the next save
+            if (job.snapshot) {
+                if (auto region = job.layer->getRegion(job.x, job.z)) {
+                    region->setUnsaved(true);
+                }
+            }
+        }
+        {
+            std::lock_guard lock(mutex);
+            queuedBytes -= job.bytes;
+            busy = false;
+        }
+        doneCv.notify_all();
+    }
+}
+
+void RegionsIO::enqueueWrite(
+    RegionsLayer& layer,
+    int x,
+    int z,
+    std::unique_ptr<WorldRegion> snapshot,
+    size_t bytes
+) {
+    std::unique_lock lock(mutex);
+    // a single oversized snapshot is allowed when the queue is empty
+    doneCv.wait(lock, [this, bytes] {
+        return queuedBytes == 0 || queuedBytes + bytes <= maxQueuedBytes;
+    });
+    queuedBytes += bytes;
+    writes.push_back(Job {&layer, x, z, std::move(snapshot), bytes});
+    lock.unlock();
+    jobsCv.notify_one();
+}
+
+void RegionsIO::enqueueRead(RegionsLayer& layer, int x, int z) {
+    {
+        std::lock_guard lock(mutex);
+        reads.push_back(Job {&layer, x, z, nullptr, 0});
+    }
+    jobsCv.notify_one();
+}
+
+void RegionsIO::flush() {
+    std::unique_lock lock(mutex);
+    doneCv.wait(lock, [this] {
+        return reads.empty() && writes.empty() && !busy;
+    });
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "typedefs.hpp"
+
+struct RegionsLayer;
+class WorldRegion;
+
+/// @brief Background thread reading regions ahead and writing saved
+/// regions to files.
+/// Write jobs own snapshots of the regions, so the world may be modified
+/// while writing. Regions which could not be written are marked unsaved
+/// again to be written on the next save. Total size of queued snapshots is limited by
+/// maxQueuedBytes: enqueueWrite blocks until there is enough space.
+class RegionsIO {
+    struct Job {
+        RegionsLayer* layer;
+        int x, z;
+        /// @brief Region snapshot to write or nullptr for read-ahead job
+        std::unique_ptr<WorldRegion> snapshot;
+        size_t bytes;
+    };
+    std::deque<Job> reads;
+    std::deque<Job> writes;
+    std::mutex mutex;
+    /// @brief Notified when a job is enqueued or on termination
+    std::condition_variable jobsCv;
+    /// @brief Notified when a job is finished
+    std::condition_variable doneCv;
+    size_t maxQueuedBytes;
+    size_t queuedBytes = 0;
+    bool busy = false;
+    bool working = true;
+    std::thread thread;
+
+    void threadLoop();
+public:
+    RegionsIO(size_t maxQueuedBytes);
+    /// @brief Finishes all enqueued writes
+    ~RegionsIO();
+
+    /// @brief Enqueue region snapshot writing.
+    /// Writes of the same region are performed in order
+    void enqueueWrite(
+        RegionsLayer& layer,
+        int x,
+        int z,
+        std::unique_ptr<WorldRegion> snapshot,
+        size_t bytes
+    );
+
+    /// @brief Enqueue region file reading to in-memory region.
+    /// Performed before pending writes
+    void enqueueRead(RegionsLayer& layer, int x, int z);
+
+    /// @brief Wait until all enqueued jobs are finished
+    void flush();
+};
@@ -1,6 +1,9 @@
+#include <algorithm>
 #include <cstring>
+#include <filesystem>
 
 #include "WorldRegions.hpp"
+#include "RegionsIO.hpp"
 #include "debug/Logger.hpp"
 #include "util/data_io.hpp"
 
@@ -12,10 +15,35 @@ static io::path get_region_filename(int x, int z) {
     return std::to_string(x) + "_" + std::to_string(z) + ".bin";
 }
 
+/// @brief Convert chunk data compressed with the region file method
+/// to the layer method
+static std::unique_ptr<ubyte[]> transcode(
+    std::unique_ptr<ubyte[]> data,
+    uint32_t& size,
+    uint32_t srcSize,
+    compression::Method from,
+    compression::Method to
+) {
+    if (data == nullptr || from == to) {
+        return data;
+    }
+    if (from != compression::Method::NONE) {
+        data = compression::decompress(data.get(), size, srcSize, from);
+        size = srcSize;
+    }
+    if (to != compression::Method::NONE) {
+        size_t length;
+        data = compression::compress(data.get(), srcSize, length, to);
+        size = length;
+    }
+    return data;
+}
+
 /// @brief Read missing chunks data (null pointers) from region file
 static void fetch_chunks(WorldRegion* region, int x, int z, regfile* file) {
     auto* chunks = region->getChunks();
     auto sizes = region->getSizes();
+    auto methods = region->getCompressions();
 
     for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
         int chunk_x = (i % REGION_SIZE) + x * REGION_SIZE;
@@ -24,17 +52,34 @@ static void fetch_chunks(WorldRegion* region, int x, int z, regfile* file) {
             chunks[i] = RegionsLayer::readChunkData(
                 chunk_x, chunk_z, sizes[i][0], sizes[i][1], file
             );
+            methods[i] = file->compression;
         }
     }
 }
 
-regfile::regfile(io::path filename) : file(filename), filename(filename) {
-    if (file.length() < REGION_HEADER_SIZE)
+regfile::regfile(io::path filename, bool memoryMapped)
+    : filename(filename) {
+    if (memoryMapped) {
+        try {
+            mapped = std::make_unique<io::mmfile>(filename);
+        } catch (const std::runtime_error& err) {
+            logger.warning() << err.what() << " - fallback to stream";
+        }
+    }
+    if (mapped == nullptr) {
+        file = std::make_unique<io::rafile>(filename);
+    }
+    size_t length = mapped ? mapped->length() : file->length();
+    if (length < REGION_HEADER_SIZE + REGION_CHUNKS_COUNT * 4)
         throw std::runtime_error(
             "incomplete region file header in " + filename.string()
         );
     char header[REGION_HEADER_SIZE];
-    file.read(header, REGION_HEADER_SIZE);
+    if (mapped) {
+        std::memcpy(header, mapped->data(), REGION_HEADER_SIZE);
+    } else {
+        file->read(header, REGION_HEADER_SIZE);
+    }
 
     // avoid of use strcmp_s
     if (std::string(header, std::strlen(REGION_FORMAT_MAGIC)) !=
@@ -50,42 +95,96 @@ regfile::regfile(io::path filename) : file(filename), filename(filename) {
             " is not supported in " + filename.string()
         );
     }
+    if (static_cast<ubyte>(header[9]) >
+        static_cast<ubyte>(compression::Method::LZ4)) {
+        throw illegal_region_format(
+            "unknown compression method " + std::to_string(header[9]) +
+            " in " + filename.string()
+        );
+    }
+    compression = static_cast<compression::Method>(header[9]);
 }
 
-std::unique_ptr<ubyte[]> regfile::read(
-    int index, uint32_t& size, uint32_t& srcSize
-) {
-    size_t file_size = file.length();
+uint32_t regfile::findChunk(int index, uint32_t& size, uint32_t& srcSize) {
+    size_t file_size = mapped ? mapped->length() : file->length();
     size_t table_offset = file_size - REGION_CHUNKS_COUNT * 4;
 
     uint32_t buff32;
-    file.seekg(table_offset + index * 4);
-    file.read(reinterpret_cast<char*>(&buff32), 4);
+    if (mapped) {
+        std::memcpy(&buff32, mapped->data() + table_offset + index * 4, 4);
+    } else {
+        file->seekg(table_offset + index * 4);
+        file->read(reinterpret_cast<char*>(&buff32), 4);
+    }
     uint32_t offset = dataio::le2h(buff32);
     if (offset == 0) {
-        return nullptr;
+        return 0;
+    }
+    if (offset + 8 > table_offset) {
+        logger.error() << "corrupted region " << filename.string()
+                       << " chunk offset detected at "
+                       << (table_offset + index * 4);
+        return 0;
     }
 
-    file.seekg(offset);
-    file.read(reinterpret_cast<char*>(&buff32), 4);
-    size = dataio::le2h(buff32);
-    file.read(reinterpret_cast<char*>(&buff32), 4);
-    srcSize = dataio::le2h(buff32);
+    if (mapped) {
+        std::memcpy(&buff32, mapped->data() + offset, 4);
+        size = dataio::le2h(buff32);
+        std::memcpy(&buff32, mapped->data() + offset + 4, 4);
+        srcSize = dataio::le2h(buff32);
+    } else {
+        file->seekg(offset);
+        file->read(reinterpret_cast<char*>(&buff32), 4);
+        size = dataio::le2h(buff32);
+        file->read(reinterpret_cast<char*>(&buff32), 4);
+        srcSize = dataio::le2h(buff32);
+    }
 
-    if (offset + size > file_size) {
+    if (offset + 8 + static_cast<size_t>(size) > table_offset) {
         logger.error() << "corrupted region " << filename.string()
                        << " chunk offset detected at "
                        << (table_offset + index * 4);
+        return 0;
+    }
+    return offset + 8;
+}
+
+std::unique_ptr<ubyte[]> regfile::read(
+    int index, uint32_t& size, uint32_t& srcSize
+) {
+    uint32_t offset = findChunk(index, size, srcSize);
+    if (offset == 0) {
         return nullptr;
     }
     auto data = std::make_unique<ubyte[]>(size);
-    file.read(reinterpret_cast<char*>(data.get()), size);
+    if (mapped) {
+        std::memcpy(data.get(), mapped->data() + offset, size);
+    } else {
+        file->read(reinterpret_cast<char*>(data.get()), size);
+    }
     return data;
 }
 
+const ubyte* regfile::view(
+    int index,
+    uint32_t& size,
+    uint32_t& srcSize,
+    std::unique_ptr<ubyte[]>& storage
+) {
+    if (mapped == nullptr) {
+        storage = read(index, size, srcSize);
+        return storage.get();
+    }
+    uint32_t offset = findChunk(index, size, srcSize);
+    if (offset == 0) {
+        return nullptr;
+    }
+    return mapped->data() + offset;
+}
+
 void RegionsLayer::closeRegFile(glm::ivec2 coord) {
     openRegFiles.erase(coord);
-    regFilesCv.notify_one();
+    regFilesCv.notify_all();
 }
 
 regfile_ptr RegionsLayer::useRegFile(glm::ivec2 coord) {
@@ -135,11 +234,11 @@ regfile_ptr RegionsLayer::createRegFile(glm::ivec2 coord) {
             // notified when any regfile gets out of use or closed
             regFilesCv.wait(lock);
         }
-        openRegFiles[coord] = std::make_unique<regfile>(file);
+        openRegFiles[coord] = std::make_unique<regfile>(file, memoryMapped);
         return useRegFile(coord);
     } else {
         std::lock_guard lock(regFilesMutex);
-        openRegFiles[coord] = std::make_unique<regfile>(file);
+        openRegFiles[coord] = std::make_unique<regfile>(file, memoryMapped);
         return useRegFile(coord);
     }
 }
@@ -158,29 +257,140 @@ io::path RegionsLayer::getRegionFilePath(int x, int z) const {
 }
 
 WorldRegion* RegionsLayer::getOrCreateRegion(int x, int z) {
-    if (auto region = getRegion(x, z)) {
-        return region;
+    std::lock_guard lock(mapMutex);
+    auto& region = regions[{x, z}];
+    if (region == nullptr) {
+        region = std::make_unique<WorldRegion>();
+    }
+    return region.get();
+}
+
+void RegionsLayer::readRegion(int x, int z) {
+    auto filename = getRegionFilePath(x, z);
+    if (getRegion(x, z) || !io::exists(filename)) {
+        std::lock_guard lock(mapMutex);
+        prefetchPending.erase({x, z});
+        return;
+    }
+    // separate file handle to not interfere with chunks loading
+    regfile file(filename, memoryMapped);
+    auto region = std::make_unique<WorldRegion>();
+    fetch_chunks(region.get(), x, z, &file);
+
+    std::lock_guard lock(mapMutex);
+    prefetchPending.erase({x, z});
+    if (prefetched.size() >= MAX_PREFETCHED_REGIONS) {
+        prefetched.erase(prefetched.begin());
     }
+    prefetched.emplace_back(glm::ivec2(x, z), std::move(region));
+}
+
+void RegionsLayer::prefetch(int x, int z) {
+    if (regionsIO == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard lock(mapMutex);
+        if (regions.find({x, z}) != regions.end()) {
+            return;
+        }
+        for (auto it = prefetched.begin(); it != prefetched.end(); ++it) {
+            if (it->first == glm::ivec2(x, z)) {
+                // mark as recently used
+                std::rotate(it, it + 1, prefetched.end());
+                return;
+            }
+        }
+        if (!prefetchPending.insert({x, z}).second) {
+            return;
+        }
+    }
+    regionsIO->enqueueRead(*this, x, z);
+}
+
+bool RegionsLayer::takePrefetched(
+    int x,
+    int z,
+    std::unique_ptr<ubyte[]>& data,
+    uint32_t& size,
+    uint32_t& srcSize,
+    compression::Method& method
+) {
+    int regionX, regionZ, localX, localZ;
+    calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
+
+    std::lock_guard lock(mapMutex);
+    auto found = std::find_if(
+        prefetched.begin(),
+        prefetched.end(),
+        [regionX, regionZ](const auto& entry) {
+            return entry.first == glm::ivec2(regionX, regionZ);
+        }
+    );
+    if (found == prefetched.end()) {
+        return false;
+    }
+    auto& region = *found->second;
+    size_t index = localZ * REGION_SIZE + localX;
+    data = std::move(region.getChunks()[index]);
+    size = region.getSizes()[index][0];
+    srcSize = region.getSizes()[index][1];
+    method = region.getCompressions()[index];
+    if (region.isEmpty()) {
+        prefetched.erase(found);
+    }
+    return true;
+}
+
+void RegionsLayer::discardPrefetched(int x, int z) {
     std::lock_guard lock(mapMutex);
-    auto region_ptr = std::make_unique<WorldRegion>();
-    auto region = region_ptr.get();
-    regions[{x, z}] = std::move(region_ptr);
-    return region;
+    prefetched.erase(
+        std::remove_if(
+            prefetched.begin(),
+            prefetched.end(),
+            [x, z](const auto& entry) {
+                return entry.first == glm::ivec2(x, z);
+            }
+        ),
+        prefetched.end()
+    );
 }
 
-ubyte* RegionsLayer::getData(int x, int z, uint32_t& size, uint32_t& srcSize) {
+ubyte* RegionsLayer::getData(
+    int x,
+    int z,
+    uint32_t& size,
+    uint32_t& srcSize,
+    compression::Method& method
+) {
     int regionX, regionZ, localX, localZ;
     calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
 
     WorldRegion* region = getOrCreateRegion(regionX, regionZ);
     ubyte* data = region->getChunkData(localX, localZ);
-    if (data == nullptr) {
+    std::unique_ptr<ubyte[]> dataptr;
+    if (data == nullptr &&
+        takePrefetched(x, z, dataptr, size, srcSize, method)) {
+        if (dataptr) {
+            data = dataptr.get();
+            region->put(
+                localX, localZ, std::move(dataptr), size, srcSize, method
+            );
+        }
+    } else if (data == nullptr) {
         auto regfile = getRegFile({regionX, regionZ});
         if (regfile != nullptr) {
-            auto dataptr = readChunkData(x, z, size, srcSize, regfile.get());
+            dataptr = readChunkData(x, z, size, srcSize, regfile.get());
             if (dataptr) {
                 data = dataptr.get();
-                region->put(localX, localZ, std::move(dataptr), size, srcSize);
+                region->put(
+                    localX,
+                    localZ,
+                    std::move(dataptr),
+                    size,
+                    srcSize,
+                    regfile.get()->compression
+                );
             }
         }
     }
@@ -188,6 +398,7 @@ ubyte* RegionsLayer::getData(int x, int z, uint32_t& size, uint32_t& srcSize) {
         auto sizevec = region->getChunkDataSize(localX, localZ);
         size = sizevec[0];
         srcSize = sizevec[1];
+        method = region->getChunkCompression(localX, localZ);
         return data;
     }
     return nullptr;
@@ -195,55 +406,81 @@ ubyte* RegionsLayer::getData(int x, int z, uint32_t& size, uint32_t& srcSize) {
 
 void RegionsLayer::writeRegion(int x, int z, WorldRegion* entry) {
     io::path filename = folder / get_region_filename(x, z);
+    io::path tmpfilename = folder / (get_region_filename(x, z).string() + ".tmp");
 
-    glm::ivec2 regcoord(x, z);
-    if (auto regfile = getRegFile(regcoord, false)) {
-        fetch_chunks(entry, x, z, regfile.get());
-
-        std::lock_guard lock(regFilesMutex);
-        regfile.reset();
-        closeRegFile(regcoord);
+    if (io::exists(filename)) {
+        // separate file handle to not interfere with chunks loading
+        regfile oldfile(filename, memoryMapped);
+        fetch_chunks(entry, x, z, &oldfile);
     }
 
     char header[REGION_HEADER_SIZE] = REGION_FORMAT_MAGIC;
     header[8] = REGION_FORMAT_VERSION;
-    header[9] = static_cast<ubyte>(compression);  // FIXME
-    std::ofstream file(io::resolve(filename), std::ios::out | std::ios::binary);
-    file.write(header, REGION_HEADER_SIZE);
+    header[9] = static_cast<ubyte>(compression);
+    {
+        std::ofstream file(
+            io::resolve(tmpfilename), std::ios::out | std::ios::binary
+        );
+        file.write(header, REGION_HEADER_SIZE);
 
-    size_t offset = REGION_HEADER_SIZE;
-    uint32_t intbuf;
-    uint offsets[REGION_CHUNKS_COUNT] {};
+        size_t offset = REGION_HEADER_SIZE;
+        uint32_t intbuf;
+        uint offsets[REGION_CHUNKS_COUNT] {};
 
-    auto region = entry->getChunks();
-    auto sizes = entry->getSizes();
+        auto region = entry->getChunks();
+        auto sizes = entry->getSizes();
+        auto methods = entry->getCompressions();
 
-    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
-        ubyte* chunk = region[i].get();
-        if (chunk == nullptr) {
-            continue;
-        }
-        offsets[i] = offset;
+        for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+            if (region[i] == nullptr) {
+                continue;
+            }
+            // chunks read from a file written with other method
+            if (methods[i] != compression) {
+                region[i] = transcode(
+                    std::move(region[i]),
+                    sizes[i][0],
+                    sizes[i][1],
+                    methods[i],
+                    compression
+                );
+                methods[i] = compression;
+            }
+            ubyte* chunk = region[i].get();
+            offsets[i] = offset;
 
-        auto sizevec = sizes[i];
-        uint32_t compressedSize = sizevec[0];
-        uint32_t srcSize = sizevec[1];
+            auto sizevec = sizes[i];
+            uint32_t compressedSize = sizevec[0];
+            uint32_t srcSize = sizevec[1];
 
-        intbuf = dataio::h2le(compressedSize);
-        file.write(reinterpret_cast<const char*>(&intbuf), 4);
-        offset += 4;
+            intbuf = dataio::h2le(compressedSize);
+            file.write(reinterpret_cast<const char*>(&intbuf), 4);
+            offset += 4;
 
-        intbuf = dataio::h2le(srcSize);
-        file.write(reinterpret_cast<const char*>(&intbuf), 4);
-        offset += 4;
+            intbuf = dataio::h2le(srcSize);
+            file.write(reinterpret_cast<const char*>(&intbuf), 4);
+            offset += 4;
 
-        file.write(reinterpret_cast<const char*>(chunk), compressedSize);
-        offset += compressedSize;
+            file.write(reinterpret_cast<const char*>(chunk), compressedSize);
+            offset += compressedSize;
+        }
+        for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+            intbuf = dataio::h2le(offsets[i]);
+            file.write(reinterpret_cast<const char*>(&intbuf), 4);
+        }
     }
-    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
-        intbuf = dataio::h2le(offsets[i]);
-        file.write(reinterpret_cast<const char*>(&intbuf), 4);
+
+    // replace region file when it is not used for chunks loading
+    glm::ivec2 regcoord(x, z);
+    std::unique_lock lock(regFilesMutex);
+    regFilesCv.wait(lock, [this, regcoord] {
+        const auto& found = openRegFiles.find(regcoord);
+        return found == openRegFiles.end() || !found->second->inUse;
+    });
+    if (openRegFiles.find(regcoord) != openRegFiles.end()) {
+        closeRegFile(regcoord);
     }
+    std::filesystem::rename(io::resolve(tmpfilename), io::resolve(filename));
 }
 
 std::unique_ptr<ubyte[]> RegionsLayer::readChunkData(
@@ -254,3 +491,17 @@ std::unique_ptr<ubyte[]> RegionsLayer::readChunkData(
     int chunkIndex = localZ * REGION_SIZE + localX;
     return rfile->read(chunkIndex, size, srcSize);
 }
+
+const ubyte* RegionsLayer::viewChunkData(
+    int x,
+    int z,
+    uint32_t& size,
+    uint32_t& srcSize,
+    regfile* rfile,
+    std::unique_ptr<ubyte[]>& storage
+) {
+    int regionX, regionZ, localX, localZ;
+    calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
+    int chunkIndex = localZ * REGION_SIZE + localX;
+    return rfile->view(chunkIndex, size, srcSize, storage);
+}
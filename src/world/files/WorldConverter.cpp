@@ -127,6 +127,11 @@ WorldConverter::WorldConverter(
       content(content),
       mode(mode)
 {
+    // regions are read once and sequentially
+    auto& regions = wfile->getRegions();
+    for (int i = 0; i < REGION_LAYERS_COUNT; i++) {
+        regions.setMemoryMapped(static_cast<RegionLayerIndex>(i), true);
+    }
     switch (mode) {
         case ConvertMode::UPGRADE:
             createUpgradeTasks();
@@ -182,10 +187,19 @@ std::shared_ptr<Task> WorldConverter::startTask(
 void WorldConverter::upgradeRegion(
     const io::path& file, int x, int z, RegionLayerIndex layer
 ) const {
-    auto path = wfile->getRegions().getRegionFilePath(layer, x, z);
+    auto& regions = wfile->getRegions();
+    auto path = regions.getRegionFilePath(layer, x, z);
     auto bytes = io::read_bytes_buffer(path);
-    auto buffer = compatibility::convert_region_2to3(bytes, layer);
-    io::write_bytes(path, buffer.data(), buffer.size());
+    if (bytes.size() < REGION_HEADER_SIZE) {
+        throw std::runtime_error("incomplete region file " + path.string());
+    }
+    int version = bytes[8];
+    if (version < 3) {
+        auto buffer = compatibility::convert_region_2to3(bytes, layer);
+        io::write_bytes(path, buffer.data(), buffer.size());
+    }
+    // version 3 to 4: chunks data is converted to the layer compression
+    regions.recompressRegion(layer, x, z);
 }
 
 void WorldConverter::convertVoxels(const io::path& file, int x, int z) const {
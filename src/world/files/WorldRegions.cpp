@@ -4,6 +4,7 @@
 #include <utility>
 #include <vector>
 
+#include "RegionsIO.hpp"
 #include "debug/Logger.hpp"
 #include "coders/json.hpp"
 #include "coders/byte_utils.hpp"
@@ -21,7 +22,8 @@ WorldRegion::WorldRegion()
     : chunksData(
           std::make_unique<std::unique_ptr<ubyte[]>[]>(REGION_CHUNKS_COUNT)
       ),
-      sizes(std::make_unique<glm::u32vec2[]>(REGION_CHUNKS_COUNT)) {
+      sizes(std::make_unique<glm::u32vec2[]>(REGION_CHUNKS_COUNT)),
+      methods(std::make_unique<compression::Method[]>(REGION_CHUNKS_COUNT)) {
 }
 
 WorldRegion::~WorldRegion() = default;
@@ -41,12 +43,22 @@ glm::u32vec2* WorldRegion::getSizes() const {
     return sizes.get();
 }
 
+compression::Method* WorldRegion::getCompressions() const {
+    return methods.get();
+}
+
 void WorldRegion::put(
-    uint x, uint z, std::unique_ptr<ubyte[]> data, uint32_t size, uint32_t srcSize
+    uint x,
+    uint z,
+    std::unique_ptr<ubyte[]> data,
+    uint32_t size,
+    uint32_t srcSize,
+    compression::Method method
 ) {
     size_t chunk_index = z * REGION_SIZE + x;
     chunksData[chunk_index] = std::move(data);
     sizes[chunk_index] = glm::u32vec2(size, srcSize);
+    methods[chunk_index] = method;
 }
 
 ubyte* WorldRegion::getChunkData(uint x, uint z) {
@@ -57,6 +69,47 @@ glm::u32vec2 WorldRegion::getChunkDataSize(uint x, uint z) {
     return sizes[z * REGION_SIZE + x];
 }
 
+compression::Method WorldRegion::getChunkCompression(uint x, uint z) {
+    return methods[z * REGION_SIZE + x];
+}
+
+std::unique_ptr<WorldRegion> WorldRegion::clone() const {
+    auto region = std::make_unique<WorldRegion>();
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        const auto& data = chunksData[i];
+        if (data == nullptr) {
+            continue;
+        }
+        uint32_t size = sizes[i][0];
+        auto copy = std::make_unique<ubyte[]>(size);
+        std::memcpy(copy.get(), data.get(), size);
+        region->chunksData[i] = std::move(copy);
+        region->sizes[i] = sizes[i];
+        region->methods[i] = methods[i];
+    }
+    region->unsaved = unsaved.load();
+    return region;
+}
+
+bool WorldRegion::isEmpty() const {
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        if (chunksData[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t WorldRegion::getDataSize() const {
+    size_t total = 0;
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        if (chunksData[i]) {
+            total += sizes[i][0];
+        }
+    }
+    return total;
+}
+
 WorldRegions::WorldRegions(const io::path& directory) : directory(directory) {
     for (size_t i = 0; i < REGION_LAYERS_COUNT; i++) {
         layers[i].layer = static_cast<RegionLayerIndex>(i);
@@ -69,24 +122,50 @@ WorldRegions::WorldRegions(const io::path& directory) : directory(directory) {
     lights.folder = directory / "lights";
     lights.compression = compression::Method::EXTRLE8;
 
-    layers[REGION_LAYER_INVENTORIES].folder =
-        directory / "inventories";
-    layers[REGION_LAYER_ENTITIES].folder = directory / "entities";
+    auto& inventories = layers[REGION_LAYER_INVENTORIES];
+    inventories.folder = directory / "inventories";
+    inventories.compression = compression::Method::LZ4;
+
+    auto& entities = layers[REGION_LAYER_ENTITIES];
+    entities.folder = directory / "entities";
+    entities.compression = compression::Method::LZ4;
 
     auto& blocksData = layers[REGION_LAYER_BLOCKS_DATA];
     blocksData.folder = directory / "blocksdata";
+    blocksData.compression = compression::Method::LZ4;
+
+    regionsIO = std::make_unique<RegionsIO>(MAX_QUEUED_REGIONS_BYTES);
+    for (auto& layer : layers) {
+        layer.regionsIO = regionsIO.get();
+    }
 }
 
 WorldRegions::~WorldRegions() = default;
 
 void RegionsLayer::writeAll() {
-    for (auto& it : regions) {
-        WorldRegion* region = it.second.get();
-        if (region->getChunks() == nullptr || !region->isUnsaved()) {
+    std::vector<std::pair<glm::ivec2, WorldRegion*>> unsaved;
+    {
+        std::lock_guard lock(mapMutex);
+        for (auto& [key, region] : regions) {
+            if (region->getChunks() != nullptr && region->isUnsaved()) {
+                unsaved.emplace_back(key, region.get());
+            }
+        }
+    }
+    // regions are not removed from the map, so pointers stay valid
+    for (const auto& [key, region] : unsaved) {
+        if (regionsIO == nullptr) {
+            writeRegion(key[0], key[1], region);
             continue;
         }
-        const auto& key = it.first;
-        writeRegion(key[0], key[1], region);
+        // the snapshot is written in background while the region
+        // keeps being modified
+        auto snapshot = region->clone();
+        size_t bytes = snapshot->getDataSize();
+        region->setUnsaved(false);
+        regionsIO->enqueueWrite(
+            *this, key[0], key[1], std::move(snapshot), bytes
+        );
     }
 }
 
@@ -106,7 +185,7 @@ void WorldRegions::put(
     region->setUnsaved(true);
     
     if (data == nullptr) {
-        region->put(localX, localZ, nullptr, 0, 0);
+        region->put(localX, localZ, nullptr, 0, 0, layer.compression);
         return;
     }
 
@@ -114,7 +193,9 @@ void WorldRegions::put(
         data = compression::compress(
             data.get(), size, size, layer.compression);
     }
-    region->put(localX, localZ, std::move(data), size, srcSize);
+    region->put(
+        localX, localZ, std::move(data), size, srcSize, layer.compression
+    );
 }
 
 static std::unique_ptr<ubyte[]> write_inventories(
@@ -125,7 +206,8 @@ static std::unique_ptr<ubyte[]> write_inventories(
     for (auto& entry : inventories) {
         builder.putInt32(entry.first);
         auto map = entry.second->serialize();
-        auto bytes = json::to_binary(map, true);
+        // compressed by the regions layer
+        auto bytes = json::to_binary(map);
         builder.putInt32(bytes.size());
         builder.put(bytes.data(), bytes.size());
     }
@@ -157,10 +239,9 @@ void WorldRegions::put(Chunk* chunk, std::vector<ubyte> entitiesData) {
         return;
     }
     assert(chunk != nullptr);
-    if (!chunk->flags.lighted) {
-        return;
-    }
-    bool lightsUnsaved = !chunk->flags.loadedLights && doWriteLights;
+    // chunks modified before being lit are saved without lights
+    bool lightsUnsaved = chunk->flags.lighted && !chunk->flags.loadedLights &&
+                         doWriteLights;
     if (!chunk->flags.unsaved && !lightsUnsaved && !chunk->flags.entities) {
         return;
     }
@@ -218,51 +299,69 @@ void WorldRegions::put(Chunk* chunk, std::vector<ubyte> entitiesData) {
 std::unique_ptr<ubyte[]> WorldRegions::getVoxels(int x, int z) {
     uint32_t size;
     uint32_t srcSize;
+    compression::Method method;
     auto& layer = layers[REGION_LAYER_VOXELS];
-    auto* data = layer.getData(x, z, size, srcSize);
+    auto* data = layer.getData(x, z, size, srcSize, method);
     if (data == nullptr) {
         return nullptr;
     }
     assert(srcSize == CHUNK_DATA_LEN);
-    return compression::decompress(data, size, srcSize, layer.compression);
+    return compression::decompress(data, size, srcSize, method);
 }
 
 std::unique_ptr<light_t[]> WorldRegions::getLights(int x, int z) {
     uint32_t size;
     uint32_t srcSize;
+    compression::Method method;
     auto& layer = layers[REGION_LAYER_LIGHTS];
-    auto* bytes = layer.getData(x, z, size, srcSize);
+    auto* bytes = layer.getData(x, z, size, srcSize, method);
     if (bytes == nullptr) {
         return nullptr;
     }
-    auto data = compression::decompress(
-        bytes, size, srcSize, layer.compression
-    );
+    auto data = compression::decompress(bytes, size, srcSize, method);
     if (srcSize == LIGHTMAP_DATA_LEN) {
         return Lightmap::decode(data.get());
     }
     return nullptr;
 }
 
+std::unique_ptr<ubyte[]> WorldRegions::fetchData(
+    RegionLayerIndex layerid, int x, int z, uint32_t& size
+) {
+    uint32_t srcSize;
+    compression::Method method;
+    auto& layer = layers[layerid];
+    auto bytes = layer.getData(x, z, size, srcSize, method);
+    if (bytes == nullptr) {
+        return nullptr;
+    }
+    if (method != compression::Method::NONE) {
+        auto data = compression::decompress(bytes, size, srcSize, method);
+        size = srcSize;
+        return data;
+    }
+    auto data = std::make_unique<ubyte[]>(size);
+    std::memcpy(data.get(), bytes, size);
+    return data;
+}
+
 ChunkInventoriesMap WorldRegions::fetchInventories(int x, int z) {
     uint32_t bytesSize;
-    uint32_t srcSize;
-    auto bytes = layers[REGION_LAYER_INVENTORIES].getData(x, z, bytesSize, srcSize);
+    auto bytes = fetchData(REGION_LAYER_INVENTORIES, x, z, bytesSize);
     if (bytes == nullptr) {
         return {};
     }
-    return load_inventories(bytes, bytesSize);
+    return load_inventories(bytes.get(), bytesSize);
 }
 
 BlocksMetadata WorldRegions::getBlocksData(int x, int z) {
     uint32_t bytesSize;
-    uint32_t srcSize;
-    auto bytes = layers[REGION_LAYER_BLOCKS_DATA].getData(x, z, bytesSize, srcSize);
+    auto bytes = fetchData(REGION_LAYER_BLOCKS_DATA, x, z, bytesSize);
     if (bytes == nullptr) {
         return {};
     }
     BlocksMetadata heap;
-    heap.deserialize(bytes, bytesSize);
+    heap.deserialize(bytes.get(), bytesSize);
     return heap;
 }
 
@@ -278,8 +377,10 @@ void WorldRegions::processInventories(int x, int z, const InventoryProc& func) {
 }
 
 void WorldRegions::processBlocksData(int x, int z, const BlockDataProc& func) {
+    flush();
     auto& voxLayer = layers[REGION_LAYER_VOXELS];
     auto& datLayer = layers[REGION_LAYER_BLOCKS_DATA];
+    datLayer.discardPrefetched(x, z);
     if (voxLayer.getRegion(x, z) || datLayer.getRegion(x, z)) {
         throw std::runtime_error("not implemented for in-memory regions");
     }
@@ -301,29 +402,39 @@ void WorldRegions::processBlocksData(int x, int z, const BlockDataProc& func) {
 
             uint32_t datLength;
             uint32_t datSrcSize;
-            auto datData = RegionsLayer::readChunkData(
-                gx, gz, datLength, datSrcSize, datRegfile.get()
+            std::unique_ptr<ubyte[]> datStorage;
+            auto datData = RegionsLayer::viewChunkData(
+                gx, gz, datLength, datSrcSize, datRegfile.get(), datStorage
             );
             if (datData == nullptr) {
                 continue;
             }
+            if (datRegfile.get()->compression != compression::Method::NONE) {
+                datStorage = compression::decompress(
+                    datData, datLength, datSrcSize,
+                    datRegfile.get()->compression
+                );
+                datData = datStorage.get();
+                datLength = datSrcSize;
+            }
             uint32_t voxLength;
             uint32_t voxSrcSize;
-            auto voxData = RegionsLayer::readChunkData(
-                gx, gz, voxLength, voxSrcSize, voxRegfile.get()
+            std::unique_ptr<ubyte[]> voxStorage;
+            auto voxBytes = RegionsLayer::viewChunkData(
+                gx, gz, voxLength, voxSrcSize, voxRegfile.get(), voxStorage
             );
-            if (voxData == nullptr) {
+            if (voxBytes == nullptr) {
                 logger.warning()
                     << "missing voxels for chunk (" << gx << ", " << gz << ")";
                 put(gx, gz, REGION_LAYER_BLOCKS_DATA, nullptr, 0);
                 continue;
             }
-            voxData = compression::decompress(
-                voxData.get(), voxLength, voxSrcSize, voxLayer.compression
+            auto voxData = compression::decompress(
+                voxBytes, voxLength, voxSrcSize, voxRegfile.get()->compression
             );
 
             BlocksMetadata blocksData;
-            blocksData.deserialize(datData.get(), datLength);
+            blocksData.deserialize(datData, datLength);
             try {
                 func(&blocksData, std::move(voxData));
             } catch (const std::exception& err) {
@@ -342,12 +453,11 @@ dv::value WorldRegions::fetchEntities(int x, int z) {
         return nullptr;
     }
     uint32_t bytesSize;
-    uint32_t srcSize;
-    const ubyte* data = layers[REGION_LAYER_ENTITIES].getData(x, z, bytesSize, srcSize);
+    auto data = fetchData(REGION_LAYER_ENTITIES, x, z, bytesSize);
     if (data == nullptr) {
         return nullptr;
     }
-    auto map = json::from_binary(data, bytesSize);
+    auto map = json::from_binary(data.get(), bytesSize);
     if (map.empty()) {
         return nullptr;
     }
@@ -357,10 +467,12 @@ dv::value WorldRegions::fetchEntities(int x, int z) {
 void WorldRegions::processRegion(
     int x, int z, RegionLayerIndex layerid, const RegionProc& func
 ) {
+    flush();
     auto& layer = layers[layerid];
     if (layer.getRegion(x, z)) {
         throw std::runtime_error("not implemented for in-memory regions");
     }
+    layer.discardPrefetched(x, z);
     auto regfile = layer.getRegFile({x, z});
     if (regfile == nullptr) {
         throw std::runtime_error("could not open region file");
@@ -371,16 +483,21 @@ void WorldRegions::processRegion(
             int gz = cz + z * REGION_SIZE;
             uint32_t length;
             uint32_t srcSize;
-            auto data =
-                RegionsLayer::readChunkData(gx, gz, length, srcSize, regfile.get());
-            if (data == nullptr) {
+            std::unique_ptr<ubyte[]> data;
+            auto bytes = RegionsLayer::viewChunkData(
+                gx, gz, length, srcSize, regfile.get(), data
+            );
+            if (bytes == nullptr) {
                 continue;
             }
-            if (layer.compression != compression::Method::NONE) {
-                data = compression::decompress(
-                    data.get(), length, srcSize, layer.compression
-                );
+            auto method = regfile.get()->compression;
+            if (method != compression::Method::NONE) {
+                data = compression::decompress(bytes, length, srcSize, method);
             } else {
+                if (data == nullptr) {
+                    data = std::make_unique<ubyte[]>(length);
+                    std::memcpy(data.get(), bytes, length);
+                }
                 srcSize = length;
             }
             if (auto writeData = func(std::move(data), &srcSize)) {
@@ -398,6 +515,27 @@ io::path WorldRegions::getRegionFilePath(RegionLayerIndex layerid, int x, int z)
     return layers[layerid].getRegionFilePath(x, z);
 }
 
+void WorldRegions::setMemoryMapped(RegionLayerIndex layerid, bool flag) {
+    layers[layerid].memoryMapped = flag;
+}
+
+void WorldRegions::setCompression(
+    RegionLayerIndex layerid, compression::Method method
+) {
+    layers[layerid].compression = method;
+}
+
+void WorldRegions::recompressRegion(RegionLayerIndex layerid, int x, int z) {
+    flush();
+    auto& layer = layers[layerid];
+    if (layer.getRegion(x, z)) {
+        throw std::runtime_error("not implemented for in-memory regions");
+    }
+    // all chunks are read from the current file and converted
+    WorldRegion region;
+    layer.writeRegion(x, z, &region);
+}
+
 void WorldRegions::writeAll() {
     for (auto& layer : layers) {
         io::create_directories(layer.folder);
@@ -405,11 +543,28 @@ void WorldRegions::writeAll() {
     }
 }
 
+void WorldRegions::flush() {
+    regionsIO->flush();
+}
+
+void WorldRegions::prefetch(int x, int z) {
+    if (generatorTestMode) {
+        return;
+    }
+    int regionX, regionZ, localX, localZ;
+    calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
+    for (auto& layer : layers) {
+        layer.prefetch(regionX, regionZ);
+    }
+}
+
 void WorldRegions::deleteRegion(RegionLayerIndex layerid, int x, int z) {
+    flush();
     auto& layer = layers[layerid];
     if (layer.getRegFile({x, z}, false)) {
         throw std::runtime_error("region file is currently in use");
     }
+    layer.discardPrefetched(x, z);
     auto file = layer.getRegionFilePath(x, z);
     if (io::exists(file)) {
         logger.info() << "remove region file " << file.string();
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <glm/glm.hpp>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "typedefs.hpp"
 #include "util/BufferPool.hpp"
@@ -24,6 +27,14 @@ inline constexpr uint REGION_SIZE_BIT = 5;
 inline constexpr uint REGION_SIZE = (1 << (REGION_SIZE_BIT));
 inline constexpr uint REGION_CHUNKS_COUNT = ((REGION_SIZE) * (REGION_SIZE));
 
+/// @brief Max total size of region snapshots waiting to be written
+inline constexpr size_t MAX_QUEUED_REGIONS_BYTES = 64 * 1024 * 1024;
+
+/// @brief Max number of read ahead regions kept by a layer
+inline constexpr uint MAX_PREFETCHED_REGIONS = 4;
+
+class RegionsIO;
+
 class illegal_region_format : public std::runtime_error {
 public:
     illegal_region_format(const std::string& message)
@@ -34,32 +45,77 @@ public:
 class WorldRegion {
     std::unique_ptr<std::unique_ptr<ubyte[]>[]> chunksData;
     std::unique_ptr<glm::u32vec2[]> sizes;
-    bool unsaved = false;
+    /// @brief Chunks data compression methods. Chunks read from a file
+    /// keep the file method until the region is written
+    std::unique_ptr<compression::Method[]> methods;
+    /// @brief Set back by the regions I/O thread if writing failed
+    std::atomic_bool unsaved {false};
 public:
     WorldRegion();
     ~WorldRegion();
 
-    void put(uint x, uint z, std::unique_ptr<ubyte[]> data, uint32_t size, uint32_t srcSize);
+    void put(
+        uint x,
+        uint z,
+        std::unique_ptr<ubyte[]> data,
+        uint32_t size,
+        uint32_t srcSize,
+        compression::Method method
+    );
     ubyte* getChunkData(uint x, uint z);
     glm::u32vec2 getChunkDataSize(uint x, uint z);
+    compression::Method getChunkCompression(uint x, uint z);
 
     void setUnsaved(bool unsaved);
     bool isUnsaved() const;
 
+    /// @brief Create a deep copy of the region
+    std::unique_ptr<WorldRegion> clone() const;
+
+    /// @return true if no chunks data is stored
+    bool isEmpty() const;
+
+    /// @return total size of stored chunks data
+    size_t getDataSize() const;
+
     std::unique_ptr<ubyte[]>* getChunks() const;
     glm::u32vec2* getSizes() const;
+    compression::Method* getCompressions() const;
 };
 
 struct regfile {
-    io::rafile file;
+    /// @brief Stream used if the file is not memory-mapped
+    std::unique_ptr<io::rafile> file;
+    std::unique_ptr<io::mmfile> mapped;
     io::path filename;
     int version;
+    /// @brief Chunks data compression method stored in the file header
+    compression::Method compression = compression::Method::NONE;
     bool inUse = false;
 
-    regfile(io::path filename);
+    /// @param memoryMapped map the file to memory instead of reading it
+    /// via stream. Falls back to stream if mapping is not available
+    regfile(io::path filename, bool memoryMapped = false);
     regfile(const regfile&) = delete;
 
+    /// @brief Read a copy of the chunk data
+    /// @return nullptr if chunk data is not present
     std::unique_ptr<ubyte[]> read(int index, uint32_t& size, uint32_t& srcSize);
+
+    /// @brief Get chunk data without copying if the file is memory-mapped,
+    /// otherwise read it to the storage
+    /// @param storage buffer owning data read via stream
+    /// @return nullptr if chunk data is not present. The pointer is valid
+    /// while the regfile and the storage are alive
+    const ubyte* view(
+        int index,
+        uint32_t& size,
+        uint32_t& srcSize,
+        std::unique_ptr<ubyte[]>& storage
+    );
+private:
+    /// @return chunk data offset or 0 if not present or corrupted
+    uint32_t findChunk(int index, uint32_t& size, uint32_t& srcSize);
 };
 
 using RegionsMap = std::unordered_map<glm::ivec2, std::unique_ptr<WorldRegion>>;
@@ -99,7 +155,7 @@ public:
     void reset() {
         if (file) {
             file->inUse = false;
-            cv->notify_one();
+            cv->notify_all();
             file = nullptr;
         }
     }
@@ -123,6 +179,9 @@ struct RegionsLayer {
 
     compression::Method compression = compression::Method::NONE;
 
+    /// @brief Read region files via memory mapping
+    bool memoryMapped = false;
+
     /// @brief In-memory regions data
     RegionsMap regions;
 
@@ -136,6 +195,18 @@ struct RegionsLayer {
     std::mutex regFilesMutex;
     std::condition_variable regFilesCv;
 
+    /// @brief Background regions I/O. Synchronous I/O is used if nullptr
+    RegionsIO* regionsIO = nullptr;
+
+    /// @brief Regions requested to be read ahead and not read yet
+    /// (guarded by mapMutex)
+    std::unordered_set<glm::ivec2> prefetchPending;
+
+    /// @brief Read ahead regions, least recently used first. Chunks data
+    /// is moved out on loading, consumed regions are removed
+    /// (guarded by mapMutex)
+    std::vector<std::pair<glm::ivec2, std::unique_ptr<WorldRegion>>> prefetched;
+
     [[nodiscard]] regfile_ptr getRegFile(glm::ivec2 coord, bool create = true);
     [[nodiscard]] regfile_ptr useRegFile(glm::ivec2 coord);
     regfile_ptr createRegFile(glm::ivec2 coord);
@@ -151,17 +222,63 @@ struct RegionsLayer {
     /// @param z chunk z coord
     /// @param size [out] compressed chunk data length
     /// @param size [out] source chunk data length
+    /// @param method [out] chunk data compression method. Chunks read from
+    /// files written with another method are not converted
     /// @return nullptr if no saved chunk data found
-    [[nodiscard]] ubyte* getData(int x, int z, uint32_t& size, uint32_t& srcSize);
+    [[nodiscard]] ubyte* getData(
+        int x,
+        int z,
+        uint32_t& size,
+        uint32_t& srcSize,
+        compression::Method& method
+    );
 
-    /// @brief Write or rewrite region file
+    /// @brief Write or rewrite region file. Missing chunks data is read
+    /// from the existing file. Chunks compressed with other method than
+    /// the layer one are converted. The file is replaced when completely
+    /// written, so it may be called from any thread
     /// @param x region X
     /// @param z region Z
     void writeRegion(int x, int y, WorldRegion* entry);
 
-    /// @brief Write all unsaved regions to files
+    /// @brief Write all unsaved regions to files. Writing is performed in
+    /// background if regionsIO is set
     void writeAll();
 
+    /// @brief Read all region file chunks to the read ahead regions if
+    /// region is not loaded yet. The least recently used read ahead region
+    /// is discarded if there are MAX_PREFETCHED_REGIONS of them.
+    /// May be called from any thread
+    /// @param x region X
+    /// @param z region Z
+    void readRegion(int x, int z);
+
+    /// @brief Request background reading of the region
+    /// @param x region X
+    /// @param z region Z
+    void prefetch(int x, int z);
+
+    /// @brief Move chunk data out of the read ahead region
+    /// @param x chunk x coord
+    /// @param z chunk z coord
+    /// @param data [out] chunk data or nullptr if not present in the file
+    /// @param size [out] compressed chunk data length
+    /// @param srcSize [out] source chunk data length
+    /// @param method [out] chunk data compression method
+    /// @return false if the region is not read ahead
+    bool takePrefetched(
+        int x,
+        int z,
+        std::unique_ptr<ubyte[]>& data,
+        uint32_t& size,
+        uint32_t& srcSize,
+        compression::Method& method
+    );
+
+    /// @brief Discard read ahead region data (if any) outdated by
+    /// region file processing or removal
+    void discardPrefetched(int x, int z);
+
     /// @brief Read chunk data from region file
     /// @param x chunk x coord
     /// @param z chunk z coord
@@ -172,6 +289,24 @@ struct RegionsLayer {
     [[nodiscard]] static std::unique_ptr<ubyte[]> readChunkData(
         int x, int z, uint32_t& size, uint32_t& srcSize, regfile* rfile
     );
+
+    /// @brief Get chunk data from region file without copying if the file
+    /// is memory-mapped
+    /// @param x chunk x coord
+    /// @param z chunk z coord
+    /// @param size [out] compressed chunk data length
+    /// @param srcSize [out] source chunk data length
+    /// @param rfile region file
+    /// @param storage [out] buffer owning data if it was copied
+    /// @return nullptr if chunk is not present in region file
+    [[nodiscard]] static const ubyte* viewChunkData(
+        int x,
+        int z,
+        uint32_t& size,
+        uint32_t& srcSize,
+        regfile* rfile,
+        std::unique_ptr<ubyte[]>& storage
+    );
 };
 
 class WorldRegions {
@@ -179,6 +314,17 @@ class WorldRegions {
     io::path directory;
 
     RegionsLayer layers[REGION_LAYERS_COUNT] {};
+
+    /// @brief Declared after layers to finish writing before they are
+    /// destroyed
+    std::unique_ptr<RegionsIO> regionsIO;
+
+    /// @brief Get decompressed chunk data
+    /// @param size [out] data length
+    /// @return nullptr if no saved chunk data found
+    std::unique_ptr<ubyte[]> fetchData(
+        RegionLayerIndex layerid, int x, int z, uint32_t& size
+    );
 public:
     bool generatorTestMode = false;
     bool doWriteLights = true;
@@ -243,9 +389,32 @@ public:
 
     io::path getRegionFilePath(RegionLayerIndex layerid, int x, int z) const;
 
-    /// @brief Write all region layers
+    /// @brief Set compression method used for the layer chunks data.
+    /// Chunks read from files compressed by other method are converted
+    /// when the region is written
+    void setCompression(RegionLayerIndex layerid, compression::Method method);
+
+    /// @brief Rewrite region file using the layer compression method
+    /// @throws std::runtime_error if the region is loaded to memory
+    void recompressRegion(RegionLayerIndex layerid, int x, int z);
+
+    /// @brief Enable or disable memory-mapped reading of the layer region
+    /// files. Affects files opened after the call
+    void setMemoryMapped(RegionLayerIndex layerid, bool flag);
+
+    /// @brief Write all region layers. Writing is finished in background,
+    /// use flush() to wait for it
     void writeAll();
 
+    /// @brief Wait until all background regions reading and writing is
+    /// finished
+    void flush();
+
+    /// @brief Request background reading of region containing the chunk
+    /// @param x chunk.x
+    /// @param z chunk.z
+    void prefetch(int x, int z);
+
     void deleteRegion(RegionLayerIndex layerid, int x, int z);
 
     /// @brief Extract X and Z from 'X_Z.bin' region file name.
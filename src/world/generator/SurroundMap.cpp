@@ -1,14 +1,9 @@
 #include "SurroundMap.hpp"
 
-#include <queue>
-#include <cstring>
 #include <stdexcept>
 
-SurroundMap::SurroundMap(int maxLevelRadius, int8_t maxLevel) 
-    : areaMap((maxLevelRadius + maxLevel) * 2 + 1, 
-              (maxLevelRadius + maxLevel) * 2 + 1),
-      levelCallbacks(maxLevel),
-      maxLevel(maxLevel) 
+SurroundMap::SurroundMap(int8_t maxLevel) 
+    : levelCallbacks(maxLevel), maxLevel(maxLevel)
 {}
 
 void SurroundMap::setLevelCallback(int8_t level, LevelCallback callback) {
@@ -17,8 +12,8 @@ void SurroundMap::setLevelCallback(int8_t level, LevelCallback callback) {
     wrapper.active = callback != nullptr;
 }
 
-void SurroundMap::setOutCallback(util::AreaMap2D<int8_t>::OutCallback callback) {
-    areaMap.setOutCallback(callback);
+void SurroundMap::setOutCallback(OutCallback callback) {
+    outCallback = std::move(callback);
 }
 
 void SurroundMap::upgrade(int x, int y, int8_t level) {
@@ -28,14 +23,14 @@ void SurroundMap::upgrade(int x, int y, int8_t level) {
         for (int lx = -size+1; lx < size; lx++) {
             int posX = lx + x;
             int posY = ly + y;
-            int8_t sourceLevel = areaMap.get(posX, posY, 0);
-            if (sourceLevel < level-1) {
+            auto& point = points.at({posX, posY});
+            if (point.level < level-1) {
                 throw std::runtime_error("invalid map state");
             }
-            if (sourceLevel >= level) {
+            if (point.level >= level) {
                 continue;
             }
-            areaMap.set(posX, posY, level);
+            point.level = level;
             if (callback.active) {
                 callback.callback(posX, posY);
             }
@@ -43,29 +38,99 @@ void SurroundMap::upgrade(int x, int y, int8_t level) {
     }
 }
 
-void SurroundMap::resize(int maxLevelRadius) {
-    areaMap.resize((maxLevelRadius + maxLevel) * 2 + 1,
-                   (maxLevelRadius + maxLevel) * 2 + 1);
+void SurroundMap::acquire(const Area& area, const Area* except) {
+    for (int y = area.y - area.radius; y <= area.y + area.radius; y++) {
+        for (int x = area.x - area.radius; x <= area.x + area.radius; x++) {
+            if (except && except->contains(x, y)) {
+                continue;
+            }
+            points[{x, y}].refs++;
+        }
+    }
+}
+
+void SurroundMap::release(const Area& area, const Area* except) {
+    for (int y = area.y - area.radius; y <= area.y + area.radius; y++) {
+        for (int x = area.x - area.radius; x <= area.x + area.radius; x++) {
+            if (except && except->contains(x, y)) {
+                continue;
+            }
+            const auto& found = points.find({x, y});
+            if (found == points.end() || --found->second.refs > 0) {
+                continue;
+            }
+            int8_t level = found->second.level;
+            points.erase(found);
+            if (level && outCallback) {
+                outCallback(x, y, level);
+            }
+        }
+    }
+}
+
+void SurroundMap::setArea(int64_t id, int x, int y, int maxLevelRadius) {
+    Area area {x, y, maxLevelRadius + maxLevel};
+    const auto& found = areas.find(id);
+    if (found == areas.end()) {
+        acquire(area, nullptr);
+        areas[id] = area;
+        return;
+    }
+    Area prev = found->second;
+    if (prev.x == area.x && prev.y == area.y && prev.radius == area.radius) {
+        return;
+    }
+    // acquire before release to keep shared points alive
+    acquire(area, &prev);
+    found->second = area;
+    release(prev, &area);
+}
+
+void SurroundMap::removeArea(int64_t id) {
+    const auto& found = areas.find(id);
+    if (found == areas.end()) {
+        return;
+    }
+    Area area = found->second;
+    areas.erase(found);
+    release(area, nullptr);
+}
+
+std::vector<int64_t> SurroundMap::getAreas() const {
+    std::vector<int64_t> ids;
+    ids.reserve(areas.size());
+    for (const auto& [id, _] : areas) {
+        ids.push_back(id);
+    }
+    return ids;
 }
 
 void SurroundMap::completeAt(int x, int y) {
-    if (!areaMap.isInside(x - maxLevel + 1, y - maxLevel + 1) ||
-        !areaMap.isInside(x + maxLevel - 1, y + maxLevel - 1)) {
-        throw std::invalid_argument(
-            "upgrade square is not fully inside of area");
+    for (int ly = y - maxLevel + 1; ly < y + maxLevel; ly++) {
+        for (int lx = x - maxLevel + 1; lx < x + maxLevel; lx++) {
+            if (points.find({lx, ly}) == points.end()) {
+                throw std::invalid_argument(
+                    "upgrade square is not fully covered by areas");
+            }
+        }
     }
     for (int8_t level = 1; level <= maxLevel; level++) {
         upgrade(x, y, level);
     }
 }
 
-void SurroundMap::setCenter(int x, int y) {
-    areaMap.setCenter(x, y);
+int8_t SurroundMap::at(int x, int y) const {
+    const auto& found = points.find({x, y});
+    if (found != points.end()) {
+        return found->second.level;
+    }
+    throw std::invalid_argument("position is out of area");
 }
 
-int8_t SurroundMap::at(int x, int y) {
-    if (auto ptr = areaMap.getIf(x, y)) {
-        return *ptr;
+int8_t SurroundMap::get(int x, int y) const {
+    const auto& found = points.find({x, y});
+    if (found != points.end()) {
+        return found->second.level;
     }
-    throw std::invalid_argument("position is out of area");
+    return 0;
 }
@@ -1,50 +1,88 @@
 #pragma once
 
-#include <unordered_map>
+#include <vector>
+#include <cstdlib>
 #include <functional>
+#include <unordered_map>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 
 #include "typedefs.hpp"
-#include "util/AreaMap2D.hpp"
 
+/// @brief Sparse map of points levels. Points are kept while covered by at
+/// least one area, so any number of areas (e.g. players loading zones) may
+/// share the same points.
 class SurroundMap {
 public:
     using LevelCallback = std::function<void(int, int)>;
+    using OutCallback = std::function<void(int, int, int8_t)>;
     struct LevelCallbackWrapper {
         LevelCallback callback;
         bool active = false;
     };
 private:
-    util::AreaMap2D<int8_t> areaMap;
+    struct Point {
+        int8_t level = 0;
+        /// @brief Number of areas covering the point
+        uint16_t refs = 0;
+    };
+    struct Area {
+        int x, y;
+        int radius;
+
+        bool contains(int px, int py) const {
+            return std::abs(px - x) <= radius && std::abs(py - y) <= radius;
+        }
+    };
+    std::unordered_map<glm::ivec2, Point> points;
+    std::unordered_map<int64_t, Area> areas;
     std::vector<LevelCallbackWrapper> levelCallbacks;
+    OutCallback outCallback;
     int8_t maxLevel;
 
     void upgrade(int x, int y, int8_t level);
+    void acquire(const Area& area, const Area* except);
+    void release(const Area& area, const Area* except);
 public:
-    SurroundMap(int maxLevelRadius, int8_t maxLevel);
+    SurroundMap(int8_t maxLevel);
 
     /// @brief Callback called on point level increments
     void setLevelCallback(int8_t level, LevelCallback callback);
 
-    /// @brief Callback called when non-zero value moves out of area
-    void setOutCallback(util::AreaMap2D<int8_t>::OutCallback callback);   
+    /// @brief Callback called when non-zero point is not covered by any area
+    void setOutCallback(OutCallback callback);
     
     /// @brief Upgrade point to maxLevel
-    /// @throws std::invalid_argument - upgrade square is not fully inside
+    /// @throws std::invalid_argument - upgrade square is not fully covered
     void completeAt(int x, int y);
 
-    /// @brief Set map area center
-    void setCenter(int x, int y);
+    /// @brief Create or move area
+    /// @param id area id
+    /// @param x area center X
+    /// @param y area center Y
+    /// @param maxLevelRadius radius where points may be upgraded to maxLevel
+    void setArea(int64_t id, int x, int y, int maxLevelRadius);
 
-    void resize(int maxLevelRadius);
+    /// @brief Remove area, releasing points not covered by other areas
+    void removeArea(int64_t id);
+
+    /// @return ids of all existing areas
+    std::vector<int64_t> getAreas() const;
 
     /// @brief Get level at position
     /// @throws std::invalid_argument - position is out of area
-    int8_t at(int x, int y);
+    int8_t at(int x, int y) const;
+
+    /// @brief Get level at position or 0 if position is out of area
+    int8_t get(int x, int y) const;
+
+    /// @return number of points covered by areas
+    size_t size() const {
+        return points.size();
+    }
 
-    const util::AreaMap2D<int8_t>& getArea() const {
-        return areaMap;
+    int8_t getMaxLevel() const {
+        return maxLevel;
     }
 };
@@ -170,29 +170,12 @@ void VoxelFragment::prepare(const Content& content) {
     }
 }
 
-void VoxelFragment::place(
+std::vector<glm::ivec2> VoxelFragment::place(
     GlobalChunks& chunks, const glm::ivec3& offset
 ) {
-    auto& structVoxels = getRuntimeVoxels();
-    for (int y = 0; y < size.y; y++) {
-        int sy = y + offset.y;
-        if (sy < 0 || sy >= CHUNK_H) {
-            continue;
-        }
-        for (int z = 0; z < size.z; z++) {
-            int sz = z + offset.z;
-            for (int x = 0; x < size.x; x++) {
-                int sx = x + offset.x;
-                const auto& structVoxel = 
-                    structVoxels[vox_index(x, y, z, size.x, size.z)];
-                if (structVoxel.id) {
-                    blocks_agent::set(
-                        chunks, sx, sy, sz, structVoxel.id, structVoxel.state
-                    );
-                }
-            }
-        }
-    }
+    return blocks_agent::set_voxels(
+        chunks, offset, size, getRuntimeVoxels().data()
+    );
 }
 
 std::unique_ptr<VoxelFragment> VoxelFragment::rotated(const Content& content) const {
@@ -43,9 +43,13 @@ public:
     /// @param content world content
     void prepare(const Content& content);
 
-    /// @brief Place fragment to the world
+    /// @brief Place fragment to the world. Air voxels are not placed.
+    /// Lights are not updated
     /// @param offset target location
-    void place(GlobalChunks& chunks, const glm::ivec3& offset);
+    /// @return positions of chunks having voxels changed
+    std::vector<glm::ivec2> place(
+        GlobalChunks& chunks, const glm::ivec3& offset
+    );
 
     /// @brief Create structure copy rotated 90 deg. clockwise
     std::unique_ptr<VoxelFragment> rotated(const Content& content) const;
@@ -29,13 +29,13 @@ WorldGenerator::WorldGenerator(
     : def(def), 
       content(content), 
       seed(seed),
-      surroundMap(0, BASIC_PROTOTYPE_LAYERS + def.wideStructsChunksRadius * 2)
+      surroundMap(BASIC_PROTOTYPE_LAYERS + def.wideStructsChunksRadius * 2)
 {
     def.script->initialize(seed);
 
     uint levels = BASIC_PROTOTYPE_LAYERS + def.wideStructsChunksRadius * 2;
 
-    surroundMap = SurroundMap(0, levels);
+    surroundMap = SurroundMap(levels);
     logger.info() << "total number of prototype levels is " << levels;
     surroundMap.setOutCallback([this](int const x, int const z, int8_t) {
         const auto& found = prototypes.find({x, z});
@@ -398,10 +398,18 @@ void WorldGenerator::generateHeightmap(
     prototype.level = ChunkPrototypeLevel::HEIGHTMAP;
 }
 
-void WorldGenerator::update(int centerX, int centerY, int loadDistance) {
-    surroundMap.setCenter(centerX, centerY);
-    surroundMap.resize(loadDistance);
-    surroundMap.setCenter(centerX, centerY);
+void WorldGenerator::update(
+    int64_t id, int centerX, int centerY, int loadDistance
+) {
+    surroundMap.setArea(id, centerX, centerY, loadDistance);
+}
+
+void WorldGenerator::removeArea(int64_t id) {
+    surroundMap.removeArea(id);
+}
+
+std::vector<int64_t> WorldGenerator::getAreas() const {
+    return surroundMap.getAreas();
 }
 
 void WorldGenerator::generatePlants(
@@ -411,7 +419,7 @@ void WorldGenerator::generatePlants(
     int chunkX,
     int chunkZ,
     const Biome** biomes
-) {
+) const {
     const auto& indices = content.getIndices()->blocks;
     util::PseudoRandom plantsRand;
     plantsRand.setSeed(chunkX, chunkZ);
@@ -453,7 +461,7 @@ void WorldGenerator::generateLand(
     int chunkX,
     int chunkZ,
     const Biome** biomes
-) {
+) const {
     uint seaLevel = def.seaLevel;
     for (uint z = 0; z < CHUNK_D; z++) {
         for (uint x = 0; x < CHUNK_W; x++) {
@@ -471,10 +479,22 @@ void WorldGenerator::generateLand(
     }
 }
 
-void WorldGenerator::generate(voxel* voxels, int chunkX, int chunkZ) {
+std::shared_ptr<const ChunkPrototype> WorldGenerator::prepare(
+    int chunkX, int chunkZ
+) {
     surroundMap.completeAt(chunkX, chunkZ);
+    // placements list may still be extended by neighbour prototypes,
+    // so the snapshot gets its own copy
+    return std::make_shared<ChunkPrototype>(requirePrototype(chunkX, chunkZ));
+}
 
-    const auto& prototype = requirePrototype(chunkX, chunkZ);
+void WorldGenerator::generate(voxel* voxels, int chunkX, int chunkZ) {
+    generate(voxels, *prepare(chunkX, chunkZ), chunkX, chunkZ);
+}
+
+void WorldGenerator::generate(
+    voxel* voxels, const ChunkPrototype& prototype, int chunkX, int chunkZ
+) const {
     const auto values = prototype.heightmap->getValues();
 
     uint seaLevel = def.seaLevel;
@@ -515,7 +535,7 @@ void WorldGenerator::generate(voxel* voxels, int chunkX, int chunkZ) {
 
 void WorldGenerator::generatePlacements(
     const ChunkPrototype& prototype, voxel* voxels, int chunkX, int chunkZ
-) {
+) const {
     auto placements = prototype.placements;
     std::stable_sort(
         placements.begin(),
@@ -540,7 +560,7 @@ void WorldGenerator::generateStructure(
     const StructurePlacement& placement,
     voxel* voxels, 
     int chunkX, int chunkZ
-) {
+) const {
     if (placement.structure < 0 || placement.structure >= def.structures.size()) {
         logger.error() << "invalid structure index " << placement.structure;
         return;
@@ -581,7 +601,7 @@ void WorldGenerator::generateLine(
     const LinePlacement& line,
     voxel* voxels, 
     int chunkX, int chunkZ
-) {
+) const {
     const auto& indices = content.getIndices()->blocks;
 
     int cgx = chunkX * CHUNK_W;
@@ -642,7 +662,7 @@ void WorldGenerator::generateBlock(
     const BlockPlacement& placement,
     voxel* voxels,
     int chunkX, int chunkZ
-) {
+) const {
     const auto& indices = content.getIndices()->blocks;
     const auto& def = indices.require(placement.block);
 
@@ -692,20 +712,25 @@ void WorldGenerator::generateBlock(
     }
 }
 
-WorldGenDebugInfo WorldGenerator::createDebugInfo() const {
-    const auto& area = surroundMap.getArea();
-    const auto& levels = area.getBuffer();
-    auto values = std::make_unique<ubyte[]>(area.getWidth()*area.getHeight());
-
-    for (uint i = 0; i < levels.size(); i++) {
-        values[i] = levels[i];
+WorldGenDebugInfo WorldGenerator::createDebugInfo(
+    int centerX, int centerY, int loadDistance
+) const {
+    int size = (loadDistance + surroundMap.getMaxLevel()) * 2 + 1;
+    int offsetX = centerX - size / 2;
+    int offsetY = centerY - size / 2;
+    auto values = std::make_unique<ubyte[]>(size * size);
+
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            values[y * size + x] = surroundMap.get(x + offsetX, y + offsetY);
+        }
     }
 
     return WorldGenDebugInfo {
-        area.getOffsetX(),
-        area.getOffsetY(),
-        static_cast<uint>(area.getWidth()),
-        static_cast<uint>(area.getHeight()),
+        offsetX,
+        offsetY,
+        static_cast<uint>(size),
+        static_cast<uint>(size),
         std::move(values)
     };
 }
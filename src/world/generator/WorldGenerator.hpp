@@ -26,7 +26,7 @@ struct ChunkPrototype {
     ChunkPrototypeLevel level = ChunkPrototypeLevel::VOID;
 
     /// @brief chunk biomes matrix
-    std::unique_ptr<const Biome*[]> biomes;
+    std::shared_ptr<const Biome*[]> biomes;
 
     /// @brief chunk heightmap
     std::shared_ptr<Heightmap> heightmap;
@@ -55,7 +55,8 @@ class WorldGenerator {
     uint64_t seed;
     /// @brief Chunk prototypes main storage
     std::unordered_map<glm::ivec2, std::unique_ptr<ChunkPrototype>> prototypes;
-    /// @brief Chunk prototypes loading surround map
+    /// @brief Chunk prototypes loading surround map shared by all
+    /// loading areas. Prototype is unloaded when no area covers it
     SurroundMap surroundMap;
 
     /// @brief Generate chunk prototype (see ChunkPrototype)
@@ -83,25 +84,25 @@ class WorldGenerator {
 
     void generatePlacements(
         const ChunkPrototype& prototype, voxel* voxels, int x, int z
-    );
+    ) const;
     void generateLine(
         const ChunkPrototype& prototype, 
         const LinePlacement& placement,
         voxel* voxels, 
         int x, int z
-    );
+    ) const;
     void generateBlock(
         const ChunkPrototype& prototype,
         const BlockPlacement& placement,
         voxel* voxels,
         int x, int z
-    );
+    ) const;
     void generateStructure(
         const ChunkPrototype& prototype, 
         const StructurePlacement& placement,
         voxel* voxels, 
         int x, int z
-    );
+    ) const;
     void generatePlants(
         const ChunkPrototype& prototype,
         float* values,
@@ -109,7 +110,7 @@ class WorldGenerator {
         int x,
         int z,
         const Biome** biomes
-    );
+    ) const;
     void generateLand(
         const ChunkPrototype& prototype,
         float* values,
@@ -117,7 +118,7 @@ class WorldGenerator {
         int x,
         int z,
         const Biome** biomes
-    );
+    ) const;
 
     void placeStructures(
         const std::vector<Placement>& placements,
@@ -132,7 +133,34 @@ public:
     );
     ~WorldGenerator();
 
-    void update(int centerX, int centerY, int loadDistance);
+    /// @brief Create or move prototypes loading area
+    /// @param id area id (e.g. player id)
+    void update(int64_t id, int centerX, int centerY, int loadDistance);
+
+    /// @brief Remove prototypes loading area. Prototypes not covered by
+    /// other areas are unloaded
+    void removeArea(int64_t id);
+
+    /// @return ids of all prototypes loading areas
+    std::vector<int64_t> getAreas() const;
+
+    /// @brief Complete chunk prototype. Must be called from the thread
+    /// owning the generator script.
+    /// @param x chunk position X divided by CHUNK_W
+    /// @param z chunk position Y divided by CHUNK_D
+    /// @return snapshot of the complete prototype that stays valid after
+    /// the prototype is unloaded
+    std::shared_ptr<const ChunkPrototype> prepare(int x, int z);
+
+    /// @brief Generate complete chunk voxels using prepared prototype.
+    /// Does not modify generator state so may be called from any thread.
+    /// @param voxels destination chunk voxels buffer
+    /// @param prototype prototype returned by prepare(x, z)
+    /// @param x chunk position X divided by CHUNK_W
+    /// @param z chunk position Y divided by CHUNK_D
+    void generate(
+        voxel* voxels, const ChunkPrototype& prototype, int x, int z
+    ) const;
 
     /// @brief Generate complete chunk voxels
     /// @param voxels destinatiopn chunk voxels buffer
@@ -140,7 +168,9 @@ public:
     /// @param z chunk position Y divided by CHUNK_D
     void generate(voxel* voxels, int x, int z);
 
-    WorldGenDebugInfo createDebugInfo() const;
+    WorldGenDebugInfo createDebugInfo(
+        int centerX, int centerY, int loadDistance
+    ) const;
 
     uint64_t getSeed() const;
 };
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "coders/compression.hpp"
+#include "coders/lz4.hpp"
+#include "coders/rle.hpp"
+#include "util/timeutil.hpp"
+#include "voxels/Chunk.hpp"
+
+TEST(lz4, EncodeDecode) {
+    const size_t length = 100'000;
+    std::vector<ubyte> source(length);
+    for (size_t i = 0; i < length; i++) {
+        source[i] = (i / 13) % 7 == 0 ? rand() : (i / 5) % 3;
+    }
+    std::vector<ubyte> encoded(lz4::compress_bound(length));
+    size_t encodedLength = lz4::encode(source.data(), length, encoded.data());
+    EXPECT_LT(encodedLength, length);
+
+    std::vector<ubyte> decoded(length);
+    size_t decodedLength =
+        lz4::decode(encoded.data(), encodedLength, decoded.data(), length);
+    EXPECT_EQ(decodedLength, length);
+    EXPECT_EQ(source, decoded);
+
+    EXPECT_THROW(
+        lz4::decode(encoded.data(), encodedLength, decoded.data(), length / 2),
+        std::runtime_error
+    );
+}
+
+/// @brief Generate terrain-like chunk voxels data
+static std::unique_ptr<ubyte[]> generate_chunk_data(int seed) {
+    Chunk chunk(seed, 0);
+    for (uint z = 0; z < CHUNK_D; z++) {
+        for (uint x = 0; x < CHUNK_W; x++) {
+            int height = 64 + 12 * std::sin((x + seed * CHUNK_W) * 0.1) *
+                                  std::cos(z * 0.07);
+            for (int y = 0; y < height; y++) {
+                auto& vox = chunk.voxels[vox_index(x, y, z)];
+                if (y < height - 4) {
+                    vox.id = rand() % 100 == 0 ? 5 + rand() % 4 : 1;
+                } else {
+                    vox.id = y == height - 1 ? 3 : 2;
+                }
+            }
+            if (rand() % 20 == 0) {
+                auto& vox = chunk.voxels[vox_index(x, height, z)];
+                vox.id = 10;
+                vox.state.rotation = rand() % 4;
+            }
+        }
+    }
+    return chunk.encode();
+}
+
+TEST(lz4, ChunksCompression) {
+    auto chunk = generate_chunk_data(0);
+    for (auto method : {
+             compression::Method::EXTRLE16,
+             compression::Method::GZIP,
+             compression::Method::LZ4,
+         }) {
+        size_t len;
+        auto bytes =
+            compression::compress(chunk.get(), CHUNK_DATA_LEN, len, method);
+        EXPECT_LT(len, static_cast<size_t>(CHUNK_DATA_LEN));
+        auto decoded = compression::decompress(
+            bytes.get(), len, CHUNK_DATA_LEN, method
+        );
+        EXPECT_EQ(0, std::memcmp(decoded.get(), chunk.get(), CHUNK_DATA_LEN));
+    }
+}
+
+TEST(lz4, DISABLED_ChunksCompressionBenchmark) {
+    const int chunksCount = 32;
+    std::vector<std::unique_ptr<ubyte[]>> chunks;
+    for (int i = 0; i < chunksCount; i++) {
+        chunks.push_back(generate_chunk_data(i));
+    }
+    auto measure = [&](const std::string& name, auto encode, auto decode) {
+        std::vector<std::vector<ubyte>> encoded;
+        size_t totalSize = 0;
+        timeutil::Timer encodeTimer;
+        for (const auto& chunk : chunks) {
+            encoded.push_back(encode(chunk.get()));
+            totalSize += encoded.back().size();
+        }
+        auto encodeTime = encodeTimer.stop();
+
+        timeutil::Timer decodeTimer;
+        for (size_t i = 0; i < encoded.size(); i++) {
+            auto decoded = decode(encoded[i]);
+            EXPECT_EQ(0, std::memcmp(decoded.get(), chunks[i].get(), CHUNK_DATA_LEN));
+        }
+        auto decodeTime = decodeTimer.stop();
+        std::cout << name << ": ratio "
+                  << static_cast<double>(CHUNK_DATA_LEN * chunksCount) / totalSize
+                  << ", encode " << encodeTime << " mcs, decode " << decodeTime
+                  << " mcs" << std::endl;
+    };
+    auto method_codec = [&](const std::string& name, compression::Method method) {
+        measure(
+            name,
+            [method](const ubyte* src) {
+                size_t len;
+                auto bytes = compression::compress(src, CHUNK_DATA_LEN, len, method);
+                return std::vector<ubyte>(bytes.get(), bytes.get() + len);
+            },
+            [method](const std::vector<ubyte>& src) {
+                return compression::decompress(
+                    src.data(), src.size(), CHUNK_DATA_LEN, method
+                );
+            }
+        );
+    };
+    method_codec("extrle16", compression::Method::EXTRLE16);
+    method_codec("gzip", compression::Method::GZIP);
+    method_codec("lz4", compression::Method::LZ4);
+
+    std::vector<ubyte> rleBuffer(CHUNK_DATA_LEN * 2);
+    auto chained = [&](const std::string& name, compression::Method method) {
+        measure(
+            name,
+            [&](const ubyte* src) {
+                size_t rleLength =
+                    extrle::encode16(src, CHUNK_DATA_LEN, rleBuffer.data());
+                size_t len;
+                auto bytes = compression::compress(
+                    rleBuffer.data(), rleLength, len, method
+                );
+                std::vector<ubyte> result(4 + len);
+                std::memcpy(result.data(), &rleLength, 4);
+                std::memcpy(result.data() + 4, bytes.get(), len);
+                return result;
+            },
+            [&](const std::vector<ubyte>& src) {
+                uint32_t rleLength;
+                std::memcpy(&rleLength, src.data(), 4);
+                auto rle = compression::decompress(
+                    src.data() + 4, src.size() - 4, rleLength, method
+                );
+                auto decoded = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
+                extrle::decode16(rle.get(), rleLength, decoded.get());
+                return decoded;
+            }
+        );
+    };
+    chained("extrle16+gzip", compression::Method::GZIP);
+    chained("extrle16+lz4", compression::Method::LZ4);
+}
@@ -0,0 +1,437 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+
+#include "assets/Assets.hpp"
+#include "content/Content.hpp"
+#include "content/ContentBuilder.hpp"
+#include "core_defs.hpp"
+#include "frontend/ContentGfxCache.hpp"
+#include "graphics/core/Atlas.hpp"
+#include "graphics/core/ImageData.hpp"
+#include "graphics/core/Mesh.hpp"
+#include "graphics/render/BlocksRenderer.hpp"
+#include "lighting/Lighting.hpp"
+#include "lighting/Lightmap.hpp"
+#include "objects/rigging.hpp"
+#include "settings.hpp"
+#include "util/timeutil.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+
+/// @brief Width and depth of the meshed area (chunk is unit)
+static constexpr int WORLD_SIZE = 6;
+/// @brief Size of the virtual atlas texture, regions are aligned to texels
+static constexpr int ATLAS_SIZE = 1024;
+
+/// @brief Meshes chunks without graphics context: the atlas has no texture
+/// and meshes are not uploaded to GPU
+class BlocksRendererTest : public ::testing::Test {
+protected:
+    EngineSettings settings;
+    Assets assets;
+    std::unique_ptr<Content> content;
+    std::unique_ptr<ContentGfxCache> cache;
+    std::unique_ptr<Chunks> chunks;
+    blockid_t stone, dirt, grass, glass, flower, log;
+
+    static Block& createBlock(
+        ContentBuilder& builder,
+        const std::string& name,
+        const std::string& texture
+    ) {
+        auto& block = builder.blocks.create(name);
+        block.defaults.textureFaces.fill(texture);
+        block.pickingItem = CORE_EMPTY;
+        return block;
+    }
+
+    static int groundLevel(int x, int z) {
+        return 64 + std::sin(x * 0.15f) * 3.0f + std::cos(z * 0.2f) * 3.0f +
+               std::sin((x + z) * 0.05f) * 6.0f;
+    }
+
+    void SetUp() override {
+        ContentBuilder builder;
+        corecontent::setup(nullptr, builder);
+        createBlock(builder, "base:stone", "stone");
+        createBlock(builder, "base:dirt", "dirt");
+        {
+            auto& block = createBlock(builder, "base:grass", "grass_side");
+            block.defaults.textureFaces[2] = "dirt";
+            block.defaults.textureFaces[3] = "grass_top";
+        }
+        {
+            auto& block = createBlock(builder, "base:glass", "glass");
+            block.lightPassing = true;
+            block.skyLightPassing = true;
+            block.defaults.drawGroup = 2;
+        }
+        {
+            auto& block = createBlock(builder, "base:log", "log_side");
+            block.defaults.textureFaces[2] = "log_top";
+            block.defaults.textureFaces[3] = "log_top";
+            block.rotatable = true;
+            block.rotations = BlockRotProfile::PIPE;
+        }
+        {
+            auto& block = createBlock(builder, "base:flower", "flower");
+            block.lightPassing = true;
+            block.skyLightPassing = true;
+            block.obstacle = false;
+            block.defaults.drawGroup = 1;
+            block.defaults.model.type = BlockModelType::XSPRITE;
+        }
+        content = builder.build();
+        const auto& blocks = content->blocks;
+        stone = blocks.require("base:stone").rt.id;
+        dirt = blocks.require("base:dirt").rt.id;
+        grass = blocks.require("base:grass").rt.id;
+        glass = blocks.require("base:glass").rt.id;
+        flower = blocks.require("base:flower").rt.id;
+        log = blocks.require("base:log").rt.id;
+
+        std::unordered_map<std::string, UVRegion> regions;
+        float u = 0.0f;
+        for (const auto& name : {TEXTURE_NOTFOUND, std::string("stone"),
+                                 std::string("dirt"), std::string("grass_side"),
+                                 std::string("grass_top"), std::string("glass"),
+                                 std::string("flower"), std::string("log_side"),
+                                 std::string("log_top")}) {
+            float size = 64.0f / ATLAS_SIZE;
+            regions[name] = UVRegion(u, size, u + size, size * 2);
+            u += size;
+        }
+        assets.store(
+            std::make_unique<Atlas>(nullptr, regions, false), "blocks"
+        );
+        cache = std::make_unique<ContentGfxCache>(
+            *content, assets, settings.graphics
+        );
+        generate();
+    }
+
+    void generate() {
+        chunks = std::make_unique<Chunks>(
+            WORLD_SIZE, WORLD_SIZE, 0, 0, nullptr, *content->getIndices()
+        );
+        chunks->setCenter(WORLD_SIZE * CHUNK_W / 2, WORLD_SIZE * CHUNK_D / 2);
+        for (int cz = 0; cz < WORLD_SIZE; cz++) {
+            for (int cx = 0; cx < WORLD_SIZE; cx++) {
+                auto chunk = std::make_shared<Chunk>(
+                    cx, cz, std::make_shared<Lightmap>()
+                );
+                for (int z = 0; z < CHUNK_D; z++) {
+                    for (int x = 0; x < CHUNK_W; x++) {
+                        int gx = cx * CHUNK_W + x;
+                        int gz = cz * CHUNK_D + z;
+                        int height = groundLevel(gx, gz);
+                        for (int y = 0; y < height; y++) {
+                            blockid_t id = y < height - 3 ? stone : dirt;
+                            if (y == height - 1) {
+                                id = grass;
+                            }
+                            chunk->voxels[vox_index(x, y, z)].id = id;
+                        }
+                        uint hash = gx * 73856093u ^ gz * 19349663u;
+                        if (hash % 7 == 0) {
+                            chunk->voxels[vox_index(x, height, z)].id =
+                                flower;
+                        } else if (hash % 53 == 0) {
+                            for (int y = height; y < height + 5; y++) {
+                                chunk->voxels[vox_index(x, y, z)].id = glass;
+                            }
+                        } else if (hash % 31 == 0) {
+                            for (int y = height; y < height + 4; y++) {
+                                auto& vox = chunk->voxels[vox_index(x, y, z)];
+                                vox.id = log;
+                                vox.state.rotation = hash / 31 % 6;
+                            }
+                        }
+                    }
+                }
+                chunk->updateHeights();
+                ASSERT_TRUE(chunks->putChunk(chunk));
+            }
+        }
+        Lighting lighting(*content, *chunks);
+        for (const auto& chunk : chunks->getChunks()) {
+            Lighting::prebuildSkyLight(*chunk, *content->getIndices());
+        }
+        for (const auto& chunk : chunks->getChunks()) {
+            lighting.buildSkyLight(chunk->x, chunk->z);
+        }
+        for (const auto& chunk : chunks->getChunks()) {
+            lighting.onChunkLoaded(chunk->x, chunk->z, true);
+        }
+    }
+};
+
+/// @brief Texture coordinates and light of a unit face cell
+struct FaceCell {
+    glm::vec2 uv;
+    glm::vec4 color;
+};
+
+/// @brief Key is {index buffer, normal axis, doubled plane coordinate,
+/// cell coordinates on the plane}
+using Coverage = std::map<std::array<int, 5>, FaceCell>;
+
+static const ChunkVertex& base_vertex(const ChunkVertex& vertex) {
+    return vertex;
+}
+
+static const ChunkVertex& base_vertex(const TiledChunkVertex& vertex) {
+    return vertex.vertex;
+}
+
+static std::array<uint16_t, 2> tile_size(const ChunkVertex&) {
+    return {};
+}
+
+static std::array<uint16_t, 2> tile_size(const TiledChunkVertex& vertex) {
+    return vertex.tileSize;
+}
+
+/// @return number of vertices of the mesh built in any format
+static size_t vertices_count(const ChunkMeshData& data) {
+    return data.mesh.vertices.size() + data.tiledMesh.vertices.size();
+}
+
+/// @brief Rasterise axis-aligned triangles of the mesh to unit cells
+/// sampled at centers, tiled texture coordinates are resolved to atlas ones
+/// the same way as main shader does
+/// @return number of triangles not aligned to axes
+template <typename Vertex>
+static size_t rasterise(const MeshData<Vertex>& mesh, Coverage& coverage) {
+    const auto& vertices = mesh.vertices;
+    size_t unaligned = 0;
+    for (int buffer = 0; buffer < mesh.indices.size(); buffer++) {
+        const auto& indices = mesh.indices[buffer];
+        for (size_t t = 0; t < indices.size(); t += 3) {
+            const Vertex* tiled[3] {
+                &vertices[indices[t]],
+                &vertices[indices[t + 1]],
+                &vertices[indices[t + 2]]};
+            const ChunkVertex* tri[3] {
+                &base_vertex(*tiled[0]),
+                &base_vertex(*tiled[1]),
+                &base_vertex(*tiled[2])};
+            int axis = -1;
+            for (int a = 0; a < 3; a++) {
+                if (tri[0]->position[a] == tri[1]->position[a] &&
+                    tri[0]->position[a] == tri[2]->position[a]) {
+                    axis = a;
+                }
+            }
+            if (axis == -1) {
+                unaligned++;
+                continue;
+            }
+            int axisU = (axis + 1) % 3;
+            int axisV = (axis + 2) % 3;
+            glm::vec2 p[3];
+            for (int i = 0; i < 3; i++) {
+                p[i] = {tri[i]->position[axisU], tri[i]->position[axisV]};
+            }
+            float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) -
+                         (p[2].x - p[0].x) * (p[1].y - p[0].y);
+            if (std::abs(area) < 1e-6f) {
+                continue;
+            }
+            auto min = glm::ceil(glm::min(p[0], glm::min(p[1], p[2])));
+            auto max = glm::floor(glm::max(p[0], glm::max(p[1], p[2])));
+            for (int v = min.y; v <= max.y; v++) {
+                for (int u = min.x; u <= max.x; u++) {
+                    glm::vec2 c(u, v);
+                    float w[3] {
+                        ((p[1].x - c.x) * (p[2].y - c.y) -
+                         (p[2].x - c.x) * (p[1].y - c.y)) / area,
+                        ((p[2].x - c.x) * (p[0].y - c.y) -
+                         (p[0].x - c.x) * (p[2].y - c.y)) / area,
+                        0.0f};
+                    w[2] = 1.0f - w[0] - w[1];
+                    if (w[0] < -1e-4f || w[1] < -1e-4f || w[2] < -1e-4f) {
+                        continue;
+                    }
+                    FaceCell cell {};
+                    for (int i = 0; i < 3; i++) {
+                        cell.uv += tri[i]->uv * w[i];
+                        cell.color += glm::vec4(
+                            tri[i]->color[0], tri[i]->color[1],
+                            tri[i]->color[2], tri[i]->color[3]
+                        ) * w[i];
+                    }
+                    // the last vertex is the provoking one
+                    auto tileSize = tile_size(*tiled[2]);
+                    if (tileSize[0] != 0) {
+                        glm::vec2 origin = tri[2]->uv;
+                        glm::vec2 size =
+                            glm::round(
+                                glm::vec2(tileSize[0], tileSize[1]) / 65535.0f *
+                                static_cast<float>(ATLAS_SIZE)
+                            ) /
+                            static_cast<float>(ATLAS_SIZE);
+                        cell.uv = origin +
+                                  glm::fract((cell.uv - origin) / size) * size;
+                    }
+                    int plane = std::round(tri[0]->position[axis] * 2.0f);
+                    coverage.try_emplace({buffer, axis, plane, u, v}, cell);
+                }
+            }
+        }
+    }
+    return unaligned;
+}
+
+static size_t rasterise(const ChunkMeshData& data, Coverage& coverage) {
+    return rasterise(data.mesh, coverage) +
+           rasterise(data.tiledMesh, coverage);
+}
+
+TEST_F(BlocksRendererTest, GreedyCoverage) {
+    BlocksRenderer renderer(
+        settings.graphics.chunkMaxVertices.get(), *content, *cache, settings
+    );
+    for (bool softLighting : {true, false}) {
+        settings.graphics.softLighting.set(softLighting);
+        size_t regularVertices = 0;
+        size_t greedyVertices = 0;
+        for (const auto& chunk : chunks->getChunks()) {
+            Coverage expected;
+            Coverage actual;
+            settings.graphics.greedyMeshing.set(false);
+            renderer.build(chunk.get(), chunks.get());
+            auto regular = renderer.createMesh();
+            size_t expectedUnaligned = rasterise(regular, expected);
+            // regular meshes keep the vertex format without tiling
+            EXPECT_EQ(0, regular.tiledMesh.vertices.size());
+            regularVertices += regular.mesh.vertices.size();
+
+            settings.graphics.greedyMeshing.set(true);
+            renderer.build(chunk.get(), chunks.get());
+            auto greedy = renderer.createMesh();
+            EXPECT_EQ(expectedUnaligned, rasterise(greedy, actual));
+            EXPECT_EQ(0, greedy.mesh.vertices.size());
+            greedyVertices += greedy.tiledMesh.vertices.size();
+
+            ASSERT_EQ(expected.size(), actual.size());
+            for (const auto& [key, cell] : expected) {
+                auto found = actual.find(key);
+                ASSERT_NE(found, actual.end());
+                EXPECT_NEAR(cell.uv.x, found->second.uv.x, 1e-4f);
+                EXPECT_NEAR(cell.uv.y, found->second.uv.y, 1e-4f);
+                for (int i = 0; i < 4; i++) {
+                    EXPECT_NEAR(cell.color[i], found->second.color[i], 1e-2f);
+                }
+            }
+        }
+        EXPECT_LT(greedyVertices, regularVertices);
+    }
+}
+
+TEST_F(BlocksRendererTest, Sections) {
+    BlocksRenderer renderer(
+        settings.graphics.chunkMaxVertices.get(), *content, *cache, settings
+    );
+    for (const auto& chunk : chunks->getChunks()) {
+        Coverage expected;
+        Coverage actual;
+        renderer.build(chunk.get(), chunks.get());
+        auto whole = renderer.createMesh();
+        rasterise(whole, expected);
+
+        auto data = renderer.buildSections(
+            chunk.get(), chunks.get(), CHUNK_SECTIONS_ALL
+        );
+        ASSERT_EQ(CHUNK_SECTIONS_ALL, data.sections);
+        size_t vertices = 0;
+        for (const auto& section : data.meshes) {
+            rasterise(section, actual);
+            vertices += vertices_count(section);
+        }
+        EXPECT_EQ(vertices_count(whole), vertices);
+        ASSERT_EQ(expected.size(), actual.size());
+        for (const auto& [key, cell] : expected) {
+            auto found = actual.find(key);
+            ASSERT_NE(found, actual.end());
+            EXPECT_EQ(cell.uv, found->second.uv);
+            EXPECT_EQ(cell.color, found->second.color);
+        }
+
+        // section of a block placed on the surface
+        uint16_t sections = Chunk::getSectionsAround(chunk->top);
+        data = renderer.buildSections(chunk.get(), chunks.get(), sections);
+        EXPECT_EQ(sections, data.sections);
+    }
+}
+
+TEST_F(BlocksRendererTest, Build) {
+    BlocksRenderer renderer(
+        settings.graphics.chunkMaxVertices.get(), *content, *cache, settings
+    );
+    for (bool greedyMeshing : {false, true}) {
+        settings.graphics.greedyMeshing.set(greedyMeshing);
+        for (const auto& chunk : chunks->getChunks()) {
+            renderer.build(chunk.get(), chunks.get());
+            ASSERT_FALSE(renderer.isCancelled());
+            auto data = renderer.createMesh();
+            EXPECT_GT(vertices_count(data), 0);
+            const auto& indices = greedyMeshing ? data.tiledMesh.indices
+                                                : data.mesh.indices;
+            EXPECT_FALSE(indices.empty());
+            for (const auto& buffer : indices) {
+                EXPECT_EQ(0, buffer.size() % 3);
+            }
+        }
+    }
+}
+
+TEST_F(BlocksRendererTest, DISABLED_Benchmark) {
+    const int passes = 5;
+    BlocksRenderer renderer(
+        settings.graphics.chunkMaxVertices.get(), *content, *cache, settings
+    );
+    for (bool greedyMeshing : {false, true}) {
+        settings.graphics.greedyMeshing.set(greedyMeshing);
+        size_t vertices = 0;
+        size_t indices = 0;
+        size_t sortingEntries = 0;
+        const auto& list = chunks->getChunks();
+        timeutil::Timer timer;
+        for (int pass = 0; pass < passes; pass++) {
+            for (const auto& chunk : list) {
+                renderer.build(chunk.get(), chunks.get());
+                ASSERT_FALSE(renderer.isCancelled());
+                auto data = renderer.createMesh();
+                vertices += vertices_count(data);
+                for (const auto& buffer : greedyMeshing
+                                              ? data.tiledMesh.indices
+                                              : data.mesh.indices) {
+                    indices += buffer.size();
+                }
+                sortingEntries += data.sortingMesh.entries.size();
+            }
+        }
+        auto time = timer.stop();
+        EXPECT_GT(vertices, 0);
+        EXPECT_EQ(0, indices % 3);
+
+        size_t meshed = list.size() * passes;
+        size_t vertexSize =
+            greedyMeshing ? sizeof(TiledChunkVertex) : sizeof(ChunkVertex);
+        std::cout << (greedyMeshing ? "greedy" : "regular") << ", "
+                  << meshed << " chunks meshed: "
+                  << time / 1000.0 / meshed << " ms per chunk, "
+                  << vertices / meshed << " vertices ("
+                  << vertices / meshed * vertexSize << " B), "
+                  << indices / meshed << " indices, "
+                  << sortingEntries / meshed << " sorting entries per chunk, "
+                  << "renderer memory " << renderer.getMemoryConsumption()
+                  << " B" << std::endl;
+    }
+}
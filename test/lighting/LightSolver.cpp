@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "content/Content.hpp"
+#include "lighting/LightSolver.hpp"
+#include "lighting/Lightmap.hpp"
+#include "util/timeutil.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+
+static constexpr int GROUND_LEVEL = 64;
+static constexpr blockid_t STONE = 1;
+static constexpr blockid_t LAMP = 2;
+
+class LightSolverTest : public ::testing::Test {
+protected:
+    Block air {"core:air"};
+    Block stone {"base:stone"};
+    Block lamp {"base:lamp"};
+    std::unique_ptr<ContentIndices> indices;
+    std::unique_ptr<Chunks> chunks;
+
+    void SetUp() override {
+        air.lightPassing = true;
+        lamp.emission[0] = 15;
+        indices = std::make_unique<ContentIndices>(
+            ContentUnitIndices<Block>({&air, &stone, &lamp}),
+            ContentUnitIndices<ItemDef>({}),
+            ContentUnitIndices<EntityDef>({})
+        );
+        chunks = std::make_unique<Chunks>(4, 4, 0, 0, nullptr, *indices);
+        chunks->setCenter(0, 0);
+        for (int cz = -2; cz < 2; cz++) {
+            for (int cx = -2; cx < 2; cx++) {
+                auto chunk = std::make_shared<Chunk>(
+                    cx, cz, std::make_shared<Lightmap>()
+                );
+                for (int i = 0; i < CHUNK_W * CHUNK_D * GROUND_LEVEL; i++) {
+                    chunk->voxels[i].id = STONE;
+                }
+                chunk->updateHeights();
+                ASSERT_TRUE(chunks->putChunk(chunk));
+            }
+        }
+    }
+
+    void setBlock(LightSolver& solver, int x, int y, int z, blockid_t id) {
+        chunks->get(x, y, z)->id = id;
+        if (id == LAMP) {
+            solver.add(x, y, z, 15);
+        } else {
+            solver.remove(x, y, z);
+        }
+        solver.solve();
+    }
+
+    std::vector<glm::ivec3> generateLamps(int count) {
+        std::mt19937 random(0);
+        std::vector<glm::ivec3> lamps;
+        for (int i = 0; i < count; i++) {
+            lamps.emplace_back(
+                static_cast<int>(random() % (CHUNK_W * 4)) - CHUNK_W * 2,
+                GROUND_LEVEL + random() % 32,
+                static_cast<int>(random() % (CHUNK_D * 4)) - CHUNK_D * 2
+            );
+        }
+        return lamps;
+    }
+
+    void expectDark() {
+        for (const auto& chunk : chunks->getChunks()) {
+            for (int i = 0; i < CHUNK_VOL; i++) {
+                ASSERT_EQ(0, chunk->lightmap->getChannel(i, 0));
+            }
+        }
+    }
+};
+
+TEST_F(LightSolverTest, AddRemove) {
+    LightSolver solver(*indices, *chunks, 0);
+    int y = GROUND_LEVEL + 10;
+    // at the chunks border
+    setBlock(solver, -1, y, 0, LAMP);
+    for (int d = 0; d < 15; d++) {
+        EXPECT_EQ(15 - d, chunks->getLight(-1 + d, y, 0, 0));
+        EXPECT_EQ(15 - d, chunks->getLight(-1 - d, y, 0, 0));
+        EXPECT_EQ(15 - d, chunks->getLight(-1, y, d, 0));
+        EXPECT_EQ(15 - d, chunks->getLight(-1, y, -d, 0));
+        EXPECT_EQ(15 - d, chunks->getLight(-1, y + d, 0, 0));
+    }
+    EXPECT_EQ(0, chunks->getLight(-1, GROUND_LEVEL - 1, 0, 0));
+
+    setBlock(solver, -1, y, 0, 0);
+    expectDark();
+}
+
+TEST_F(LightSolverTest, ManyLamps) {
+    LightSolver solver(*indices, *chunks, 0);
+    auto lamps = generateLamps(40);
+    for (const auto& pos : lamps) {
+        setBlock(solver, pos.x, pos.y, pos.z, LAMP);
+    }
+    for (const auto& pos : lamps) {
+        EXPECT_EQ(15, chunks->getLight(pos.x, pos.y, pos.z, 0));
+    }
+    for (const auto& pos : lamps) {
+        setBlock(solver, pos.x, pos.y, pos.z, 0);
+    }
+    expectDark();
+}
+
+TEST_F(LightSolverTest, DISABLED_Benchmark) {
+    const int lampsCount = 400;
+    LightSolver solver(*indices, *chunks, 0);
+    auto lamps = generateLamps(lampsCount);
+    timeutil::Timer addTimer;
+    for (const auto& pos : lamps) {
+        setBlock(solver, pos.x, pos.y, pos.z, LAMP);
+    }
+    auto addTime = addTimer.stop();
+
+    timeutil::Timer removeTimer;
+    for (const auto& pos : lamps) {
+        setBlock(solver, pos.x, pos.y, pos.z, 0);
+    }
+    auto removeTime = removeTimer.stop();
+    expectDark();
+
+    std::cout << lampsCount << " lamps: add " << addTime << " mcs, remove "
+              << removeTime << " mcs" << std::endl;
+}
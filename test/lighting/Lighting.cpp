@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <memory>
+#include <random>
+
+#include "content/Content.hpp"
+#include "content/ContentPack.hpp"
+#include "items/ItemDef.hpp"
+#include "lighting/Lighting.hpp"
+#include "lighting/Lightmap.hpp"
+#include "objects/EntityDef.hpp"
+#include "objects/rigging.hpp"
+#include "util/timeutil.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+#include "voxels/blocks_agent.hpp"
+#include "world/generator/GeneratorDef.hpp"
+#include "world/generator/VoxelFragment.hpp"
+
+static constexpr int GROUND_LEVEL = 64;
+static constexpr blockid_t STONE = 1;
+static constexpr blockid_t LAMP = 2;
+
+class LightingTest : public ::testing::Test {
+protected:
+    Block air {"core:air"};
+    Block stone {"base:stone"};
+    Block lamp {"base:lamp"};
+    ResourceIndicesSet resourceIndices;
+    std::unique_ptr<Content> content;
+
+    struct World {
+        std::unique_ptr<Chunks> chunks;
+        std::unique_ptr<Lighting> lighting;
+    };
+
+    void SetUp() override {
+        air.lightPassing = true;
+        air.skyLightPassing = true;
+        lamp.emission[0] = 15;
+        lamp.rt.emissive = true;
+        content = std::make_unique<Content>(
+            std::make_unique<ContentIndices>(
+                ContentUnitIndices<Block>({&air, &stone, &lamp}),
+                ContentUnitIndices<ItemDef>({}),
+                ContentUnitIndices<EntityDef>({})
+            ),
+            nullptr,
+            ContentUnitDefs<Block>({}),
+            ContentUnitDefs<ItemDef>({}),
+            ContentUnitDefs<EntityDef>({}),
+            ContentUnitDefs<GeneratorDef>({}),
+            UptrsMap<std::string, ContentPackRuntime> {},
+            UptrsMap<std::string, BlockMaterial> {},
+            UptrsMap<std::string, rigging::SkeletonConfig> {},
+            resourceIndices,
+            dv::value(),
+            std::unordered_map<std::string, int> {}
+        );
+    }
+
+    World createWorld() {
+        World world;
+        world.chunks = std::make_unique<Chunks>(
+            4, 4, 0, 0, nullptr, *content->getIndices()
+        );
+        world.chunks->setCenter(0, 0);
+        for (int cz = -2; cz < 2; cz++) {
+            for (int cx = -2; cx < 2; cx++) {
+                auto chunk = std::make_shared<Chunk>(
+                    cx, cz, std::make_shared<Lightmap>()
+                );
+                for (int i = 0; i < CHUNK_W * CHUNK_D * GROUND_LEVEL; i++) {
+                    chunk->voxels[i].id = STONE;
+                }
+                chunk->updateHeights();
+                world.chunks->putChunk(chunk);
+            }
+        }
+        world.lighting = std::make_unique<Lighting>(*content, *world.chunks);
+        build(world);
+        return world;
+    }
+
+    /// @brief Build lights of all chunks from scratch
+    void build(World& world) {
+        const auto& chunks = world.chunks->getChunks();
+        world.lighting->clear();
+        for (const auto& chunk : chunks) {
+            Lighting::prebuildSkyLight(*chunk, *content->getIndices());
+        }
+        for (const auto& chunk : chunks) {
+            world.lighting->buildSkyLight(chunk->x, chunk->z);
+        }
+        for (const auto& chunk : chunks) {
+            world.lighting->onChunkLoaded(chunk->x, chunk->z, true);
+        }
+    }
+};
+
+TEST_F(LightingTest, BlocksSet) {
+    auto world = createWorld();
+    auto expected = createWorld();
+    std::mt19937 random(0);
+    for (int i = 0; i < 20; i++) {
+        glm::ivec3 origin(
+            static_cast<int>(random() % 40) - 20,
+            GROUND_LEVEL - 3 + random() % 6,
+            static_cast<int>(random() % 40) - 20
+        );
+        glm::ivec3 size(1 + random() % 7, 1 + random() % 6, 1 + random() % 7);
+        for (int y = 0; y < size.y; y++) {
+            for (int z = 0; z < size.z; z++) {
+                for (int x = 0; x < size.x; x++) {
+                    int value = random() % 10;
+                    blockid_t id = value < 5 ? STONE : (value < 6 ? LAMP : 0);
+                    glm::ivec3 pos = origin + glm::ivec3(x, y, z);
+                    blocks_agent::set(
+                        *world.chunks, pos.x, pos.y, pos.z, id, {}
+                    );
+                    blocks_agent::set(
+                        *expected.chunks, pos.x, pos.y, pos.z, id, {}
+                    );
+                }
+            }
+        }
+        world.lighting->onBlocksSet(
+            origin.x, origin.y, origin.z, size.x, size.y, size.z
+        );
+        build(expected);
+
+        const auto& chunks = world.chunks->getChunks();
+        const auto& expectedChunks = expected.chunks->getChunks();
+        for (size_t c = 0; c < chunks.size(); c++) {
+            for (int index = 0; index < CHUNK_VOL; index++) {
+                ASSERT_EQ(
+                    expectedChunks[c]->lightmap->map[index],
+                    chunks[c]->lightmap->map[index]
+                );
+            }
+        }
+    }
+}
+
+TEST_F(LightingTest, DISABLED_BlocksSetBenchmark) {
+    auto batched = createWorld();
+    auto perBlock = createWorld();
+    std::mt19937 random(0);
+    glm::ivec3 origin(-12, GROUND_LEVEL - 4, -12);
+    glm::ivec3 size(24, 16, 24);
+    std::vector<std::pair<glm::ivec3, blockid_t>> blocks;
+    for (int y = 0; y < size.y; y++) {
+        for (int z = 0; z < size.z; z++) {
+            for (int x = 0; x < size.x; x++) {
+                int value = random() % 10;
+                blocks.emplace_back(
+                    origin + glm::ivec3(x, y, z),
+                    value < 5 ? STONE : (value < 6 ? LAMP : 0)
+                );
+            }
+        }
+    }
+    for (const auto& [pos, id] : blocks) {
+        blocks_agent::set(*batched.chunks, pos.x, pos.y, pos.z, id, {});
+    }
+    timeutil::Timer batchedTimer;
+    batched.lighting->onBlocksSet(
+        origin.x, origin.y, origin.z, size.x, size.y, size.z
+    );
+    auto batchedTime = batchedTimer.stop();
+
+    timeutil::Timer perBlockTimer;
+    for (const auto& [pos, id] : blocks) {
+        blocks_agent::set(*perBlock.chunks, pos.x, pos.y, pos.z, id, {});
+        perBlock.lighting->onBlockSet(pos.x, pos.y, pos.z, id);
+    }
+    auto perBlockTime = perBlockTimer.stop();
+
+    std::cout << blocks.size() << " blocks: batched " << batchedTime
+              << " mcs, per block " << perBlockTime << " mcs" << std::endl;
+}
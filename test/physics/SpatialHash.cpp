@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+#include "physics/SpatialHash.hpp"
+#include "util/timeutil.hpp"
+
+#include <glm/gtx/norm.hpp>
+
+static std::vector<glm::vec3> generate_points(size_t count, float range) {
+    std::mt19937 random(count);
+    std::uniform_real_distribution<float> dist(-range, range);
+    std::vector<glm::vec3> points;
+    for (size_t i = 0; i < count; i++) {
+        points.emplace_back(dist(random), dist(random) * 0.1f, dist(random));
+    }
+    return points;
+}
+
+static std::vector<size_t> query_radius(
+    const SpatialHash<size_t>& grid,
+    const std::vector<glm::vec3>& points,
+    const glm::vec3& center,
+    float radius
+) {
+    std::vector<size_t> found;
+    grid.query(center - radius, center + radius, [&](size_t index) {
+        if (glm::distance2(points[index], center) <= radius * radius) {
+            found.push_back(index);
+        }
+    });
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+TEST(SpatialHash, Points) {
+    auto points = generate_points(2000, 100.0f);
+    SpatialHash<size_t> grid(8.0f);
+    for (size_t i = 0; i < points.size(); i++) {
+        grid.set(i, points[i]);
+    }
+    // move a half of points
+    for (size_t i = 0; i < points.size(); i += 2) {
+        points[i] += glm::vec3(13.0f, 0.0f, -7.0f);
+        grid.set(i, points[i]);
+    }
+    grid.remove(1);
+    points[1] = glm::vec3(1e9f);
+
+    std::mt19937 random(0);
+    for (int i = 0; i < 100; i++) {
+        glm::vec3 center = points[random() % points.size()];
+        float radius = 1.0f + random() % 40;
+        std::vector<size_t> expected;
+        for (size_t j = 0; j < points.size(); j++) {
+            if (glm::distance2(points[j], center) <= radius * radius) {
+                expected.push_back(j);
+            }
+        }
+        EXPECT_EQ(expected, query_radius(grid, points, center, radius));
+    }
+}
+
+TEST(SpatialHash, Boxes) {
+    SpatialHash<size_t> grid(8.0f);
+    grid.insert(0, glm::vec3(-1.0f), glm::vec3(1.0f));
+    grid.insert(1, glm::vec3(20.0f), glm::vec3(30.0f));
+    grid.insert(2, glm::vec3(-1000.0f), glm::vec3(1000.0f));
+
+    std::vector<size_t> found;
+    grid.query(glm::vec3(21.0f), glm::vec3(22.0f), [&](size_t index) {
+        found.push_back(index);
+    });
+    std::sort(found.begin(), found.end());
+    EXPECT_EQ(std::vector<size_t>({1, 2}), found);
+}
+
+TEST(SpatialHash, RadiusQueries) {
+    auto points = generate_points(500, 100.0f);
+    SpatialHash<size_t> grid(8.0f);
+    for (size_t i = 0; i < points.size(); i++) {
+        grid.set(i, points[i]);
+    }
+    const float radius = 5.0f;
+    for (const auto& center : points) {
+        std::vector<size_t> expected;
+        for (size_t i = 0; i < points.size(); i++) {
+            if (glm::distance2(points[i], center) <= radius * radius) {
+                expected.push_back(i);
+            }
+        }
+        EXPECT_EQ(expected, query_radius(grid, points, center, radius));
+    }
+}
+
+TEST(SpatialHash, DISABLED_Benchmark) {
+    for (size_t count : {500, 2000, 8000}) {
+        // constant density
+        auto points = generate_points(count, std::sqrt(count) * 4.0f);
+        SpatialHash<size_t> grid(8.0f);
+        for (size_t i = 0; i < count; i++) {
+            grid.set(i, points[i]);
+        }
+        const float radius = 5.0f;
+        size_t gridFound = 0;
+        timeutil::Timer gridTimer;
+        for (const auto& center : points) {
+            gridFound += query_radius(grid, points, center, radius).size();
+        }
+        auto gridTime = gridTimer.stop();
+
+        size_t linearFound = 0;
+        timeutil::Timer linearTimer;
+        for (const auto& center : points) {
+            for (const auto& point : points) {
+                linearFound += glm::distance2(point, center) <= radius * radius;
+            }
+        }
+        auto linearTime = linearTimer.stop();
+        EXPECT_EQ(linearFound, gridFound);
+
+        std::cout << count << " entities radius queries: linear "
+                  << linearTime << " mcs, grid " << gridTime << " mcs"
+                  << std::endl;
+    }
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "util/JobSystem.hpp"
+#include "util/ThreadPool.hpp"
+
+using namespace util;
+
+class HoldingWorker : public Worker<int, int> {
+    std::atomic<bool>& started;
+    std::atomic<bool>& released;
+public:
+    HoldingWorker(std::atomic<bool>& started, std::atomic<bool>& released)
+        : started(started), released(released) {
+    }
+
+    int operator()(const int& job) override {
+        started = true;
+        while (!released) {
+            std::this_thread::yield();
+        }
+        return job;
+    }
+};
+
+TEST(ThreadPool, PrioritiesAndCancellation) {
+    std::atomic<bool> started = false;
+    std::atomic<bool> released = false;
+    std::vector<int> order;
+    ThreadPool<int, int> pool(
+        "test-pool",
+        [&]() { return std::make_shared<HoldingWorker>(started, released); },
+        [&](int& result) { order.push_back(result); },
+        1
+    );
+    // the only worker is busy while the rest jobs are queued
+    pool.enqueueJob(0);
+    while (!started) {
+        std::this_thread::yield();
+    }
+    pool.enqueueJob(1);
+    pool.enqueueJob(2, 5);
+    pool.enqueueJob(3, 1);
+    pool.enqueueJob(4, 5);
+    pool.enqueueJob(5, -1);
+    EXPECT_EQ(1, pool.cancelJobs([](const int& job) { return job == 3; }));
+
+    pool.setOnComplete([]() {});
+    released = true;
+    pool.waitForEnd();
+    EXPECT_EQ(std::vector<int>({0, 2, 4, 1, 5}), order);
+}
+
+TEST(JobSystem, Parallel) {
+    auto& jobSystem = JobSystem::getInstance();
+    std::vector<std::atomic<int>> calls(1000);
+    jobSystem.parallel(calls.size(), [&](size_t i) {
+        // nested loops are run by worker threads too
+        jobSystem.parallel(4, [&](size_t) { calls[i]++; });
+    });
+    for (const auto& count : calls) {
+        EXPECT_EQ(4, count);
+    }
+    EXPECT_THROW(
+        jobSystem.parallel(
+            16,
+            [](size_t i) {
+                if (i == 7) {
+                    throw std::runtime_error("failed");
+                }
+            }
+        ),
+        std::runtime_error
+    );
+}
+
+TEST(JobSystem, ParallelBeforePosted) {
+    JobSystem jobSystem(1);
+    std::atomic<bool> released = false;
+    std::atomic<int> postedDone = 0;
+    jobSystem.post([&]() {
+        while (!released) {
+            std::this_thread::yield();
+        }
+    });
+    for (int i = 0; i < 3; i++) {
+        jobSystem.post([&]() { postedDone++; });
+    }
+    std::atomic<bool> helped = false;
+    int postedBeforeHelper = -1;
+    jobSystem.parallel(2, [&](size_t i) {
+        if (i == 0) {
+            // index 1 is left to the helper run by the worker thread
+            released = true;
+            while (!helped) {
+                std::this_thread::yield();
+            }
+        } else {
+            postedBeforeHelper = postedDone;
+            helped = true;
+        }
+    });
+    EXPECT_EQ(0, postedBeforeHelper);
+}
@@ -0,0 +1,29 @@
+#include <gtest/gtest.h>
+#include <string>
+
+#include "util/flat_hash_map.hpp"
+
+using namespace util;
+
+TEST(util, flat_hash_map) {
+    flat_hash_map<int, std::string> map;
+    ASSERT_EQ(nullptr, map.find(5));
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_TRUE(map.try_emplace(i * 7, std::to_string(i)).second);
+    }
+    ASSERT_FALSE(map.try_emplace(7, "test").second);
+    ASSERT_EQ(1000, map.size());
+    for (int i = 0; i < 1000; i++) {
+        auto value = map.find(i * 7);
+        ASSERT_NE(nullptr, value);
+        ASSERT_EQ(std::to_string(i), *value);
+        ASSERT_FALSE(map.contains(i * 7 + 1));
+    }
+    size_t capacity = map.capacity();
+    map.clear();
+    ASSERT_TRUE(map.empty());
+    ASSERT_FALSE(map.contains(7));
+    map[7] = "test";
+    ASSERT_EQ("test", *map.find(7));
+    ASSERT_EQ(capacity, map.capacity());
+}
@@ -23,3 +23,29 @@ TEST(Chunk, EncodeDecode) {
         );
     }
 }
+
+TEST(Chunk, SectionsMask) {
+    Chunk chunk(0, 0);
+    chunk.voxels[vox_index(3, 20, 5)].id = 1;
+    chunk.voxels[vox_index(0, 100, 15)].id = 2;
+    // air voxel with state in a section out of the mask
+    chunk.voxels[vox_index(7, 2, 7)].state.rotation = 3;
+    chunk.updateHeights();
+
+    EXPECT_EQ(chunk.bottom, 20);
+    EXPECT_EQ(chunk.top, 101);
+    EXPECT_EQ(chunk.sectionsMask.load(), (1 << 1) | (1 << 6));
+    EXPECT_TRUE(chunk.isSectionEmpty(0));
+    EXPECT_FALSE(chunk.isSectionEmpty(1));
+
+    auto bytes = chunk.encode();
+    Chunk decoded(0, 0);
+    decoded.decode(bytes.get());
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        EXPECT_EQ(chunk.voxels[i].id, decoded.voxels[i].id);
+        EXPECT_EQ(
+            blockstate2int(chunk.voxels[i].state),
+            blockstate2int(decoded.voxels[i].state)
+        );
+    }
+}
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+#include "content/Content.hpp"
+#include "util/timeutil.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/GlobalChunks.hpp"
+#include "voxels/Pathfinding.hpp"
+#include "voxels/blocks_agent.hpp"
+
+static constexpr int WORLD_SIZE = 8;
+static constexpr blockid_t STONE = 1;
+
+using namespace voxels;
+
+class PathfindingTest : public ::testing::Test {
+protected:
+    Block air {"core:air"};
+    Block stone {"base:stone"};
+    std::unique_ptr<ContentIndices> indices;
+    std::unique_ptr<GlobalChunks> chunks;
+
+    static int groundLevel(int x, int z) {
+        return 64 + std::sin(x * 0.15f) * 3.0f + std::cos(z * 0.2f) * 3.0f +
+               std::sin((x + z) * 0.05f) * 6.0f;
+    }
+
+    void SetUp() override {
+        air.obstacle = false;
+        indices = std::make_unique<ContentIndices>(
+            ContentUnitIndices<Block>({&air, &stone}),
+            ContentUnitIndices<ItemDef>({}),
+            ContentUnitIndices<EntityDef>({})
+        );
+        chunks = std::make_unique<GlobalChunks>(*indices);
+        for (int cz = 0; cz < WORLD_SIZE; cz++) {
+            for (int cx = 0; cx < WORLD_SIZE; cx++) {
+                auto chunk = std::make_shared<Chunk>(cx, cz);
+                for (int z = 0; z < CHUNK_D; z++) {
+                    for (int x = 0; x < CHUNK_W; x++) {
+                        int height =
+                            groundLevel(cx * CHUNK_W + x, cz * CHUNK_D + z);
+                        for (int y = 0; y < height; y++) {
+                            chunk->voxels[vox_index(x, y, z)].id = STONE;
+                        }
+                    }
+                }
+                chunk->updateHeights();
+                chunks->putChunk(chunk);
+            }
+        }
+    }
+
+    glm::ivec3 surface(int x, int z) const {
+        return {x, groundLevel(x, z), z};
+    }
+
+    void setBlock(int x, int y, int z, blockid_t id) {
+        auto chunk = chunks->getChunk(
+            floordiv<CHUNK_W>(x), floordiv<CHUNK_D>(z)
+        );
+        int lx = x - chunk->x * CHUNK_W;
+        int lz = z - chunk->z * CHUNK_D;
+        chunk->voxels[vox_index(lx, y, lz)].id = id;
+        chunk->setModifiedAndUnsaved();
+    }
+
+    bool isObstacle(const glm::ivec3& pos) const {
+        return blocks_agent::get(*chunks, pos.x, pos.y, pos.z)->id == STONE;
+    }
+
+    /// @brief Check route is continuous and goes over the surface
+    void expectValidRoute(const Route& route, const glm::ivec3& target) {
+        ASSERT_TRUE(route.found);
+        ASSERT_GE(route.nodes.size(), 2);
+        EXPECT_EQ(target, route.nodes.front().pos);
+        for (size_t i = 0; i + 1 < route.nodes.size(); i++) {
+            const auto& a = route.nodes[i].pos;
+            const auto& b = route.nodes[i + 1].pos;
+            EXPECT_LE(glm::abs(a.x - b.x), 1);
+            EXPECT_LE(glm::abs(a.y - b.y), 1);
+            EXPECT_LE(glm::abs(a.z - b.z), 1);
+            EXPECT_FALSE(isObstacle(a)) << a.x << " " << a.y << " " << a.z;
+            EXPECT_TRUE(isObstacle(a - glm::ivec3(0, 1, 0)));
+        }
+    }
+};
+
+TEST_F(PathfindingTest, Hierarchical) {
+    Pathfinding pathfinding(*chunks, indices->blocks);
+    Agent agent;
+    agent.hierarchical = true;
+    agent.maxVisitedBlocks = 1e5;
+    agent.start = surface(3, 5);
+    agent.target = surface(WORLD_SIZE * CHUNK_W - 4, WORLD_SIZE * CHUNK_D - 6);
+    expectValidRoute(pathfinding.perform(agent), agent.target);
+
+    // wall across the world with a passage near to the border
+    int wallZ = WORLD_SIZE * CHUNK_D / 2 + 3;
+    for (int x = 2; x < WORLD_SIZE * CHUNK_W; x++) {
+        for (int y = 0; y < 100; y++) {
+            setBlock(x, y, wallZ, STONE);
+        }
+    }
+    expectValidRoute(pathfinding.perform(agent), agent.target);
+}
+
+TEST_F(PathfindingTest, PlainAndHierarchical) {
+    Pathfinding pathfinding(*chunks, indices->blocks);
+    for (bool hierarchical : {false, true}) {
+        Agent agent;
+        agent.hierarchical = hierarchical;
+        agent.maxVisitedBlocks = 1e5;
+        for (int i = 0; i < 4; i++) {
+            int offset = i * 7;
+            agent.start = surface(1 + offset, 2);
+            agent.target = surface(
+                WORLD_SIZE * CHUNK_W - 2, WORLD_SIZE * CHUNK_D - 2 - offset
+            );
+            agent.state.reset();
+            expectValidRoute(pathfinding.perform(agent), agent.target);
+        }
+    }
+}
+
+TEST_F(PathfindingTest, DISABLED_Benchmark) {
+    Pathfinding pathfinding(*chunks, indices->blocks);
+    const int routes = 50;
+    for (bool hierarchical : {false, true}) {
+        Agent agent;
+        agent.hierarchical = hierarchical;
+        agent.maxVisitedBlocks = 1e5;
+        int visited = 0;
+        timeutil::Timer timer;
+        for (int i = 0; i < routes; i++) {
+            int offset = i % (CHUNK_W * 2);
+            agent.start = surface(1 + offset, 2);
+            agent.target = surface(
+                WORLD_SIZE * CHUNK_W - 2, WORLD_SIZE * CHUNK_D - 2 - offset
+            );
+            agent.state.reset();
+            auto route = pathfinding.perform(agent);
+            ASSERT_TRUE(route.found);
+            ASSERT_EQ(agent.target, route.nodes.front().pos);
+            visited += route.totalVisited;
+        }
+        std::cout << (hierarchical ? "hierarchical" : "plain") << ": "
+                  << timer.stop() / 1000 / routes << " ms per route, "
+                  << visited / routes << " positions visited per route"
+                  << std::endl;
+    }
+}
+
+TEST_F(PathfindingTest, PerformAllAsync) {
+    Pathfinding pathfinding(*chunks, indices->blocks);
+    const int agentsCount = 64;
+    std::vector<int> agents;
+    for (int i = 0; i < agentsCount; i++) {
+        int id = pathfinding.createAgent();
+        auto& agent = *pathfinding.getAgent(id);
+        agent.hierarchical = i % 2;
+        agent.maxVisitedBlocks = 1e5;
+        agent.start = surface(1 + i % CHUNK_W, 2 + i / CHUNK_W);
+        agent.target = surface(
+            WORLD_SIZE * CHUNK_W - 2 - i, WORLD_SIZE * CHUNK_D - 2 - i % 7
+        );
+        pathfinding.perform(agent, 0);
+        agents.push_back(id);
+    }
+    pathfinding.performAllAsync(1e6);
+
+    for (int id : agents) {
+        auto& agent = *pathfinding.getAgent(id);
+        ASSERT_TRUE(agent.state.finished);
+        auto route = agent.route;
+        agent.state.reset();
+        auto expected = pathfinding.perform(agent);
+        ASSERT_EQ(expected.nodes.size(), route.nodes.size());
+        for (size_t i = 0; i < route.nodes.size(); i++) {
+            EXPECT_EQ(expected.nodes[i].pos, route.nodes[i].pos);
+        }
+    }
+}
+
+TEST_F(PathfindingTest, DISABLED_NodesPerSecond) {
+    Pathfinding pathfinding(*chunks, indices->blocks);
+    Agent agent;
+    agent.maxVisitedBlocks = 1e5;
+    int64_t visited = 0;
+    timeutil::Timer timer;
+    for (int i = 0; i < 100; i++) {
+        agent.start = surface(2 + i % 10, 2);
+        agent.target = surface(WORLD_SIZE * CHUNK_W - 3 - i % 20, 60);
+        agent.state.reset();
+        visited += pathfinding.perform(agent).totalVisited;
+    }
+    auto time = timer.stop();
+    std::cout << visited * 1000000 / time << " nodes per second" << std::endl;
+}
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "io/io.hpp"
+#include "io/devices/StdfsDevice.hpp"
+#include "util/timeutil.hpp"
+#include "world/files/WorldRegions.hpp"
+
+namespace fs = std::filesystem;
+
+static void write_test_region(
+    RegionsLayer& layer, int regionX = 0, int regionZ = 0
+) {
+    io::set_device(
+        "regtest",
+        std::make_shared<io::StdfsDevice>(
+            fs::temp_directory_path() / "voxelcore-regions-test"
+        )
+    );
+    layer.folder = "regtest:regions";
+    io::create_directories(layer.folder);
+
+    WorldRegion region;
+    for (uint z = 0; z < REGION_SIZE; z++) {
+        for (uint x = 0; x < REGION_SIZE; x++) {
+            if ((x + z) % 7 == 0) {
+                continue;
+            }
+            uint32_t size = 4096 + (x * 31 + z * 17) % 4096;
+            auto data = std::make_unique<ubyte[]>(size);
+            for (uint32_t i = 0; i < size; i++) {
+                data[i] = rand();
+            }
+            region.put(
+                x, z, std::move(data), size, size, compression::Method::NONE
+            );
+        }
+    }
+    layer.writeRegion(regionX, regionZ, &region);
+}
+
+TEST(WorldRegions, MemoryMappedRead) {
+    RegionsLayer layer {};
+    write_test_region(layer);
+    auto filename = layer.getRegionFilePath(0, 0);
+
+    regfile streamFile(filename, false);
+    regfile mappedFile(filename, true);
+    EXPECT_EQ(mappedFile.version, streamFile.version);
+
+    for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        uint32_t size1 = 0, srcSize1 = 0;
+        uint32_t size2 = 0, srcSize2 = 0;
+        auto expected = streamFile.read(i, size1, srcSize1);
+        std::unique_ptr<ubyte[]> storage;
+        auto view = mappedFile.view(i, size2, srcSize2, storage);
+        if (expected == nullptr) {
+            EXPECT_EQ(view, nullptr);
+            continue;
+        }
+        ASSERT_NE(view, nullptr);
+        EXPECT_EQ(storage, nullptr);
+        EXPECT_EQ(size1, size2);
+        EXPECT_EQ(srcSize1, srcSize2);
+        EXPECT_EQ(std::memcmp(expected.get(), view, size1), 0);
+    }
+    io::remove(filename);
+}
+
+TEST(WorldRegions, DISABLED_MemoryMappedReadBenchmark) {
+    RegionsLayer layer {};
+    write_test_region(layer);
+    auto filename = layer.getRegionFilePath(0, 0);
+    const int iterations = 20;
+
+    size_t streamChecksum = 0;
+    timeutil::Timer streamTimer;
+    for (int n = 0; n < iterations; n++) {
+        regfile file(filename, false);
+        for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+            uint32_t size, srcSize;
+            if (auto data = file.read(i, size, srcSize)) {
+                streamChecksum += data[size / 2];
+            }
+        }
+    }
+    auto streamTime = streamTimer.stop();
+
+    size_t mappedChecksum = 0;
+    timeutil::Timer mappedTimer;
+    for (int n = 0; n < iterations; n++) {
+        regfile file(filename, true);
+        for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+            uint32_t size, srcSize;
+            std::unique_ptr<ubyte[]> storage;
+            if (auto data = file.view(i, size, srcSize, storage)) {
+                mappedChecksum += data[size / 2];
+            }
+        }
+    }
+    auto mappedTime = mappedTimer.stop();
+
+    EXPECT_EQ(streamChecksum, mappedChecksum);
+    std::cout << "stream: " << streamTime << " mcs, mapped: " << mappedTime
+              << " mcs (" << iterations << " region reads)" << std::endl;
+    io::remove(filename);
+}
+
+TEST(WorldRegions, PrefetchedRegionsLimit) {
+    RegionsLayer layer {};
+    const int count = MAX_PREFETCHED_REGIONS + 2;
+    for (int i = 0; i < count; i++) {
+        write_test_region(layer, i, 0);
+        layer.readRegion(i, 0);
+    }
+    ASSERT_EQ(layer.prefetched.size(), MAX_PREFETCHED_REGIONS);
+    // least recently read regions are discarded
+    EXPECT_EQ(layer.prefetched.front().first, glm::ivec2(2, 0));
+
+    int regionX = count - 1;
+    for (uint z = 0; z < REGION_SIZE; z++) {
+        for (uint x = 0; x < REGION_SIZE; x++) {
+            uint32_t size, srcSize;
+            compression::Method method;
+            auto data = layer.getData(
+                regionX * REGION_SIZE + x, z, size, srcSize, method
+            );
+            EXPECT_EQ(data == nullptr, (x + z) % 7 == 0);
+        }
+    }
+    // consumed region is removed
+    EXPECT_EQ(layer.prefetched.size(), MAX_PREFETCHED_REGIONS - 1);
+    for (int i = 0; i < count; i++) {
+        io::remove(layer.getRegionFilePath(i, 0));
+    }
+}
+
+TEST(WorldRegions, RegionRecompression) {
+    RegionsLayer layer {};
+    write_test_region(layer);
+    auto filename = layer.getRegionFilePath(0, 0);
+    std::vector<std::unique_ptr<ubyte[]>> expected(REGION_CHUNKS_COUNT);
+    {
+        regfile file(filename, false);
+        for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+            uint32_t size, srcSize;
+            expected[i] = file.read(i, size, srcSize);
+        }
+    }
+    // empty region takes all chunks from the file
+    layer.compression = compression::Method::LZ4;
+    WorldRegion region;
+    layer.writeRegion(0, 0, &region);
+
+    regfile file(filename, false);
+    EXPECT_EQ(static_cast<int>(REGION_FORMAT_VERSION), file.version);
+    EXPECT_EQ(compression::Method::LZ4, file.compression);
+    for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        uint32_t size, srcSize;
+        auto data = file.read(i, size, srcSize);
+        if (expected[i] == nullptr) {
+            EXPECT_EQ(data, nullptr);
+            continue;
+        }
+        ASSERT_NE(data, nullptr);
+        auto decompressed = compression::decompress(
+            data.get(), size, srcSize, compression::Method::LZ4
+        );
+        EXPECT_EQ(
+            0, std::memcmp(expected[i].get(), decompressed.get(), srcSize)
+        );
+    }
+    io::remove(filename);
+}
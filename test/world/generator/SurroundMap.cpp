@@ -9,13 +9,13 @@ TEST(SurroundMap, InitTest) {
     int y = 0;
     int8_t maxLevel = 5;
 
-    SurroundMap map(maxLevelZone, maxLevel);
+    SurroundMap map(maxLevel);
     std::atomic_int affected = 0;
 
     map.setLevelCallback(1, [&affected](auto, auto) {
         affected++;
     });
-    map.setCenter(0, 0);
+    map.setArea(1, 0, 0, maxLevelZone);
     map.completeAt(x, y);
     EXPECT_EQ(affected, (maxLevel * 2 - 1) * (maxLevel * 2 - 1));
 
@@ -31,6 +31,39 @@ TEST(SurroundMap, InitTest) {
     EXPECT_EQ(affected, maxLevel * 2 - 1);
 }
 
+TEST(SurroundMap, SharedAreas) {
+    int8_t maxLevel = 3;
+    int radius = 4;
+    int side = (radius + maxLevel) * 2 + 1;
+
+    SurroundMap map(maxLevel);
+    int removed = 0;
+    map.setOutCallback([&removed](auto, auto, auto) {
+        removed++;
+    });
+    map.setArea(1, 0, 0, radius);
+    map.setArea(2, 2, 0, radius);
+    EXPECT_EQ(map.size(), side * (side + 2));
+
+    map.completeAt(1, 0);
+    EXPECT_EQ(map.at(1, 0), maxLevel);
+
+    // points are still covered by the second area
+    map.removeArea(1);
+    EXPECT_EQ(removed, 0);
+    EXPECT_EQ(map.at(1, 0), maxLevel);
+    EXPECT_THROW(map.completeAt(-side / 2, 0), std::invalid_argument);
+
+    // moving area away releases all upgraded points
+    map.setArea(2, 100, 100, radius);
+    EXPECT_EQ(removed, (maxLevel * 2 - 1) * (maxLevel * 2 - 1));
+    EXPECT_EQ(map.get(1, 0), 0);
+    EXPECT_EQ(map.size(), side * side);
+
+    map.removeArea(2);
+    EXPECT_EQ(map.size(), 0);
+}
+
 #define VISUAL_TEST
 #ifdef VISUAL_TEST
 
@@ -39,18 +72,17 @@ TEST(SurroundMap, InitTest) {
 #include "coders/png.hpp"
 #include "graphics/core/ImageData.hpp"
 
-void visualize(const SurroundMap& map, int mul, int max) {
-    const auto& areaMap = map.getArea();
-    int w = areaMap.getWidth();
-    int h = areaMap.getHeight();
-    int ox = areaMap.getOffsetX();
-    int oy = areaMap.getOffsetY();
+void visualize(const SurroundMap& map, int radius, int mul, int max) {
+    int w = (radius + map.getMaxLevel()) * 2 + 1;
+    int h = w;
+    int ox = -w / 2;
+    int oy = -h / 2;
     
     ImageData image(ImageFormat::rgb888, w, h);
     ubyte* bytes = image.getData();
     for (int y = 0; y < h; y++) {
         for (int x = 0; x < w; x++) {
-            int val = areaMap.get(x + ox, y + oy) * mul;
+            int val = map.get(x + ox, y + oy) * mul;
             if (val && val / mul < max) {
                 val = val / 4 + 50;
             }
@@ -64,15 +96,15 @@ void visualize(const SurroundMap& map, int mul, int max) {
 
 TEST(SurroundMap, Visualize) {
     int levels = 3;
-    SurroundMap map(50, levels);
-    map.setCenter(0, 0);
+    SurroundMap map(levels);
+    map.setArea(1, 0, 0, 50);
     
     for (int i = 0; i < 1000; i++) {
         float x = glm::gaussRand(0.0f, 2.0f);
         float y = glm::gaussRand(0.0f, 2.0f);
         map.completeAt(x, y);
     }
-    visualize(map, 30, levels);
+    visualize(map, 50, 30, levels);
 }
 
 #endif